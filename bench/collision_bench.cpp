@@ -0,0 +1,111 @@
+// Bullet-vs-target collision benchmarks.
+// Compares testing every bullet against every target, the way
+// the bullet hit pass used to, with rebuilding a SpatialHash
+// of the targets and querying the cells around each bullet.
+
+#include "spatial_hash.hpp"
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double elapsed_ms(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    const float hit_radius = 20.0f;
+
+    std::vector<sf::Vector2f> scatter(int count, const sf::Vector2f &world, std::mt19937 &rng)
+    {
+        std::uniform_real_distribution<float> x(0.0f, world.x);
+        std::uniform_real_distribution<float> y(0.0f, world.y);
+        std::vector<sf::Vector2f> points(count);
+        for (sf::Vector2f &point : points)
+        {
+            point = {x(rng), y(rng)};
+        }
+        return points;
+    }
+
+    void run(int bullet_count, int target_count, const sf::Vector2f &world, int frames)
+    {
+        std::mt19937 rng(1234);
+        const std::vector<sf::Vector2f> bullets = scatter(bullet_count, world, rng);
+        const std::vector<sf::Vector2f> targets = scatter(target_count, world, rng);
+
+        // Every pair, with the sqrt distance the old check used.
+        long long brute_hits = 0;
+        auto start = Clock::now();
+        for (int f = 0; f < frames; ++f)
+        {
+            for (const sf::Vector2f &bullet : bullets)
+            {
+                for (const sf::Vector2f &target : targets)
+                {
+                    const sf::Vector2f diff = bullet - target;
+                    if (std::sqrt(diff.x * diff.x + diff.y * diff.y) < hit_radius)
+                    {
+                        ++brute_hits;
+                        break;
+                    }
+                }
+            }
+        }
+        const double brute_ms = elapsed_ms(start) / frames;
+
+        // Rebuilt every frame, as the scene does.
+        SpatialHash grid;
+        long long grid_hits = 0;
+        start = Clock::now();
+        for (int f = 0; f < frames; ++f)
+        {
+            grid.clear();
+            for (int i = 0; i < target_count; ++i)
+            {
+                grid.insert(EntityHandle::make(i, 1), targets[i]);
+            }
+            grid.build();
+
+            for (const sf::Vector2f &bullet : bullets)
+            {
+                grid.query_radius(bullet, hit_radius, [&](EntityHandle, const sf::Vector2f &) {
+                    ++grid_hits;
+                    return false;
+                });
+            }
+        }
+        const double grid_ms = elapsed_ms(start) / frames;
+
+        std::cout << std::setw(8) << bullet_count
+                  << std::setw(8) << target_count
+                  << std::setw(14) << brute_ms
+                  << std::setw(14) << grid_ms
+                  << std::setw(12) << brute_hits / frames
+                  << std::setw(12) << grid_hits / frames << "\n";
+    }
+}
+
+int main()
+{
+    const int frames = 10;
+    const sf::Vector2f world(4000.0f, 2000.0f);
+
+    std::cout << "Bullet collision (" << frames << " frames, "
+              << world.x << "x" << world.y << " world, " << hit_radius << "px hit radius)\n";
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << std::setw(8) << "bullets" << std::setw(8) << "targets"
+              << std::setw(14) << "all pairs ms" << std::setw(14) << "grid ms"
+              << std::setw(12) << "pair hits" << std::setw(12) << "grid hits" << "\n";
+
+    run(100, 50, world, frames);
+    run(1000, 100, world, frames);
+    run(10000, 1000, world, frames);
+
+    return 0;
+}
@@ -0,0 +1,158 @@
+// Entity/component storage benchmarks.
+// Compares the per-entity shared_ptr layout against pooled component storage,
+// and erase-in-place removal against the deferred swap-and-pop flush.
+
+#include "ecm.hpp"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+    class MoveComponent : public Component
+    {
+    public:
+        explicit MoveComponent(Entity *p) : Component(p) {}
+        void update(const float &dt) override { m_parent->set_position(m_parent->get_position() + m_velocity * dt); }
+        void render() override {}
+    private:
+        sf::Vector2f m_velocity{10.0f, 5.0f};
+    };
+
+    class SpinComponent : public Component
+    {
+    public:
+        explicit SpinComponent(Entity *p) : Component(p) {}
+        void update(const float &dt) override { m_parent->set_rotation(m_parent->get_rotation() + 90.0f * dt); }
+        void render() override {}
+    };
+
+    class TimerComponent : public Component
+    {
+    public:
+        explicit TimerComponent(Entity *p) : Component(p) {}
+        void update(const float &dt) override { m_elapsed += dt; }
+        void render() override {}
+    private:
+        float m_elapsed = 0.0f;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    double elapsed_ms(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    void run_update(int entity_count, bool pooled, int frames)
+    {
+        EntityManager manager(pooled);
+
+        auto start = Clock::now();
+        for (int i = 0; i < entity_count; ++i)
+        {
+            Entity &entity = manager.create();
+            entity.add_component<MoveComponent>();
+            entity.add_component<SpinComponent>();
+            entity.add_component<TimerComponent>();
+        }
+        manager.flush();
+        double create_ms = elapsed_ms(start);
+
+        start = Clock::now();
+        for (int f = 0; f < frames; ++f)
+        {
+            manager.update(PHASE_PRE_PHYSICS, 1.0f / 120.0f);
+        }
+        double update_ms = elapsed_ms(start) / frames;
+
+        std::cout << std::setw(8) << entity_count
+                  << std::setw(10) << (pooled ? "pooled" : "shared")
+                  << std::setw(14) << create_ms
+                  << std::setw(14) << update_ms << "\n";
+    }
+
+    // Kills every entity in a single frame.
+    // The legacy path erases from the middle of the list as it iterates, the
+    // way EntityManager::update used to; the current path queues the kills
+    // and removes them in one flush.
+    void run_kill(int entity_count, bool deferred)
+    {
+        EntityManager manager(true);
+        std::vector<EntityHandle> handles;
+
+        for (int i = 0; i < entity_count; ++i)
+        {
+            Entity &entity = manager.create();
+            entity.add_component<MoveComponent>();
+            entity.add_component<TimerComponent>();
+            handles.push_back(entity.get_handle());
+        }
+        manager.flush();
+
+        for (const std::unique_ptr<Entity> &entity : manager.list)
+        {
+            entity->set_to_delete();
+        }
+
+        auto start = Clock::now();
+        if (deferred)
+        {
+            manager.flush();
+        }
+        else
+        {
+            std::vector<std::unique_ptr<Entity>> legacy;
+            legacy.swap(manager.list);
+            for (std::size_t i = 0; i < legacy.size(); ++i)
+            {
+                if (legacy[i]->to_be_deleted())
+                {
+                    legacy.erase(legacy.begin() + i);
+                    --i;
+                }
+            }
+        }
+        double kill_ms = elapsed_ms(start);
+        manager.clear();
+
+        int stale = 0;
+        for (EntityHandle handle : handles)
+        {
+            stale += manager.resolve(handle) ? 0 : 1;
+        }
+
+        std::cout << std::setw(8) << entity_count
+                  << std::setw(10) << (deferred ? "flush" : "erase")
+                  << std::setw(14) << kill_ms
+                  << std::setw(14) << stale << "\n";
+    }
+}
+
+int main()
+{
+    const int frames = 60;
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Component update (" << frames << " frames, 3 components/entity)\n";
+    std::cout << std::setw(8) << "entities" << std::setw(10) << "layout"
+              << std::setw(14) << "create ms" << std::setw(14) << "ms/frame" << "\n";
+
+    for (int count : {1000, 10000, 100000})
+    {
+        run_update(count, false, frames);
+        run_update(count, true, frames);
+    }
+
+    std::cout << "\nKill every entity in one frame\n";
+    std::cout << std::setw(8) << "entities" << std::setw(10) << "removal"
+              << std::setw(14) << "ms" << std::setw(14) << "stale" << "\n";
+
+    for (int count : {1000, 10000})
+    {
+        run_kill(count, false);
+        run_kill(count, true);
+    }
+
+    return 0;
+}
@@ -0,0 +1,320 @@
+// Level wall collision build benchmarks.
+// Compares the old path, a static body per wall group, found the way
+// LevelSystem::get_groups used to, with a chain of its tile corners sorted
+// by angle around the centroid,
+// with a single static body holding a loop chain per outline from
+// LevelSystem::get_outlines. Runs every level and a synthetic map.
+
+#include "engine_utils.hpp"
+#include "level_system.hpp"
+#include "physics.hpp"
+#include "game_parameters.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double elapsed_ms(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    b2Vec2 to_world(const sf::Vector2f &pos)
+    {
+        return Physics::sv2_to_bv2(Physics::invert_height(pos, params::window_height));
+    }
+
+    void create_chain(b2BodyId body, const std::vector<b2Vec2> &points)
+    {
+        b2ChainDef chain_def = b2DefaultChainDef();
+        chain_def.count = static_cast<int>(points.size());
+        chain_def.points = points.data();
+        chain_def.isLoop = true;
+        b2CreateChain(body, &chain_def);
+    }
+
+    // As LevelSystem::in_group was: it only ever compared the first tile.
+    bool legacy_in_group(const sf::Vector2i &pos, const std::vector<sf::Vector2i> &group)
+    {
+        return !group.empty() && group.front() == pos;
+    }
+
+    // LevelSystem::get_groups as it was, recursive and quadratic in tiles.
+    void legacy_get_group(LevelSystem::Tile type, const sf::Vector2i &pos, const std::vector<sf::Vector2i> &tile_list,
+                          std::vector<sf::Vector2i> &group, bool vert)
+    {
+        if (legacy_in_group(pos, group)) { return; }
+        group.push_back(pos);
+
+        auto neighbour = [&](int x, int y)
+        {
+            return legacy_in_group({x, y}, tile_list) ? LevelSystem::get_tile({x, y}) : LevelSystem::EMPTY;
+        };
+        const LevelSystem::Tile n[8] =
+        {
+            neighbour(pos.x - 1, pos.y - 1), neighbour(pos.x, pos.y - 1),
+            neighbour(pos.x + 1, pos.y - 1), neighbour(pos.x + 1, pos.y),
+            neighbour(pos.x + 1, pos.y + 1), neighbour(pos.x, pos.y + 1),
+            neighbour(pos.x - 1, pos.y + 1), neighbour(pos.x - 1, pos.y)
+        };
+        const bool sides = n[3] == n[4] && n[7] == n[6] && n[3] == n[2] && n[7] == n[0];
+
+        if (n[3] == type) { legacy_get_group(type, {pos.x + 1, pos.y}, tile_list, group, sides); }
+        if (n[7] == type) { legacy_get_group(type, {pos.x - 1, pos.y}, tile_list, group, sides); }
+        if (!vert) { return; }
+        if (n[3] == n[4] && n[7] == n[6] && n[5] == type) { legacy_get_group(type, {pos.x, pos.y + 1}, tile_list, group, true); }
+        if (n[3] == n[2] && n[7] == n[0] && n[1] == type) { legacy_get_group(type, {pos.x, pos.y - 1}, tile_list, group, true); }
+    }
+
+    std::vector<std::vector<sf::Vector2i>> legacy_groups(LevelSystem::Tile type)
+    {
+        std::vector<std::vector<sf::Vector2i>> groups;
+        const LevelSystem::TileSpan found = LevelSystem::find_tiles(type);
+        std::vector<sf::Vector2i> tile_list(found.begin(), found.end());
+        while (!tile_list.empty())
+        {
+            std::vector<sf::Vector2i> group;
+            if (tile_list.size() == 1)
+            {
+                group.push_back(tile_list[0]);
+            }
+            else
+            {
+                legacy_get_group(type, tile_list.front(), tile_list, group, true);
+            }
+            groups.push_back(group);
+
+            for (const sf::Vector2i &pos : group)
+            {
+                auto found = std::find(tile_list.begin(), tile_list.end(), pos);
+                if (found != tile_list.end())
+                {
+                    tile_list.erase(found);
+                }
+            }
+        }
+        return groups;
+    }
+
+    // The corners PlatformComponent used to chain for a group, as it found them.
+    std::vector<b2Vec2> group_points(const std::vector<sf::Vector2i> &tile_group)
+    {
+        auto neighbour = [&](int x, int y)
+        {
+            return legacy_in_group({x, y}, tile_group) ? LevelSystem::get_tile({x, y}) : LevelSystem::EMPTY;
+        };
+
+        std::vector<b2Vec2> points;
+        for (const sf::Vector2i &tile : tile_group)
+        {
+            const LevelSystem::Tile n[8] =
+            {
+                neighbour(tile.x - 1, tile.y - 1), neighbour(tile.x, tile.y - 1),
+                neighbour(tile.x + 1, tile.y - 1), neighbour(tile.x + 1, tile.y),
+                neighbour(tile.x + 1, tile.y + 1), neighbour(tile.x, tile.y + 1),
+                neighbour(tile.x - 1, tile.y + 1), neighbour(tile.x - 1, tile.y)
+            };
+
+            const sf::Vector2f pos = LevelSystem::get_tile_pos(tile);
+            std::vector<sf::Vector2f> pts;
+            if (n[0] == LevelSystem::EMPTY || n[1] == LevelSystem::EMPTY || n[7] == LevelSystem::EMPTY)
+                pts.push_back(pos);
+            if (n[1] == LevelSystem::EMPTY || n[2] == LevelSystem::EMPTY || n[3] == LevelSystem::EMPTY)
+                pts.push_back({pos.x + params::tile_size, pos.y});
+            if (n[3] == LevelSystem::EMPTY || n[4] == LevelSystem::EMPTY || n[5] == LevelSystem::EMPTY)
+                pts.push_back({pos.x + params::tile_size, pos.y + params::tile_size});
+            if (n[5] == LevelSystem::EMPTY || n[6] == LevelSystem::EMPTY || n[7] == LevelSystem::EMPTY)
+                pts.push_back({pos.x, pos.y + params::tile_size});
+
+            for (const sf::Vector2f &pt : pts)
+            {
+                const b2Vec2 point = to_world(pt);
+                bool already_in = false;
+                for (const b2Vec2 &p : points)
+                {
+                    if (p.x == point.x && p.y == point.y)
+                    {
+                        already_in = true;
+                        break;
+                    }
+                }
+                if (!already_in)
+                {
+                    points.push_back(point);
+                }
+            }
+        }
+
+        b2Vec2 centroid = {0.0f, 0.0f};
+        for (const b2Vec2 &pt : points)
+        {
+            centroid.x += pt.x;
+            centroid.y += pt.y;
+        }
+        centroid.x /= static_cast<float>(points.size());
+        centroid.y /= static_cast<float>(points.size());
+
+        std::sort(points.begin(), points.end(), [&](b2Vec2 a, b2Vec2 b)
+        {
+            a = {a.x - centroid.x, a.y - centroid.y};
+            b = {b.x - centroid.x, b.y - centroid.y};
+            const float angle1 = std::atan2(a.x, a.y);
+            const float angle2 = std::atan2(b.x, b.y);
+            if (angle1 == angle2)
+                return std::sqrt(a.x * a.x + a.y * a.y) > std::sqrt(b.x * b.x + b.y * b.y);
+            return angle1 > angle2;
+        });
+        return points;
+    }
+
+    struct Result
+    {
+        double ms;
+        std::size_t chains;
+        std::size_t points;
+    };
+
+    Result build_groups()
+    {
+        Physics::initialise();
+        Result result{0.0, 0, 0};
+        const auto start = Clock::now();
+
+        b2BodyDef body_def = b2DefaultBodyDef();
+        body_def.type = b2_staticBody;
+        for (const std::vector<sf::Vector2i> &group : legacy_groups(LevelSystem::WALL))
+        {
+            const b2BodyId body = b2CreateBody(Physics::get_world_id(), &body_def);
+            const std::vector<b2Vec2> points = group_points(group);
+            create_chain(body, points);
+            ++result.chains;
+            result.points += points.size();
+        }
+
+        result.ms = elapsed_ms(start);
+        Physics::shutdown();
+        return result;
+    }
+
+    Result build_outlines()
+    {
+        Physics::initialise();
+        Result result{0.0, 0, 0};
+        const auto start = Clock::now();
+
+        b2BodyDef body_def = b2DefaultBodyDef();
+        body_def.type = b2_staticBody;
+        const b2BodyId body = b2CreateBody(Physics::get_world_id(), &body_def);
+        std::vector<b2Vec2> points;
+        for (const std::vector<sf::Vector2i> &outline : LevelSystem::get_outlines(LevelSystem::WALL))
+        {
+            points.clear();
+            for (const sf::Vector2i &corner : outline)
+            {
+                points.push_back(to_world(LevelSystem::get_tile_pos(corner)));
+            }
+            create_chain(body, points);
+            ++result.chains;
+            result.points += points.size();
+        }
+
+        result.ms = elapsed_ms(start);
+        Physics::shutdown();
+        return result;
+    }
+
+    void run(const std::string &name, const std::string &path)
+    {
+        LevelSystem::load_level(path, params::tile_size);
+        const Result groups = build_groups();
+        const Result outlines = build_outlines();
+
+        std::cout << std::setw(12) << name
+                  << std::setw(7) << LevelSystem::get_width() << "x" << std::left << std::setw(6) << LevelSystem::get_height() << std::right
+                  << std::setw(12) << groups.ms
+                  << std::setw(10) << groups.chains
+                  << std::setw(10) << groups.points
+                  << std::setw(12) << outlines.ms
+                  << std::setw(10) << outlines.chains
+                  << std::setw(10) << outlines.points
+                  << std::setw(10) << groups.ms / outlines.ms << "x\n";
+    }
+
+    // A walled map of random platforms and pillars, written where the level loader can read it.
+    std::string write_synthetic(int width, int height)
+    {
+        std::mt19937 rng(1234);
+        std::vector<std::string> rows(height, std::string(width, ' '));
+        for (int x = 0; x < width; ++x)
+        {
+            rows[0][x] = 'w';
+            rows[height - 1][x] = 'w';
+        }
+        for (int y = 0; y < height; ++y)
+        {
+            rows[y][0] = 'w';
+            rows[y][width - 1] = 'w';
+        }
+
+        std::uniform_int_distribution<int> pick_x(1, width - 2);
+        std::uniform_int_distribution<int> pick_y(1, height - 2);
+        std::uniform_int_distribution<int> pick_length(3, 20);
+        std::uniform_int_distribution<int> pick_thickness(1, 3);
+        for (int i = 0; i < width * height / 80; ++i)
+        {
+            const int x = pick_x(rng);
+            const int y = pick_y(rng);
+            const bool pillar = rng() % 4 == 0;
+            const int w = pillar ? pick_thickness(rng) : pick_length(rng);
+            const int h = pillar ? pick_length(rng) : pick_thickness(rng);
+            for (int ty = y; ty < std::min(height - 1, y + h); ++ty)
+            {
+                for (int tx = x; tx < std::min(width - 1, x + w); ++tx)
+                {
+                    rows[ty][tx] = 'w';
+                }
+            }
+        }
+        rows[height - 2][1] = 's';
+
+        const std::string path = "synthetic_level.txt";
+        std::ofstream file(path);
+        for (const std::string &row : rows)
+        {
+            file << row << '\n';
+        }
+        return path;
+    }
+}
+
+int main()
+{
+    std::cout << "Level wall collision build (ms to create the static bodies)\n";
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << std::setw(12) << "level" << std::setw(14) << "tiles"
+              << std::setw(12) << "groups ms" << std::setw(10) << "chains" << std::setw(10) << "points"
+              << std::setw(12) << "outline ms" << std::setw(10) << "chains" << std::setw(10) << "points"
+              << std::setw(11) << "speedup" << "\n";
+
+    for (int i = 1; i <= 10; ++i)
+    {
+        const std::string name = "level" + std::to_string(i);
+        run(name, EngineUtils::GetRelativePath("resources/levels/" + name + ".txt"));
+    }
+
+    // The old path is quadratic in wall tiles, so this takes a while.
+    const std::string synthetic = write_synthetic(1000, 1000);
+    run("synthetic", synthetic);
+    std::remove(synthetic.c_str());
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+// Level load benchmark.
+// Compares parsing a text level, then finding its enemy spawn tiles and
+// wall groups, with mapping its compiled copy, where both come ready made.
+// Runs every level and a synthetic map.
+
+#include "engine_utils.hpp"
+#include "level_system.hpp"
+#include "game_parameters.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double elapsed_ms(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // What a level scene asks of a level before its first frame.
+    std::size_t load(const std::string &path, bool compiled)
+    {
+        if (compiled)
+        {
+            LevelSystem::load_compiled_level(path, params::tile_size);
+        }
+        else
+        {
+            LevelSystem::load_text_level(path, params::tile_size);
+        }
+        return LevelSystem::find_tiles(LevelSystem::EMPTY).size() + LevelSystem::get_groups(LevelSystem::WALL).size();
+    }
+
+    double time_loads(const std::string &path, bool compiled, int iterations, std::size_t &check)
+    {
+        const auto start = Clock::now();
+        for (int i = 0; i < iterations; ++i)
+        {
+            check = load(path, compiled);
+        }
+        return elapsed_ms(start) / iterations;
+    }
+
+    void run(const std::string &name, const std::string &path, int iterations)
+    {
+        const std::string compiled = name + "_bench.lvl";
+        LevelSystem::load_text_level(path, params::tile_size);
+        LevelSystem::write_compiled_level(compiled);
+
+        std::size_t text_check = 0;
+        std::size_t compiled_check = 0;
+        const double text_ms = time_loads(path, false, iterations, text_check);
+        const double compiled_ms = time_loads(compiled, true, iterations, compiled_check);
+
+        std::cout << std::setw(12) << name
+                  << std::setw(7) << LevelSystem::get_width() << "x" << std::left << std::setw(6) << LevelSystem::get_height() << std::right
+                  << std::setw(12) << text_ms
+                  << std::setw(14) << compiled_ms
+                  << std::setw(10) << text_ms / compiled_ms << "x"
+                  << (text_check == compiled_check ? "" : "  MISMATCH") << "\n";
+        std::remove(compiled.c_str());
+    }
+
+    // A walled map of random platforms, written where the level loader can read it.
+    std::string write_synthetic(int width, int height)
+    {
+        std::mt19937 rng(1234);
+        std::vector<std::string> rows(height, std::string(width, ' '));
+        for (int x = 0; x < width; ++x)
+        {
+            rows[0][x] = 'w';
+            rows[height - 1][x] = 'w';
+        }
+        for (int y = 0; y < height; ++y)
+        {
+            rows[y][0] = 'w';
+            rows[y][width - 1] = 'w';
+        }
+
+        std::uniform_int_distribution<int> pick_x(1, width - 2);
+        std::uniform_int_distribution<int> pick_y(1, height - 2);
+        std::uniform_int_distribution<int> pick_length(3, 20);
+        for (int i = 0; i < width * height / 80; ++i)
+        {
+            const int x = pick_x(rng);
+            const int y = pick_y(rng);
+            for (int tx = x; tx < std::min(width - 1, x + pick_length(rng)); ++tx)
+            {
+                rows[y][tx] = 'w';
+            }
+        }
+        rows[height - 2][1] = 's';
+
+        const std::string path = "synthetic_level.txt";
+        std::ofstream file(path);
+        for (const std::string &row : rows)
+        {
+            file << row << '\n';
+        }
+        return path;
+    }
+}
+
+int main()
+{
+    std::cout << "Level load, enemy spawns and wall groups (ms per load)\n";
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << std::setw(12) << "level" << std::setw(14) << "tiles"
+              << std::setw(12) << "text ms" << std::setw(14) << "compiled ms"
+              << std::setw(11) << "speedup" << "\n";
+
+    for (int i = 1; i <= 10; ++i)
+    {
+        const std::string name = "level" + std::to_string(i);
+        run(name, EngineUtils::GetRelativePath("resources/levels/" + name + ".txt"), 200);
+    }
+
+    const std::string synthetic = write_synthetic(1000, 1000);
+    run("synthetic", synthetic, 10);
+    std::remove(synthetic.c_str());
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+// World streaming benchmark.
+// Writes a synthetic world far larger than a level, then flies a camera
+// across it, streaming chunks through LevelSystem the way the level scene
+// does. Reports the main thread's time per frame, including building the
+// vertices of newly visible chunks, and how many chunks stay resident
+// against the budget. Pass a path to keep the world for --world.
+
+#include "level_streamer.hpp"
+#include "game_parameters.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double elapsed_ms(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    const int world_width = 8192;
+    const int world_height = 4096;
+
+    // Floors every twelve rows with gaps, pillars between them and a border.
+    LevelSystem::Tile synthetic_tile(int x, int y)
+    {
+        if (x == 0 || y == 0 || x == world_width - 1 || y == world_height - 1)
+        {
+            return LevelSystem::WALL;
+        }
+        const unsigned int hash = (static_cast<unsigned int>(x / 8) * 73856093u) ^ (static_cast<unsigned int>(y / 12) * 19349663u);
+        if (y % 12 == 0 && hash % 4 != 0)
+        {
+            return LevelSystem::WALL;
+        }
+        if (x % 24 == 0 && hash % 5 == 0)
+        {
+            return LevelSystem::WALL;
+        }
+        return LevelSystem::EMPTY;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const bool keep = argc > 1;
+    const std::string path = keep ? argv[1] : "synthetic.world";
+
+    auto start = Clock::now();
+    LevelStreamer::write(path, world_width, world_height, {2, world_height - 2}, synthetic_tile);
+    std::cout << "Wrote a " << world_width << "x" << world_height << " world in "
+              << std::fixed << std::setprecision(1) << elapsed_ms(start) << " ms\n";
+
+    start = Clock::now();
+    LevelSystem::load_world(path, params::tile_size, params::world_chunk_budget);
+    LevelStreamer &streamer = *LevelSystem::get_streamer();
+    std::size_t loaded = 0;
+    std::size_t unloaded = 0;
+    streamer.set_callbacks([&](const LevelStreamer::Chunk &) { ++loaded; },
+                           [&](const LevelStreamer::Chunk &) { ++unloaded; });
+
+    const sf::Vector2f view(params::window_width, params::window_height);
+    sf::Vector2f camera = LevelSystem::get_start_pos();
+    streamer.update(sf::FloatRect(camera - view / 2.0f, view));
+    streamer.wait_for_requests();
+    std::cout << "First chunks in after " << elapsed_ms(start) << " ms\n";
+
+    // Fly right along the world at 60 tiles a second, weaving up and down,
+    // one frame every 60th of a second so the loader runs at its real pace.
+    const int frames = 900;
+    const float speed = 40.0f;
+    const auto frame_time = std::chrono::microseconds(16667);
+    auto next_frame = Clock::now();
+    std::vector<double> frame_ms;
+    std::vector<const sf::VertexArray *> visible;
+    std::size_t peak = 0;
+    std::size_t missing = 0;
+    for (int f = 0; f < frames; ++f)
+    {
+        camera.x = std::min(camera.x + speed, world_width * params::tile_size);
+        camera.y = (0.5f + 0.45f * std::sin(f * 0.01f)) * world_height * params::tile_size;
+        const sf::FloatRect bounds(camera - view / 2.0f, view);
+
+        start = Clock::now();
+        streamer.update(bounds);
+        LevelSystem::get_visible_chunks(bounds, visible);
+        frame_ms.push_back(elapsed_ms(start));
+
+        peak = std::max(peak, streamer.get_resident_count() + streamer.get_pending_count());
+        const sf::Vector2i tile(static_cast<int>(camera.x / params::tile_size), static_cast<int>(camera.y / params::tile_size));
+        if (LevelSystem::get_tile(tile) != synthetic_tile(tile.x, tile.y))
+        {
+            ++missing;  // the loader had not caught up with the camera
+        }
+
+        next_frame += frame_time;
+        std::this_thread::sleep_until(next_frame);
+    }
+
+    std::sort(frame_ms.begin(), frame_ms.end());
+    const std::size_t chunk_tiles = LevelStreamer::default_chunk_size * LevelStreamer::default_chunk_size;
+    std::cout << std::setprecision(3)
+              << "Frames: " << frames << "\n"
+              << "Main thread ms p50 / p99 / max: " << frame_ms[frames / 2] << " / "
+              << frame_ms[frames * 99 / 100] << " / " << frame_ms.back() << "\n"
+              << "Chunks loaded / evicted: " << loaded << " / " << unloaded << "\n"
+              << "Peak chunks resident or on the way: " << peak << " (budget " << params::world_chunk_budget << ")\n"
+              << "Peak tile memory: " << peak * chunk_tiles * sizeof(LevelSystem::Tile) / 1024 << " KiB, against "
+              << static_cast<std::size_t>(world_width) * world_height * sizeof(LevelSystem::Tile) / 1024 << " KiB for the whole grid\n"
+              << "Frames whose centre tile was not in yet: " << missing << "\n";
+
+    LevelSystem::close_world();
+    if (!keep)
+    {
+        std::remove(path.c_str());
+    }
+    return 0;
+}
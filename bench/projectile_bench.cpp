@@ -0,0 +1,120 @@
+// Projectile benchmarks.
+// Compares bullets as entities, each with its own component and shape the
+// way bullets used to be, against the structure-of-arrays ProjectileBuffer:
+// one integrate over plain arrays and one vertex list for the whole lot.
+
+#include "ecm.hpp"
+#include "projectile_buffer.hpp"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+namespace
+{
+    // What a bullet entity did each fixed update.
+    class BulletMoveComponent : public Component
+    {
+    public:
+        BulletMoveComponent(Entity *p, sf::Vector2f velocity) : Component(p), m_velocity(velocity) {}
+        void update(const float &dt) override
+        {
+            m_lifetime -= dt;
+            m_parent->set_position(m_parent->get_position() + m_velocity * dt);
+        }
+        void render() override {}
+    private:
+        sf::Vector2f m_velocity;
+        float m_lifetime = 1000.0f;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    double elapsed_ms(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    sf::Vector2f random_velocity(std::mt19937 &rng)
+    {
+        std::uniform_real_distribution<float> speed(-300.0f, 300.0f);
+        return {speed(rng), speed(rng)};
+    }
+
+    void run(int bullet_count, int frames)
+    {
+        const float dt = 1.0f / 120.0f;
+        const sf::FloatRect everywhere(-1.0e6f, -1.0e6f, 2.0e6f, 2.0e6f);
+
+        // Entities: one update call per bullet, then one drawable per bullet.
+        // Only positioning the drawables is timed; each would still be its own draw call.
+        std::mt19937 rng(1234);
+        EntityManager manager(true);
+        for (int i = 0; i < bullet_count; ++i)
+        {
+            Entity &bullet = manager.create();
+            bullet.add_component<BulletMoveComponent>(random_velocity(rng));
+        }
+        manager.flush();
+
+        std::vector<sf::Transformable> shapes(bullet_count);
+        auto start = Clock::now();
+        for (int f = 0; f < frames; ++f)
+        {
+            manager.save_positions();
+            manager.update(PHASE_PRE_PHYSICS, dt);
+            for (int i = 0; i < bullet_count; ++i)
+            {
+                shapes[i].setPosition(manager.list[i]->get_interpolated_position(0.5f));
+            }
+        }
+        const double entity_ms = elapsed_ms(start) / frames;
+
+        // Buffer: integrate the arrays, then build one vertex list.
+        rng.seed(1234);
+        ProjectileBuffer projectiles;
+        for (int i = 0; i < bullet_count; ++i)
+        {
+            ProjectileBuffer::Spawn bullet;
+            bullet.velocity = random_velocity(rng);
+            bullet.lifetime = 1000.0f;
+            projectiles.spawn(bullet);
+        }
+
+        start = Clock::now();
+        double integrate_ms = 0.0;
+        for (int f = 0; f < frames; ++f)
+        {
+            const Clock::time_point step = Clock::now();
+            projectiles.integrate(dt);
+            integrate_ms += elapsed_ms(step);
+            projectiles.prepare(0.5f, everywhere);
+        }
+        const double buffer_ms = elapsed_ms(start) / frames;
+        integrate_ms /= frames;
+
+        std::cout << std::setw(8) << bullet_count
+                  << std::setw(14) << entity_ms
+                  << std::setw(14) << buffer_ms
+                  << std::setw(14) << integrate_ms
+                  << std::setw(10) << bullet_count << "/1" << "\n";
+    }
+}
+
+int main()
+{
+    const int frames = 120;
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Bullet update and draw prep (" << frames << " frames at 120 Hz)\n";
+    std::cout << std::setw(8) << "bullets" << std::setw(14) << "entity ms"
+              << std::setw(14) << "buffer ms" << std::setw(14) << "integrate ms"
+              << std::setw(12) << "draws" << "\n";
+
+    for (int count : {1000, 10000, 50000})
+    {
+        run(count, frames);
+    }
+
+    return 0;
+}
@@ -0,0 +1,35 @@
+#include "component_storage.hpp"
+
+/// <summary>
+/// Updates every pooled component registered for a phase, one component
+/// type at a time. Each type's updates are one profiler zone.
+/// </summary>
+/// <param name="phase">The phase being run.</param>
+/// <param name="dt">Delta Time - linked to frame rate.</param>
+/// <param name="skip">Component types that are updated elsewhere, e.g. by a System.</param>
+void ComponentStorage::update(FramePhase phase, const float &dt, ComponentMask skip)
+{
+    for (std::unique_ptr<ComponentPoolBase> &pool : m_pools)
+    {
+        if (!(pool->get_phases() & phase_bit(phase)) || (skip & (ComponentMask(1) << pool->get_type_id())))
+        {
+            continue;
+        }
+        PROFILE_ZONE(pool->get_name());
+        pool->update(phase, dt);
+    }
+}
+
+/// <summary>
+/// Gets the number of live components across every pool.
+/// </summary>
+/// <returns>The total component count.</returns>
+std::size_t ComponentStorage::size() const
+{
+    std::size_t total = 0;
+    for (const std::unique_ptr<ComponentPoolBase> &pool : m_pools)
+    {
+        total += pool->size();
+    }
+    return total;
+}
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <array>
+#include <utility>
+#include <vector>
+#include "component_type.hpp"
+#include "frame_phase.hpp"
+#include "profiler.hpp"
+
+class Entity;
+
+// Type-erased view of a ComponentPool so ComponentStorage can hold
+// pools of different component types side by side.
+class ComponentPoolBase
+{
+public:
+    ComponentPoolBase(std::size_t type_id, PhaseMask phases, const char *name)
+        : m_type_id(type_id), m_phases(phases), m_name(name) {}
+    virtual ~ComponentPoolBase() = default;
+    virtual void update(FramePhase phase, const float &dt) = 0;
+    virtual std::size_t size() const = 0;
+    std::size_t get_type_id() const { return m_type_id; }
+    PhaseMask get_phases() const { return m_phases; }
+    // The component type's name, e.g. to profile its updates under.
+    const char *get_name() const { return m_name; }
+private:
+    std::size_t m_type_id;
+    PhaseMask m_phases;     // phases the component type is updated in
+    const char *m_name;
+};
+
+// ComponentPool
+// Stores every component of a single type T in fixed-size blocks of
+// contiguous memory. Blocks are never reallocated, so pointers handed
+// out by create() stay valid until destroy() is called on them.
+template<typename T>
+class ComponentPool : public ComponentPoolBase
+{
+public:
+    static constexpr std::size_t block_size = 256;
+
+    ComponentPool() : ComponentPoolBase(ComponentType::id<T>(), component_phases<T>::value, Profiler::type_name(typeid(T))) {}
+    ComponentPool(const ComponentPool &) = delete;
+    ComponentPool &operator=(const ComponentPool &) = delete;
+
+    ~ComponentPool() override
+    {
+        for (std::size_t i = 0; i < m_high_water; ++i)
+        {
+            if (m_live[i])
+            {
+                slot(i)->~T();
+            }
+        }
+    }
+
+    // Constructs a T in the next free slot and reports which slot it used.
+    template<typename... Targs>
+    T *create(std::size_t &index, Targs&&... params)
+    {
+        // Re-use a freed slot before growing the pool, except mid update,
+        // when a freed slot below the loop's index would run this pass or
+        // not depending on where it is.
+        if (!m_free.empty() && !m_updating)
+        {
+            index = m_free.back();
+            m_free.pop_back();
+        }
+        else
+        {
+            index = m_high_water++;
+            if (index / block_size >= m_blocks.size())
+            {
+                m_blocks.push_back(std::make_unique<Block>());
+                m_live.resize(m_blocks.size() * block_size, 0);
+            }
+        }
+
+        T *component = new (slot(index)) T(std::forward<Targs>(params)...);
+        m_live[index] = 1;
+        ++m_size;
+        return component;
+    }
+
+    void destroy(std::size_t index)
+    {
+        slot(index)->~T();
+        m_live[index] = 0;
+        m_free.push_back(index);
+        --m_size;
+    }
+
+    // Updates every live component of this type in one tight loop.
+    // The call is qualified with T so it is bound statically instead of
+    // going through the vtable for each component.
+    void update(FramePhase phase, const float &dt) override
+    {
+        // Components created during this pass go past count, so they are
+        // picked up next frame.
+        const std::size_t count = m_high_water;
+        const bool was_updating = m_updating;
+        m_updating = true;
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (!m_live[i])
+            {
+                continue;
+            }
+
+            T *component = slot(i);
+            if (component->m_parent->is_alive())
+            {
+                // Types that do not split their work by phase go straight to update().
+                if constexpr (std::is_same<decltype(&T::update_phase), void (Component::*)(FramePhase, const float &)>::value)
+                {
+                    component->T::update(dt);
+                }
+                else
+                {
+                    component->T::update_phase(phase, dt);
+                }
+            }
+        }
+        m_updating = was_updating;
+    }
+
+    std::size_t size() const override { return m_size; }
+
+private:
+    struct Block
+    {
+        alignas(T) unsigned char data[sizeof(T) * block_size];
+    };
+
+    T *slot(std::size_t index) const
+    {
+        return reinterpret_cast<T *>(m_blocks[index / block_size]->data) + (index % block_size);
+    }
+
+    std::vector<std::unique_ptr<Block>> m_blocks;
+    std::vector<std::uint8_t> m_live;
+    std::vector<std::size_t> m_free;
+    std::size_t m_high_water = 0;
+    std::size_t m_size = 0;
+    bool m_updating = false;    // in update(), so create() only appends
+};
+
+// ComponentStorage
+// Optional storage engine for an EntityManager. Each component type gets
+// its own ComponentPool, so components of the same type sit next to each
+// other in memory and can be updated in bulk, one type at a time.
+class ComponentStorage
+{
+public:
+    ComponentStorage() = default;
+    ComponentStorage(const ComponentStorage &) = delete;
+    ComponentStorage &operator=(const ComponentStorage &) = delete;
+
+    // Constructs a component inside its type's pool. The returned pointer
+    // hands the slot back to the pool when the last reference goes away.
+    template<typename T, typename... Targs>
+    std::shared_ptr<T> create(Entity *parent, Targs... params)
+    {
+        ComponentPool<T> &p = pool<T>();
+        std::size_t index;
+        T *component = p.create(index, parent, params...);
+        return std::shared_ptr<T>(component, [&p, index](T *) { p.destroy(index); });
+    }
+
+    // Updates the pools registered for a phase, except the component types in skip.
+    void update(FramePhase phase, const float &dt, ComponentMask skip = 0);
+    std::size_t size() const;
+
+private:
+    template<typename T>
+    ComponentPool<T> &pool()
+    {
+        ComponentPoolBase *&slot = m_by_type[ComponentType::id<T>()];
+        if (slot)
+        {
+            return *static_cast<ComponentPool<T> *>(slot);
+        }
+
+        // Pools are kept in first-use order so bulk updates stay deterministic.
+        m_pools.push_back(std::make_unique<ComponentPool<T>>());
+        slot = m_pools.back().get();
+        return *static_cast<ComponentPool<T> *>(slot);
+    }
+
+    std::vector<std::unique_ptr<ComponentPoolBase>> m_pools;
+    std::array<ComponentPoolBase *, ComponentType::max_types> m_by_type{};  // indexed by type id
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+class Component;
+
+// One bit per registered component type.
+using ComponentMask = std::uint64_t;
+
+// The component a type derives from, as declared by a
+// `using base_component = Parent;` alias inside the class.
+// Types without the alias derive directly from Component.
+template<typename T, typename = void>
+struct component_base
+{
+    using type = Component;
+};
+
+template<typename T>
+struct component_base<T, std::void_t<typename T::base_component>>
+{
+    using type = typename T::base_component;
+};
+
+// ComponentType
+// Hands out a small, dense id for every component type. The id is fixed
+// the first time a type is seen and is cached in a per-type constant, so
+// lookups after that are a plain load.
+class ComponentType
+{
+public:
+    static constexpr std::size_t max_types = 64;
+
+    template<typename T>
+    static std::size_t id()
+    {
+        static_assert(std::is_base_of<Component, T>::value, "T is not a component");
+        static const std::size_t value = next_id();
+        return value;
+    }
+
+    template<typename T>
+    static ComponentMask bit()
+    {
+        return ComponentMask(1) << id<T>();
+    }
+
+    // The bit for T plus the bits of every component it derives from,
+    // so inheritance-aware queries are a single mask test.
+    template<typename T>
+    static ComponentMask ancestor_mask()
+    {
+        using Base = typename component_base<T>::type;
+        static_assert(!std::is_same<Base, T>::value, "base_component must name a parent type");
+        static_assert(std::is_base_of<Base, T>::value, "base_component must be a base of T");
+
+        static const ComponentMask value = bit<T>() | base_mask<Base>(std::is_same<Base, Component>());
+        return value;
+    }
+
+private:
+    static std::size_t next_id();
+
+    template<typename Base>
+    static ComponentMask base_mask(std::true_type) { return 0; }
+
+    template<typename Base>
+    static ComponentMask base_mask(std::false_type) { return ancestor_mask<Base>(); }
+};
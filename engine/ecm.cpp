@@ -1,31 +1,191 @@
 #include "ecm.hpp"
 #include "renderer.hpp"
 #include <iostream>
+#include <stdexcept>
 #include "../src/character_components.hpp"
 
 /// <summary>
-/// Goes through all entities that are to be updated.
-/// Checks if the entities should be deleted, and deletes if yes.
-/// Otherwise, it calls the Entity's update.
+/// Runs one phase over all entities that are to be updated.
+/// Skips entities waiting to be deleted; they are removed by flush().
+/// Otherwise, it calls the Entity's update for the phase.
+/// With pooled storage the components are updated in bulk, type by type.
 /// </summary>
+/// <param name="phase">The phase being run.</param>
 /// <param name="dt">Delta Time - linked to frame rate.</param>
-void EntityManager::update(const float &dt)
+void EntityManager::update(FramePhase phase, const float &dt)
 {
-    for(size_t i = 0; i < list.size(); ++i)
+    // Pooled components skip their own parent if it is not alive.
+    if(pooled)
     {
-        // Erases entities that have been marked to be deleted.
-        if(list[i]->to_be_deleted())
+        storage.update(phase, dt, scheduled);
+        return;
+    }
+
+    for(std::unique_ptr<Entity> &ent : list)
+    {
+        // Updates entities if they are alive and have work in this phase.
+        if(ent->is_alive() && !ent->to_be_deleted() && (ent->m_phase_mask & phase_bit(phase)))
         {
-            list.erase(list.begin() + i);
-            --i;
-            continue;
+            ent->update(phase, dt);
+        }
+    }
+}
+
+/// <summary>
+/// Creates an entity owned by this manager.
+/// It gets a handle straight away but only joins the list on the next flush.
+/// </summary>
+/// <returns>The new entity.</returns>
+Entity &EntityManager::create()
+{
+    std::uint32_t index;
+
+    if(!m_free_slots.empty())
+    {
+        index = m_free_slots.back();
+        m_free_slots.pop_back();
+    }
+    else
+    {
+        if(m_slots.size() > EntityHandle::max_index)
+        {
+            throw std::length_error("Too many entities for EntityHandle.");
+        }
+        index = static_cast<std::uint32_t>(m_slots.size());
+        m_slots.emplace_back();
+    }
+
+    std::unique_ptr<Entity> entity = std::make_unique<Entity>(this);
+    entity->m_handle = EntityHandle::make(index, m_slots[index].generation);
+    m_slots[index].entity = entity.get();
+    m_pending_create.push_back(std::move(entity));
+
+    return *m_pending_create.back();
+}
+
+/// <summary>
+/// Queues an entity to be removed on the next flush.
+/// Stale handles and repeated calls are ignored.
+/// </summary>
+/// <param name="handle">The entity to remove.</param>
+void EntityManager::destroy(EntityHandle handle)
+{
+    if(resolve(handle))
+    {
+        m_pending_destroy.push_back(handle);
+    }
+}
+
+/// <summary>
+/// Applies the queued creations, then the queued destructions.
+/// Destroyed entities are swapped with the last entity and popped, so a
+/// frame with many deaths costs one move per death.
+/// </summary>
+void EntityManager::flush()
+{
+    for(std::unique_ptr<Entity> &ent : m_pending_create)
+    {
+        // New entities are drawn where they were placed, not slid in from the origin.
+        ent->m_previous_position = ent->m_position;
+        Slot &slot = m_slots[ent->m_handle.index()];
+        slot.dense = static_cast<std::uint32_t>(list.size());
+        list.push_back(std::move(ent));
+    }
+    m_pending_create.clear();
+
+    // Entity destructors may destroy further entities; those wait for the next flush.
+    std::vector<EntityHandle> destroying;
+    destroying.swap(m_pending_destroy);
+
+    for(EntityHandle handle : destroying)
+    {
+        if(!resolve(handle))
+        {
+            continue;   // queued twice
         }
-        // Updates entities if they are alive.
-        if(list[i]->is_alive())
+
+        const std::uint32_t dense = m_slots[handle.index()].dense;
+        release_slot(handle.index());
+
+        std::unique_ptr<Entity> removed = std::move(list[dense]);
+        if(dense + 1 != list.size())
+        {
+            list[dense] = std::move(list.back());
+            m_slots[list[dense]->m_handle.index()].dense = dense;
+        }
+        list.pop_back();
+    }
+
+    destroying.clear();
+    if(m_pending_destroy.empty())
+    {
+        m_pending_destroy.swap(destroying);     // keep the buffer's capacity
+    }
+}
+
+/// <summary>
+/// Removes every entity, including ones still waiting to be created.
+/// Every outstanding handle stops resolving.
+/// </summary>
+void EntityManager::clear()
+{
+    for(std::uint32_t i = 0; i < m_slots.size(); ++i)
+    {
+        if(m_slots[i].entity)
         {
-            list[i]->update(dt);
+            release_slot(i);
         }
     }
+
+    m_pending_destroy.clear();
+    m_pending_create.clear();
+    list.clear();
+}
+
+/// <summary>
+/// Records every entity's position as its previous position.
+/// </summary>
+void EntityManager::save_positions()
+{
+    for(std::unique_ptr<Entity> &ent : list)
+    {
+        ent->m_previous_position = ent->m_position;
+    }
+}
+
+/// <summary>
+/// Gets the entity behind a handle.
+/// </summary>
+/// <param name="handle">The handle to resolve.</param>
+/// <returns>The entity, or nullptr if the handle is stale or null.</returns>
+Entity *EntityManager::resolve(EntityHandle handle) const
+{
+    if(handle.is_null() || handle.index() >= m_slots.size())
+    {
+        return nullptr;
+    }
+
+    const Slot &slot = m_slots[handle.index()];
+    return (slot.generation == handle.generation()) ? slot.entity : nullptr;
+}
+
+/// <summary>
+/// Frees a slot and bumps its generation so old handles stop resolving.
+/// A slot on its last generation is retired instead of freed: wrapping back
+/// to 1 would let handles from its first entity resolve again.
+/// </summary>
+/// <param name="index">The slot to free.</param>
+void EntityManager::release_slot(std::uint32_t index)
+{
+    Slot &slot = m_slots[index];
+    slot.entity = nullptr;
+    slot.dense = no_index;
+    if(slot.generation == EntityHandle::max_generation)
+    {
+        return;
+    }
+    ++slot.generation;
+    m_free_slots.push_back(index);
 }
 
 /// <summary>
@@ -33,7 +193,7 @@ void EntityManager::update(const float &dt)
 /// </summary>
 void EntityManager::render()
 {
-    for(std::shared_ptr<Entity> &ent : list)
+    for(std::unique_ptr<Entity> &ent : list)
     {
         if(ent->is_visible() && ent->is_alive())
         {
@@ -42,6 +202,41 @@ void EntityManager::render()
     }
 }
 
+/// <summary>
+/// Renders the visible, alive entities inside the bounds.
+/// Anything out of view is never asked to render.
+/// </summary>
+/// <param name="bounds">World area to render, including a margin.</param>
+void EntityManager::render(const sf::FloatRect &bounds)
+{
+    Renderer::CullStats &stats = Renderer::frame_cull_stats();
+
+    for(std::unique_ptr<Entity> &ent : list)
+    {
+        if(!ent->is_visible() || !ent->is_alive())
+        {
+            continue;
+        }
+
+        if(bounds.contains(ent->get_position()))
+        {
+            ent->render();
+            ++stats.entities_drawn;
+        }
+        else
+        {
+            ++stats.entities_culled;
+        }
+    }
+}
+
+/// <summary>
+/// Creates an entity owned by the given manager.
+/// Its components are allocated from the manager's storage when pooling is on.
+/// </summary>
+/// <param name="manager">The manager that owns the entity.</param>
+Entity::Entity(EntityManager *manager) : m_manager(manager) {}
+
 /// <summary>
 /// Gets the position of the entity.
 /// </summary>
@@ -56,8 +251,62 @@ const sf::Vector2f& Entity::get_position() const
 /// </summary>
 /// <param name="pos">The position to be set.</param>
 void Entity::set_position(const sf::Vector2f &pos)
+{
+    if(pos != m_position)
+    {
+        m_position = pos;
+        ++m_transform_version;
+    }
+}
+
+/// <summary>
+/// Moves the entity and its previous position together, so it is drawn
+/// at the new position straight away instead of sliding there.
+/// </summary>
+/// <param name="pos">The position to jump to.</param>
+void Entity::teleport(const sf::Vector2f &pos)
 {
     m_position = pos;
+    m_previous_position = pos;
+    ++m_transform_version;
+}
+
+/// <summary>
+/// Gets the position of the entity at the start of the latest fixed update.
+/// </summary>
+/// <returns>The previous position.</returns>
+const sf::Vector2f &Entity::get_previous_position() const
+{
+    return m_previous_position;
+}
+
+/// <summary>
+/// Blends the previous and current positions.
+/// </summary>
+/// <param name="alpha">0 gives the previous position, 1 the current one.</param>
+/// <returns>The position to draw the entity at.</returns>
+sf::Vector2f Entity::get_interpolated_position(float alpha) const
+{
+    return m_previous_position + (m_position - m_previous_position) * alpha;
+}
+
+/// <summary>
+/// Gets whether the entity moved in the latest fixed update.
+/// </summary>
+/// <returns>Whether its drawn position changes between updates.</returns>
+bool Entity::is_moving() const
+{
+    return m_position != m_previous_position;
+}
+
+/// <summary>
+/// Gets the transform's version. It goes up whenever the position,
+/// rotation or facing changes.
+/// </summary>
+/// <returns>The version.</returns>
+std::uint32_t Entity::get_transform_version() const
+{
+    return m_transform_version;
 }
 
 /// <summary>
@@ -75,18 +324,31 @@ float Entity::get_rotation() const
 /// <param name="rotation">The input target rotation.</param>
 void Entity::set_rotation(float rotation)
 {
-    m_rotation = rotation;
+    if(rotation != m_rotation)
+    {
+        m_rotation = rotation;
+        ++m_transform_version;
+    }
 }
 
 /// <summary>
-/// Updates all of the components associated with an entity.
+/// Updates the components associated with an entity that are registered
+/// for the phase.
 /// </summary>
+/// <param name="phase">The phase being run.</param>
 /// <param name="dt">Delta Time - Updates certain # of times per second.</param>
-void Entity::update(const float &dt)
+void Entity::update(FramePhase phase, const float &dt)
 {
+    const ComponentMask scheduled = m_manager ? m_manager->scheduled : 0;
+
     for(std::shared_ptr<Component> &comp : m_components)
     {
-        comp->update(dt);
+        // Components driven by a System are updated by the Scheduler instead.
+        if(!(comp->m_phases & phase_bit(phase)) || (scheduled & (ComponentMask(1) << comp->m_type_id)))
+        {
+            continue;
+        }
+        comp->update_phase(phase, dt);
     }
 }
 
@@ -133,9 +395,38 @@ void Entity::set_alive(bool alive)
 /// </summary>
 void Entity::set_to_delete()
 {
+    if(m_for_deletion)
+    {
+        return;
+    }
+
     m_for_deletion = true;
     m_alive = false;
     m_visible = false;
+
+    if(m_manager)
+    {
+        m_manager->destroy(m_handle);
+    }
+}
+
+/// <summary>
+/// Gets the entity's handle in its manager.
+/// </summary>
+/// <returns>The handle, or a null handle if no manager created the entity.</returns>
+EntityHandle Entity::get_handle() const
+{
+    return m_handle;
+}
+
+/// <summary>
+/// Resolves another entity's handle in the manager that owns this entity.
+/// </summary>
+/// <param name="handle">The handle to resolve.</param>
+/// <returns>The entity, or nullptr if it is gone or this entity has no manager.</returns>
+Entity *Entity::resolve(EntityHandle handle) const
+{
+    return m_manager ? m_manager->resolve(handle) : nullptr;
 }
 
 /// <summary>
@@ -158,27 +449,74 @@ void Entity::set_visible(bool visible)
 
 /// <summary>
 /// Deletes the entity.
+/// Components are destroyed newest first in a single pass, so a component
+/// never outlives one added before it that it may depend on.
 /// </summary>
 Entity::~Entity()
 {
-    // Components can depend on each other, so we may need to make multiple
-        // passes. Keep deleting components until we can't delete any more.
+    while(!m_components.empty())
+    {
+        m_components.pop_back();
+    }
+}
 
-    int left_to_delete = 0;
+/// <summary>
+/// Records the component at the given index in the type lookup.
+/// The first component providing a type keeps the slot for it.
+/// </summary>
+/// <param name="index">Index of the component in m_components.</param>
+void Entity::index_component(std::size_t index)
+{
+    ComponentMask new_bits = m_components[index]->m_type_mask & ~m_component_mask;
 
-    while(left_to_delete != m_components.size())
+    for (std::size_t id = 0; new_bits != 0; ++id, new_bits >>= 1)
     {
-        left_to_delete = m_components.size();
+        if (new_bits & 1)
+        {
+            m_slots[id] = static_cast<std::uint8_t>(index);
+        }
+    }
+
+    m_component_mask |= m_components[index]->m_type_mask;
+    m_phase_mask |= m_components[index]->m_phases;
+}
+
+/// <summary>
+/// Rebuilds the type lookup after components have been removed.
+/// </summary>
+void Entity::rebuild_component_index()
+{
+    m_component_mask = 0;
+    m_phase_mask = 0;
+    for (std::size_t i = 0; i < m_components.size(); ++i)
+    {
+        index_component(i);
+    }
+}
+
+/// <summary>
+/// Gets the mask of every component type this entity has, including bases.
+/// </summary>
+/// <returns>The component mask.</returns>
+ComponentMask Entity::get_component_mask() const
+{
+    return m_component_mask;
+}
 
-        // remove the component if it has 1 or less uses - no dependancies
-        m_components.erase(
-            remove_if(m_components.begin(), m_components.end(),
-                        [](auto& ptr) { return (ptr.use_count() <= 1); }),
-            m_components.end()
-        );
+/// <summary>
+/// Hands out the next free component type id.
+/// </summary>
+/// <returns>The new id.</returns>
+std::size_t ComponentType::next_id()
+{
+    static std::size_t counter = 0;
+
+    if (counter >= max_types)
+    {
+        throw std::logic_error("Too many component types for ComponentMask.");
     }
 
-    m_components.clear();
+    return counter++;
 }
 
 Component::Component(Entity* const p) : m_parent(p), m_to_delete(false) {}
@@ -208,5 +546,27 @@ bool Entity::is_facing_right() const
 /// <param name="facing_right">True for right, false for left.</param>
 void Entity::set_facing_right(bool facing_right)
 {
-    m_facing_right = facing_right;
+    if(facing_right != m_facing_right)
+    {
+        m_facing_right = facing_right;
+        ++m_transform_version;
+    }
+}
+
+/// <summary>
+/// Gets the entity's collision layer.
+/// </summary>
+/// <returns>The layer.</returns>
+CollisionLayer Entity::get_layer() const
+{
+    return m_layer;
+}
+
+/// <summary>
+/// Sets the entity's collision layer.
+/// </summary>
+/// <param name="layer">The layer.</param>
+void Entity::set_layer(CollisionLayer layer)
+{
+    m_layer = layer;
 }
\ No newline at end of file
@@ -1,96 +1,89 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <array>
 #include <memory>
 #include <vector>
+#include "component_storage.hpp"
+#include "component_type.hpp"
+#include "entity_handle.hpp"
+#include "frame_phase.hpp"
 
 class Component;
+struct EntityManager;
+
+// Which side an entity is on, for collision filtering. Things that hit
+// entities carry a LayerMask of the layers they hit, so a filter is one AND.
+enum CollisionLayer : std::uint8_t
+{
+    LAYER_NONE = 0,
+    LAYER_PLAYER = 1 << 0,
+    LAYER_ENEMY = 1 << 1,
+    LAYER_PROJECTILE = 1 << 2,
+    LAYER_WORLD = 1 << 3
+};
+using LayerMask = std::uint8_t;
 
 class Entity {
+    friend struct EntityManager;
 public:
     Entity() = default;
+    explicit Entity(EntityManager *manager);
     virtual ~Entity();
 
-    virtual void update(const float &dt);
+    // Updates the components registered for the phase, once each.
+    virtual void update(FramePhase phase, const float &dt);
     virtual void render();
 
+    // Component templates are defined at the bottom of this file, once
+    // EntityManager and Component are complete types.
     template<typename T, typename... Targs>
-    std::shared_ptr<T> add_component(Targs... params)
-    {
-        static_assert(std::is_base_of<Component, T>::value, "T is not a component");
-        std::shared_ptr<T> ptr(std::make_shared<T>(this, params...));
-        
-        m_components.push_back(ptr);
-        
-        return ptr;
-    }
+    std::shared_ptr<T> add_component(Targs... params);
 
+    // Components whose concrete type is exactly T.
     template<typename T>
-    const std::vector<std::shared_ptr<T>> get_components() const
-    {
-        static_assert(std::is_base_of<Component, T>::value, "T is not a component");
-        std::vector<std::shared_ptr<T>> out;
-
-        for (const auto c : m_components)
-        {
-            out.push_back(std::dynamic_pointer_cast<T>(c));
-        }
-    }
+    const std::vector<std::shared_ptr<T>> get_components() const;
 
+    // Components that are T or derive from T.
     template<typename T>
-    const std::vector<std::shared_ptr<T>> get_compatible_components()
-    {
-        static_assert(std::is_base_of<Component, T>::value, "T is not a component");
-        std::vector<std::shared_ptr<T>> out;
+    const std::vector<std::shared_ptr<T>> get_compatible_components() const;
 
-        for(auto component : m_components)
-        {
-            // check if the component is a derivative of T
-            auto dd = dynamic_cast<T*>(&(*component));
-
-            // if the component is a derivative of T
-            if (dd)
-            {
-                out.push_back(std::dynamic_pointer_cast<T>(component));
-            }
-        }
+    // First component that is T or derives from T, or nullptr. No allocation.
+    template<typename T>
+    T *get_component() const;
 
-        return out;
-    }
+    // Whether any component is T or derives from T. A single bit test.
+    template<typename T>
+    bool has_component() const;
 
     //Remove a specific component from this entity
     template<typename T>
-    void remove_component(std::shared_ptr<T> component)
-    {
-        static_assert(std::is_base_of<Component, T>::value, "T is not a component");
-
-        // Find and remove the component
-        m_components.erase(
-            std::remove_if(m_components.begin(), m_components.end(),
-                [&component](std::shared_ptr<Component>& comp) {
-                    return comp == component;
-                }),
-            m_components.end()
-        );
-    }
+    void remove_component(std::shared_ptr<T> component);
 
     // Remove all components of a specific type
     template<typename T>
-    void remove_components_by_type()
-    {
-        static_assert(std::is_base_of<Component, T>::value, "T is not a component");
-
-        m_components.erase(
-            std::remove_if(m_components.begin(), m_components.end(),
-                [](std::shared_ptr<Component>& comp) {
-                    return dynamic_cast<T*>(comp.get()) != nullptr;
-                }),
-            m_components.end()
-        );
-    }
+    void remove_components_by_type();
+
+    ComponentMask get_component_mask() const;
+    EntityHandle get_handle() const;
+
+    // Resolves another entity's handle in this entity's manager.
+    Entity *resolve(EntityHandle handle) const;
 
     const sf::Vector2f &get_position() const;
     void set_position(const sf::Vector2f &position);
+    // Moves without interpolating from the old position, e.g. on spawn.
+    void teleport(const sf::Vector2f &position);
+    // Position at the start of the latest fixed update.
+    const sf::Vector2f &get_previous_position() const;
+    // Blend between the previous and current position for drawing.
+    sf::Vector2f get_interpolated_position(float alpha) const;
+    // Whether the position changed in the latest fixed update.
+    bool is_moving() const;
+    // Goes up whenever the position, rotation or facing changes, so things
+    // that copy the transform, e.g. drawables, only resync when it moves on.
+    std::uint32_t get_transform_version() const;
     bool to_be_deleted() const;
     float get_rotation() const;
     void set_rotation(float rotation);
@@ -104,33 +97,239 @@ public:
     bool is_facing_right() const;
     void set_facing_right(bool facing_right);
 
+    // Collision layer, see CollisionLayer.
+    CollisionLayer get_layer() const;
+    void set_layer(CollisionLayer layer);
+
 protected:
+    EntityManager *m_manager = nullptr;  // owning manager, if any
+    EntityHandle m_handle;               // this entity's handle in m_manager
     std::vector<std::shared_ptr<Component>> m_components;
+    ComponentMask m_component_mask = 0;  // union of the components' ancestor masks
+    PhaseMask m_phase_mask = 0;          // union of the components' phases
+    std::array<std::uint8_t, ComponentType::max_types> m_slots{};  // type id -> index in m_components
     sf::Vector2f m_position;
+    sf::Vector2f m_previous_position;   // m_position before the latest fixed update
     float m_rotation = 0.0f;
     bool m_alive = true;            // should be updated
     bool m_visible = true;          // should be rendered
     bool m_for_deletion = false;    // should be deleted
     bool m_facing_right = true;     // for sprite mirroring
+    std::uint32_t m_transform_version = 0;  // see get_transform_version()
+    CollisionLayer m_layer = LAYER_NONE;
+
+    void index_component(std::size_t index);
+    void rebuild_component_index();
 };
 
 struct EntityManager
 {
-    std::vector<std::shared_ptr<Entity>> list;
-    void update(const float &dt);
+    EntityManager() = default;
+    explicit EntityManager(bool pooled_components) : pooled(pooled_components) {}
+
+    // When pooled, components are allocated from per-type pools in
+    // storage and updated in bulk by type rather than entity by entity.
+    bool pooled = false;
+    ComponentStorage storage;   // declared before list so it outlives the entities
+    std::vector<std::unique_ptr<Entity>> list;  // live entities, in no particular order
+
+    // Component types updated by a System instead of by Entity::update.
+    ComponentMask scheduled = 0;
+
+    // Runs one update phase over every alive entity, visiting each once.
+    void update(FramePhase phase, const float &dt);
     void render();
+    // Renders only the entities within bounds, which should include a
+    // margin for their size. Counts what it skipped in the renderer's stats.
+    void render(const sf::FloatRect &bounds);
+
+    // Creation and destruction are buffered and applied by flush(), so the
+    // list never changes while it is being iterated. A created entity can
+    // be resolved and given components straight away. The manager is the
+    // only owner; everything else refers to entities by handle.
+    Entity &create();
+    void destroy(EntityHandle handle);
+    void flush();
+    void clear();
+
+    // Records every entity's position as its previous one. Called at the
+    // start of each fixed update so drawing can interpolate.
+    void save_positions();
+
+    // The entity behind a handle, or nullptr if it has been destroyed. O(1).
+    Entity *resolve(EntityHandle handle) const;
+
+    // Collects the T component of every alive entity that has one.
+    template<typename T>
+    void query(std::vector<T *> &out) const;
+
+private:
+    static constexpr std::uint32_t no_index = 0xFFFFFFFFu;
+
+    struct Slot
+    {
+        Entity *entity = nullptr;
+        std::uint32_t dense = no_index;     // index in list, or no_index while pending
+        std::uint32_t generation = 1;
+    };
+
+    std::vector<Slot> m_slots;
+    std::vector<std::uint32_t> m_free_slots;
+    std::vector<std::unique_ptr<Entity>> m_pending_create;
+    std::vector<EntityHandle> m_pending_destroy;
+
+    void release_slot(std::uint32_t index);
 };
 
 class Component {
+    friend class Entity;
+    template<typename T> friend class ComponentPool;
 public:
     Component() = delete;
     bool to_be_deleted() const;
     virtual void update(const float& dt) = 0;
     virtual void render() = 0;
     virtual ~Component();
+
+    // Called once for each phase in get_phases(). Components registered for
+    // more than one phase override this to do different work in each.
+    virtual void update_phase(FramePhase phase, const float& dt) { update(dt); }
+    PhaseMask get_phases() const { return m_phases; }
 protected:
     Entity* const m_parent;
     bool m_to_delete;
+    std::size_t m_type_id = 0;          // id of the concrete component type
+    ComponentMask m_type_mask = 0;      // the concrete type plus its declared bases
+    PhaseMask m_phases = 0;             // phases the concrete type is updated in
     explicit Component(Entity* const p);
 
-};
\ No newline at end of file
+};
+
+template<typename T, typename... Targs>
+std::shared_ptr<T> Entity::add_component(Targs... params)
+{
+    static_assert(std::is_base_of<Component, T>::value, "T is not a component");
+    std::shared_ptr<T> ptr = (m_manager && m_manager->pooled)
+        ? m_manager->storage.create<T>(this, params...)
+        : std::make_shared<T>(this, params...);
+
+    ptr->m_type_id = ComponentType::id<T>();
+    ptr->m_type_mask = ComponentType::ancestor_mask<T>();
+    ptr->m_phases = component_phases<T>::value;
+    m_components.push_back(ptr);
+    index_component(m_components.size() - 1);
+
+    return ptr;
+}
+
+template<typename T>
+const std::vector<std::shared_ptr<T>> Entity::get_components() const
+{
+    static_assert(std::is_base_of<Component, T>::value, "T is not a component");
+    std::vector<std::shared_ptr<T>> out;
+
+    if (!has_component<T>())
+    {
+        return out;
+    }
+
+    for (const std::shared_ptr<Component> &component : m_components)
+    {
+        if (component->m_type_id == ComponentType::id<T>())
+        {
+            out.push_back(std::static_pointer_cast<T>(component));
+        }
+    }
+
+    return out;
+}
+
+template<typename T>
+const std::vector<std::shared_ptr<T>> Entity::get_compatible_components() const
+{
+    static_assert(std::is_base_of<Component, T>::value, "T is not a component");
+    std::vector<std::shared_ptr<T>> out;
+
+    if (!has_component<T>())
+    {
+        return out;
+    }
+
+    for (const std::shared_ptr<Component> &component : m_components)
+    {
+        // the ancestor mask says whether the component is a derivative of T
+        if (component->m_type_mask & ComponentType::bit<T>())
+        {
+            out.push_back(std::static_pointer_cast<T>(component));
+        }
+    }
+
+    return out;
+}
+
+template<typename T>
+T *Entity::get_component() const
+{
+    if (!has_component<T>())
+    {
+        return nullptr;
+    }
+
+    return static_cast<T *>(m_components[m_slots[ComponentType::id<T>()]].get());
+}
+
+template<typename T>
+bool Entity::has_component() const
+{
+    static_assert(std::is_base_of<Component, T>::value, "T is not a component");
+    return (m_component_mask & ComponentType::bit<T>()) != 0;
+}
+
+template<typename T>
+void Entity::remove_component(std::shared_ptr<T> component)
+{
+    static_assert(std::is_base_of<Component, T>::value, "T is not a component");
+
+    // Find and remove the component
+    m_components.erase(
+        std::remove_if(m_components.begin(), m_components.end(),
+            [&component](std::shared_ptr<Component>& comp) {
+                return comp == component;
+            }),
+        m_components.end()
+    );
+    rebuild_component_index();
+}
+
+template<typename T>
+void Entity::remove_components_by_type()
+{
+    static_assert(std::is_base_of<Component, T>::value, "T is not a component");
+
+    if (!has_component<T>())
+    {
+        return;
+    }
+
+    m_components.erase(
+        std::remove_if(m_components.begin(), m_components.end(),
+            [](std::shared_ptr<Component>& comp) {
+                return (comp->m_type_mask & ComponentType::bit<T>()) != 0;
+            }),
+        m_components.end()
+    );
+    rebuild_component_index();
+}
+
+template<typename T>
+void EntityManager::query(std::vector<T *> &out) const
+{
+    out.clear();
+    for (const std::unique_ptr<Entity> &entity : list)
+    {
+        if (entity->is_alive() && entity->has_component<T>())
+        {
+            out.push_back(entity->get_component<T>());
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+// EntityHandle
+// A weak, copyable reference to an entity: a 20-bit slot index and a
+// 12-bit generation packed into 32 bits. The generation changes every time
+// the slot is freed, so a handle to a destroyed entity stops resolving
+// instead of pointing at whatever reused the slot. Generations start at 1,
+// so the all-zero handle is never valid. A slot whose generation would
+// pass max_generation is retired rather than wrapped, so no handle can
+// ever resolve to a later entity.
+struct EntityHandle
+{
+    static constexpr std::uint32_t index_bits = 20;
+    static constexpr std::uint32_t generation_bits = 12;
+    static constexpr std::uint32_t max_index = (1u << index_bits) - 1;
+    static constexpr std::uint32_t max_generation = (1u << generation_bits) - 1;
+
+    std::uint32_t value = 0;
+
+    static constexpr EntityHandle make(std::uint32_t index, std::uint32_t generation)
+    {
+        return EntityHandle{(generation << index_bits) | (index & max_index)};
+    }
+
+    constexpr std::uint32_t index() const { return value & max_index; }
+    constexpr std::uint32_t generation() const { return value >> index_bits; }
+    constexpr bool is_null() const { return value == 0; }
+    constexpr explicit operator bool() const { return value != 0; }
+
+    constexpr bool operator==(const EntityHandle &other) const { return value == other.value; }
+    constexpr bool operator!=(const EntityHandle &other) const { return value != other.value; }
+};
@@ -0,0 +1,41 @@
+#include "frame_phase.hpp"
+
+/// <summary>
+/// Gets a readable name for a phase.
+/// </summary>
+/// <param name="phase">The phase.</param>
+/// <returns>The phase's name.</returns>
+const char *phase_name(FramePhase phase)
+{
+    switch (phase)
+    {
+    case PHASE_INPUT: return "input";
+    case PHASE_PRE_PHYSICS: return "pre-physics";
+    case PHASE_PHYSICS_STEP: return "physics step";
+    case PHASE_POST_PHYSICS: return "post-physics";
+    case PHASE_LATE_UPDATE: return "late update";
+    case PHASE_RENDER_COLLECT: return "render collect";
+    default: return "unknown";
+    }
+}
+
+/// <summary>
+/// Records how long a phase took this frame.
+/// </summary>
+/// <param name="phase">The phase.</param>
+/// <param name="ms">Time spent, in milliseconds.</param>
+void PhaseTimings::record(FramePhase phase, double ms)
+{
+    last_ms[phase] = ms;
+    total_ms[phase] += ms;
+}
+
+/// <summary>
+/// Gets the average time a phase has taken per frame.
+/// </summary>
+/// <param name="phase">The phase.</param>
+/// <returns>Average milliseconds per frame, or 0 before the first frame.</returns>
+double PhaseTimings::average_ms(FramePhase phase) const
+{
+    return frames ? total_ms[phase] / static_cast<double>(frames) : 0.0;
+}
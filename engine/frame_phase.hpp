@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+// The phases of one frame, in the order Scene::update runs them.
+enum FramePhase
+{
+    PHASE_INPUT,            // read devices and turn them into intent
+    PHASE_PRE_PHYSICS,      // AI, forces and anything that moves bodies
+    PHASE_PHYSICS_STEP,     // the Box2D world step
+    PHASE_POST_PHYSICS,     // copy body transforms back onto entities
+    PHASE_LATE_UPDATE,      // follow final transforms, e.g. drawables
+    PHASE_RENDER_COLLECT,   // queue drawables with the Renderer
+    PHASE_COUNT
+};
+
+// One bit per FramePhase.
+using PhaseMask = std::uint8_t;
+
+constexpr PhaseMask phase_bit(FramePhase phase)
+{
+    return static_cast<PhaseMask>(1u << phase);
+}
+
+// The mask of several phases, e.g. phase_bits(PHASE_PRE_PHYSICS, PHASE_POST_PHYSICS).
+template<typename... Phases>
+constexpr PhaseMask phase_bits(Phases... phases)
+{
+    return static_cast<PhaseMask>((0u | ... | (1u << phases)));
+}
+
+const char *phase_name(FramePhase phase);
+
+// The phases a component type is updated in, as declared by a
+// `static constexpr PhaseMask phases = ...;` member. Types without the
+// member are updated once, before the physics step. Rendering is not a
+// phase bit: every component's render() is called in PHASE_RENDER_COLLECT.
+template<typename T, typename = void>
+struct component_phases
+{
+    static constexpr PhaseMask value = phase_bit(PHASE_PRE_PHYSICS);
+};
+
+template<typename T>
+struct component_phases<T, std::void_t<decltype(T::phases)>>
+{
+    static constexpr PhaseMask value = T::phases;
+};
+
+// PhaseTimings
+// Time spent in each phase, for the last frame and on average.
+struct PhaseTimings
+{
+    std::array<double, PHASE_COUNT> last_ms{};
+    std::array<double, PHASE_COUNT> total_ms{};
+    std::uint64_t frames = 0;
+
+    void record(FramePhase phase, double ms);
+    double average_ms(FramePhase phase) const;
+};
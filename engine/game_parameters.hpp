@@ -18,8 +18,15 @@ struct params
 
     static constexpr int sub_step_count = 4;
     static constexpr float time_step = 1.0f / 120.0f;    // 120FPS
+    static constexpr float max_frame_time = 0.25f;      // longest frame the fixed-step loop catches up on
+    static constexpr int max_steps_per_frame = 8;       // fixed steps per frame before dropping time
 
     static constexpr float tile_size = 40.0f;
+    static constexpr float cull_margin = 2.0f * tile_size;  // how far outside the view an entity's origin can be and still show
+    static constexpr int world_chunk_budget = 32;           // chunks of a streamed world kept in memory
+
+    // Allocate components from per-type pools and update them in bulk.
+    static constexpr bool pooled_components = true;
 
     static constexpr float player_size[2] = {20.f,20.f};
     static constexpr float player_weight = 5.f;
@@ -30,6 +37,8 @@ struct params
     static constexpr float player_restitution = 0.0f;
 
     static constexpr float enemy_count = 10;
+    static constexpr int max_enemies = 50;                  // enemy cap on a machine with the baseline core count
+    static constexpr int max_enemies_baseline_cores = 4;    // the cap grows in proportion above this
     static constexpr float enemy_size[2] = { 20.f,20.f };
     static constexpr float enemy_weight = 5.f;
     static constexpr float enemy_jump = 20.f;
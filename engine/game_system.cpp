@@ -2,20 +2,33 @@
 #include "game_system.hpp"
 #include "renderer.hpp"
 #include "physics.hpp"
+#include "input.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 
 std::shared_ptr<Scene> GameSystem::m_active_scene;
 bool GameSystem::m_physics_enabled;
+bool GameSystem::m_headless = false;
+std::uint64_t GameSystem::m_frame = 0;
 float GameSystem::fps;
+std::unique_ptr<ProfilerOverlay> GameSystem::m_overlay;
+bool GameSystem::m_overlay_visible = false;
 
 /// <summary>
 /// Central game loop
+/// The game is updated in fixed steps of time_step seconds. Real time is
+/// banked in an accumulator and spent a step at a time, and each frame is
+/// drawn between the last two steps using the leftover fraction.
 /// </summary>
 /// <param name="w">Starting window width</param>
 /// <param name="h">Starting window height</param>
 /// <param name="title">Title of the window</param>
-/// <param name="time_step">Time step value - linked to frame rate</param>
+/// <param name="time_step">Fixed update step in seconds, also the frame budget</param>
 /// <param name="physics_enabled">Set whether or not physics should be enabled.</param>
-void GameSystem::start(unsigned int w, unsigned int h, const std::string &title, const float &time_step, bool physics_enabled)
+/// <param name="render_thread">Draw on a separate thread, overlapping the next update.</param>
+void GameSystem::start(unsigned int w, unsigned int h, const std::string &title, const float &time_step, bool physics_enabled, bool render_thread)
 {
     // Sets the initial window dimensions.
     sf::RenderWindow window({w, h}, title);
@@ -27,6 +40,10 @@ void GameSystem::start(unsigned int w, unsigned int h, const std::string &title,
     m_init();
     // Intialises the window.
     Renderer::init(window, view);
+    if(render_thread)
+    {
+        Renderer::start_render_thread();
+    }
 
     sf::Event event;
 
@@ -34,18 +51,25 @@ void GameSystem::start(unsigned int w, unsigned int h, const std::string &title,
 
     sf::Time previousTime = clock.getElapsedTime();
     sf::Time currentTime;
+    float accumulator = 0.0f;
 
     while(window.isOpen())
     {
         currentTime = clock.getElapsedTime();
 
-        fps = 1.0f / (currentTime.asSeconds() - previousTime.asSeconds());
+        // Clamped so a stall (e.g. dragging the window) does not queue up a burst of steps.
+        const float frame_time = std::min(currentTime.asSeconds() - previousTime.asSeconds(), params::max_frame_time);
+        previousTime = currentTime;
+
+        fps = (frame_time > 0.0f) ? 1.0f / frame_time : 0.0f;
+        accumulator += frame_time;
 
         while(window.pollEvent(event))
         {
             // Handles closing the window properly.
             if(event.type == sf::Event::Closed)
             {
+                Renderer::shutdown();
                 window.close();
                 clean();
                 return;
@@ -54,11 +78,16 @@ void GameSystem::start(unsigned int w, unsigned int h, const std::string &title,
             // Resizes the window and the view in the window.
             if(event.type == sf::Event::Resized)
             {
+                // The view is applied to the window with each frame drawn.
                 view.setSize({
                     static_cast<float>(event.size.width),
                     static_cast<float>(event.size.height)
                 });
-                window.setView(view);
+            }
+
+            if(event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3 && m_overlay)
+            {
+                m_overlay_visible = !m_overlay_visible;
             }
         }
 
@@ -66,40 +95,169 @@ void GameSystem::start(unsigned int w, unsigned int h, const std::string &title,
         #ifdef DEBUG
                 if (sf::Keyboard::isKeyPressed(sf::Keyboard::Escape))
                 {
+                    Renderer::shutdown();
                     window.close();
                 }
         #endif // DEBUG
 
-        window.clear();
-        m_update(currentTime.asSeconds());
-        m_render();
+        // Runs as many fixed steps as the banked time allows.
+        int steps = 0;
+        while(accumulator >= time_step && steps < params::max_steps_per_frame)
+        {
+            m_update(time_step);
+            accumulator -= time_step;
+            ++steps;
+        }
 
-        // V-sync
-        sf::sleep(sf::seconds(time_step));
+        // Spiral of death: if the updates cannot keep up, drop the whole
+        // steps that are still owed rather than falling further behind.
+        if(steps == params::max_steps_per_frame)
+        {
+            accumulator = std::fmod(accumulator, time_step);
+        }
 
-        window.display();
+        Renderer::set_interpolation(accumulator / time_step);
+        m_render(frame_time);
+        Profiler::end_frame();
 
-        previousTime = currentTime;
+        // Frame pacing: sleep only for what is left of this frame's budget.
+        const float spent = clock.getElapsedTime().asSeconds() - currentTime.asSeconds();
+        if(spent < time_step)
+        {
+            sf::sleep(sf::seconds(time_step - spent));
+        }
     }
 
+    Renderer::shutdown();
     window.close();
     clean();
 }
 
+/// <summary>
+/// Runs the game with no window.
+/// Fixed updates run back to back as fast as the CPU allows until the frame
+/// count is reached or the scene is finished. Nothing is drawn unless the
+/// renderer is a software one, which draws every update. Then the run's
+/// speed and the scene's statistics are printed.
+/// </summary>
+/// <param name="scene">The scene to run.</param>
+/// <param name="frames">Most fixed updates to run.</param>
+/// <param name="time_step">Fixed update step in seconds</param>
+/// <param name="physics_enabled">Set whether or not physics should be enabled.</param>
+/// <param name="on_frame">Called after each software frame is drawn, e.g. to save it.</param>
+void GameSystem::run_headless(const std::shared_ptr<Scene> &scene, std::uint64_t frames, const float &time_step, bool physics_enabled,
+                              const std::function<void(std::uint64_t)> &on_frame)
+{
+    m_physics_enabled = physics_enabled;
+    m_headless = true;
+
+    m_init();
+    // Loaded after going headless, so nothing asks for a graphics context.
+    setActiveScene(scene);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    const bool software = Renderer::is_software();
+    double raster_ms = 0.0;
+
+    const std::uint64_t first_frame = m_frame;
+    while(m_frame - first_frame < frames && !m_active_scene->is_finished())
+    {
+        m_update(time_step);
+
+        if(software)
+        {
+            // Drawn at the latest state; there is nothing to interpolate between.
+            Renderer::set_interpolation(1.0f);
+            m_active_scene->render();
+
+            const auto raster_start = std::chrono::steady_clock::now();
+            Renderer::render();
+            raster_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - raster_start).count();
+
+            if(on_frame)
+            {
+                on_frame(m_frame);
+            }
+        }
+
+        Profiler::end_frame();
+    }
+
+    const double wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const std::uint64_t simulated = m_frame - first_frame;
+
+    std::cout << "Simulated frames: " << simulated << "\n";
+    std::cout << "Simulated time: " << simulated * time_step << "s\n";
+    std::cout << "Wall time: " << wall_seconds << "s\n";
+    std::cout << "Simulated FPS: " << (wall_seconds > 0.0 ? simulated / wall_seconds : 0.0) << "\n";
+
+    const PhaseTimings &timings = m_active_scene->get_phase_timings();
+    for(int phase = 0; phase < PHASE_RENDER_COLLECT; ++phase)
+    {
+        std::cout << "  " << phase_name(static_cast<FramePhase>(phase)) << ": "
+                  << timings.average_ms(static_cast<FramePhase>(phase)) << "ms\n";
+    }
+    if(software && simulated > 0)
+    {
+        std::cout << "  " << phase_name(PHASE_RENDER_COLLECT) << ": " << timings.average_ms(PHASE_RENDER_COLLECT) << "ms\n";
+        std::cout << "  rasterize: " << raster_ms / simulated << "ms\n";
+    }
+
+    m_active_scene->write_stats(std::cout);
+    std::cout << std::flush;
+
+    clean();
+}
+
 /// <summary>
 /// Gets the FPS.
 /// </summary>
 /// <returns>The FPS</returns>
 float GameSystem::get_fps() { return fps; }
 
+/// <summary>
+/// Makes the profiler overlay, which F3 shows and hides.
+/// </summary>
+/// <param name="font_path">Path to the font for the overlay.</param>
+/// <param name="visible">Whether to show it straight away.</param>
+void GameSystem::enable_profiler_overlay(const std::string &font_path, bool visible)
+{
+    m_overlay = std::make_unique<ProfilerOverlay>(font_path);
+    m_overlay_visible = visible;
+}
+
+/// <summary>
+/// Gets whether the physics world is stepped each frame.
+/// </summary>
+/// <returns>Whether physics is enabled.</returns>
+bool GameSystem::is_physics_enabled() { return m_physics_enabled; }
+
+/// <summary>
+/// Gets whether the game is running without a window.
+/// </summary>
+/// <returns>Whether the game is headless.</returns>
+bool GameSystem::is_headless() { return m_headless; }
+
+/// <summary>
+/// Gets how many fixed updates have run.
+/// </summary>
+/// <returns>The fixed update count.</returns>
+std::uint64_t GameSystem::get_frame() { return m_frame; }
+
 /// <summary>
 /// Moves the camera.
 /// </summary>
 /// <param name="pos">The position to move the camera to.</param>
 void GameSystem::moveCamera(sf::Vector2f pos)
 {
+    if(!Renderer::has_target())
+    {
+        return;
+    }
+
+    // The view is applied to the window with each frame drawn.
     Renderer::getView().setCenter(pos);
-    Renderer::getWindow().setView(Renderer::getView());
 }
 
 /// <summary>
@@ -108,8 +266,13 @@ void GameSystem::moveCamera(sf::Vector2f pos)
 /// <param name="active_sc">The scene to set the active scene to.</param>
 void GameSystem::setActiveScene(const std::shared_ptr<Scene> &active_sc)
 {
+    // Loading can change or free textures a frame still being drawn uses.
+    Renderer::sync();
+    PROFILE_ZONE("GameSystem::setActiveScene");
+
     m_active_scene = active_sc;
     m_active_scene->load();
+    m_active_scene->end_frame();
 }
 
 /// <summary>
@@ -140,72 +303,141 @@ void GameSystem::m_init()
 /// <param name="dt">Delta Time - Linked to frame rate.</param>
 void GameSystem::m_update(const float &dt)
 {
-    // Updates the scene.
+    PROFILE_ZONE("GameSystem::m_update");
+
+    // Moves scripted input on to this update.
+    Input::update(m_frame);
+
+    // Updates the scene. The physics step is one of the scene's phases.
     m_active_scene->update(dt);
 
-    // Updates the physics when the scene is updated.
-    if(m_physics_enabled)
-    {
-        Physics::update(Physics::time_step);
-    }
+    // Adds and removes the entities queued during the update.
+    m_active_scene->end_frame();
 
     // Updates rendered elements.
     Renderer::update(dt);
+
+    ++m_frame;
 }
 
 /// <summary>
 /// Renders elements in the GameSystem.
 /// </summary>
-void GameSystem::m_render()
+/// <param name="dt">Seconds since the last frame, for the overlay's refresh.</param>
+void GameSystem::m_render(float dt)
 {
     // Renders in the scene.
     m_active_scene->render();
 
+    if(m_overlay && m_overlay_visible)
+    {
+        m_overlay->render(dt);
+    }
+
     // Renders the sprites in the scene.
     Renderer::render();
 }
 
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double elapsed_ms(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+}
+
 /// <summary>
 /// Updates the scene.
+/// Runs each frame phase in order, visiting every entity once per phase.
 /// </summary>
 /// <param name="dt">Delta Time - Linked to frame rate.</param>
 void Scene::update(const float &dt)
 {
-    std::cout << "FPS: " << GameSystem::get_fps() << std::endl;
+    ++m_timings.frames;
+
+    // The positions drawn this frame are blended from these.
+    m_entities.save_positions();
 
-    // Updates every entity in the scene.
-    for(std::shared_ptr<Entity> &ent : m_entities.list)
+    run_phase(PHASE_INPUT, dt);
+    run_phase(PHASE_PRE_PHYSICS, dt);
+
+    // Steps the physics world between moving bodies and reading them back.
+    const Clock::time_point start = Clock::now();
+    if(GameSystem::is_physics_enabled())
     {
-        ent->update(dt);
+        Physics::update(dt);
     }
+    m_timings.record(PHASE_PHYSICS_STEP, elapsed_ms(start));
+
+    run_phase(PHASE_POST_PHYSICS, dt);
+    run_phase(PHASE_LATE_UPDATE, dt);
 }
 
 /// <summary>
-/// Renders every entity in the scene.
+/// Runs one update phase and records how long it took.
+/// </summary>
+/// <param name="phase">The phase to run.</param>
+/// <param name="dt">Delta Time - Linked to frame rate.</param>
+void Scene::run_phase(FramePhase phase, const float &dt)
+{
+    PROFILE_ZONE(phase_name(phase));
+    const Clock::time_point start = Clock::now();
+
+    m_entities.update(phase, dt);
+    m_scheduler.run(m_entities, phase, dt);
+
+    m_timings.record(phase, elapsed_ms(start));
+}
+
+/// <summary>
+/// Renders every visible entity in view.
+/// This is the render-collect phase: components queue their drawables.
 /// </summary>
 void Scene::render()
 {
-    for(std::shared_ptr<Entity> &ent : m_entities.list)
+    PROFILE_ZONE(phase_name(PHASE_RENDER_COLLECT));
+    const Clock::time_point start = Clock::now();
+
+    // Only what could be on screen is queued.
+    sf::FloatRect bounds = Renderer::get_view_bounds();
+    bounds.left -= params::cull_margin;
+    bounds.top -= params::cull_margin;
+    bounds.width += 2.0f * params::cull_margin;
+    bounds.height += 2.0f * params::cull_margin;
+    m_entities.render(bounds);
+
+    // Every projectile goes in one draw, over the entities. With no GPU the
+    // disc stays an image for the software rasterizer.
+    const bool software = Renderer::is_software();
+    m_projectiles.prepare(Renderer::get_interpolation(), bounds, !software);
+    if(software)
     {
-        ent->render();
+        Renderer::set_texture_image(m_projectiles.get_texture(), m_projectiles.get_image());
     }
+    Renderer::queue_vertices(m_projectiles.get_vertices(), m_projectiles.get_vertex_count(), sf::Triangles,
+                             m_projectiles.get_texture(), RENDER_LAYER_PROJECTILES);
+
+    m_timings.record(PHASE_RENDER_COLLECT, elapsed_ms(start));
 }
 
 /// <summary>
 /// Unloads the scene.
-/// Clears the entity list.
+/// Clears the entity list and projectiles.
 /// </summary>
 void Scene::unload()
 {
-    m_entities.list.clear();
+    m_scheduler.clear(m_entities);
+    m_entities.clear();
+    m_projectiles.clear();
 }
 
 /// <summary>
 /// Makes a basic new entity.
+/// It joins the scene's entity list at the end of the frame.
 /// </summary>
-/// <returns></returns>
-const std::shared_ptr<Entity>& Scene::make_entity() {
-    std::shared_ptr<Entity> entity = std::make_shared<Entity>();
-    m_entities.list.push_back(entity);
-    return m_entities.list.back();
+/// <returns>The new entity. Keep its handle rather than the reference.</returns>
+Entity &Scene::make_entity() {
+    return m_entities.create();
 }
\ No newline at end of file
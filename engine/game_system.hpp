@@ -1,6 +1,13 @@
 #pragma once
 #include "ecm.hpp"
+#include "game_parameters.hpp"
+#include "profiler_overlay.hpp"
+#include "projectile_buffer.hpp"
+#include "system.hpp"
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <ostream>
 #include <vector>
 #include <SFML/Graphics.hpp>
 
@@ -15,29 +22,65 @@ class Scene
         virtual void load() = 0;
         virtual void unload();
 
-        const std::shared_ptr<Entity>& make_entity();
-        std::vector<std::shared_ptr<Entity>> &getEntities() { return m_entities.list; }
+        // Applies the entity creations and deletions queued this frame.
+        void end_frame() { m_entities.flush(); }
+
+        Entity &make_entity();
+        Entity *resolve(EntityHandle handle) const { return m_entities.resolve(handle); }
+        std::vector<std::unique_ptr<Entity>> &getEntities() { return m_entities.list; }
         void set_enemy_count(int e) { enemyCount = e; }
+
+        // The scene's bullets. Drawn over the entities in render().
+        ProjectileBuffer &get_projectiles() { return m_projectiles; }
+
+        // Time spent in each frame phase.
+        const PhaseTimings &get_phase_timings() const { return m_timings; }
+
+        // Whether a headless run should stop, e.g. the player has died.
+        virtual bool is_finished() const { return false; }
+        // Writes the scene's end-of-run statistics.
+        virtual void write_stats(std::ostream &out) const {}
     protected:
+        // Runs one update phase: the entities, then the phase's systems.
+        void run_phase(FramePhase phase, const float &dt);
+
         int enemyCount;
-        EntityManager m_entities;
+        EntityManager m_entities{params::pooled_components};
+        Scheduler m_scheduler;  // systems run after the entities in each phase
+        ProjectileBuffer m_projectiles;
+        PhaseTimings m_timings;
 };
 
 class GameSystem
 {
 public:
-    static void start(unsigned int w, unsigned int h, const std::string &title, const float &time_step, bool physics_enabled);
+    static void start(unsigned int w, unsigned int h, const std::string &title, const float &time_step, bool physics_enabled,
+                      bool render_thread = false);
+    // With a software renderer (Renderer::init_software) every update is also
+    // drawn, and on_frame is called with the frame number after each.
+    static void run_headless(const std::shared_ptr<Scene> &scene, std::uint64_t frames, const float &time_step, bool physics_enabled,
+                             const std::function<void(std::uint64_t)> &on_frame = nullptr);
     static void clean();
     static void reset();
     static void setActiveScene(const std::shared_ptr<Scene>& active_sc);
     static void moveCamera(sf::Vector2f pos);
     static float get_fps();
+    static bool is_physics_enabled();
+    static bool is_headless();
+    static std::uint64_t get_frame();
+
+    // Lets F3 show the profiler's percentiles over the game.
+    static void enable_profiler_overlay(const std::string &font_path, bool visible);
 
 private:
     static void m_init();
     static void m_update(const float &dt);
-    static void m_render();
+    static void m_render(float dt);
     static std::shared_ptr<Scene> m_active_scene;
     static bool m_physics_enabled;
+    static bool m_headless;
+    static std::uint64_t m_frame;   // fixed updates run so far
     static float fps;
+    static std::unique_ptr<ProfilerOverlay> m_overlay;
+    static bool m_overlay_visible;
 };
\ No newline at end of file
@@ -0,0 +1,380 @@
+#include "input.hpp"
+#include "game_parameters.hpp"
+#include "renderer.hpp"
+#include <algorithm>
+#include <sstream>
+
+static std::unique_ptr<InputSource> source = std::make_unique<DeviceInput>();
+
+/// <summary>
+/// Checks a key on the real keyboard.
+/// </summary>
+/// <param name="key">The key to check.</param>
+/// <returns>Whether the key is held.</returns>
+bool DeviceInput::is_key_pressed(sf::Keyboard::Key key) const
+{
+    return sf::Keyboard::isKeyPressed(key);
+}
+
+/// <summary>
+/// Checks a button on the real mouse.
+/// </summary>
+/// <param name="button">The button to check.</param>
+/// <returns>Whether the button is held.</returns>
+bool DeviceInput::is_button_pressed(sf::Mouse::Button button) const
+{
+    return sf::Mouse::isButtonPressed(button);
+}
+
+/// <summary>
+/// Gets the mouse position mapped into the world through the current view.
+/// </summary>
+/// <returns>The mouse in world coordinates.</returns>
+sf::Vector2f DeviceInput::get_pointer_position() const
+{
+    sf::Vector2i mouse_pos = sf::Mouse::getPosition(Renderer::getWindow());
+    return Renderer::getWindow().mapPixelToCoords(mouse_pos, Renderer::getView());
+}
+
+/// <summary>
+/// Loads an input script.
+/// </summary>
+/// <param name="file_path">Path to the script.</param>
+ScriptedInput::ScriptedInput(const std::string &file_path)
+{
+    std::ifstream file(file_path);
+    if (!file.good())
+    {
+        throw std::string("Couldn't open input script: ") + file_path;
+    }
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line))
+    {
+        ++line_number;
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        std::istringstream in(line);
+        std::uint64_t frame;
+        std::string action;
+        if (!(in >> frame >> action))
+        {
+            throw std::string("Bad input script line ") + std::to_string(line_number) + ": " + line;
+        }
+
+        if (action == "press" || action == "release")
+        {
+            std::string control;
+            if (!(in >> control))
+            {
+                throw std::string("Missing control on input script line ") + std::to_string(line_number);
+            }
+            action == "press" ? press(frame, control) : release(frame, control);
+        }
+        else if (action == "point")
+        {
+            sf::Vector2f position;
+            if (!(in >> position.x >> position.y))
+            {
+                throw std::string("Missing position on input script line ") + std::to_string(line_number);
+            }
+            point(frame, position);
+        }
+        else
+        {
+            throw std::string("Unknown input script action: ") + action;
+        }
+    }
+}
+
+/// <summary>
+/// Presses a control from the given frame on.
+/// </summary>
+/// <param name="frame">Fixed update the press happens on.</param>
+/// <param name="control">Control name from the game parameters.</param>
+void ScriptedInput::press(std::uint64_t frame, const std::string &control)
+{
+    add({frame, EVENT_PRESS, control, {}});
+}
+
+/// <summary>
+/// Releases a control from the given frame on.
+/// </summary>
+/// <param name="frame">Fixed update the release happens on.</param>
+/// <param name="control">Control name from the game parameters.</param>
+void ScriptedInput::release(std::uint64_t frame, const std::string &control)
+{
+    add({frame, EVENT_RELEASE, control, {}});
+}
+
+/// <summary>
+/// Moves the pointer from the given frame on.
+/// </summary>
+/// <param name="frame">Fixed update the move happens on.</param>
+/// <param name="position">New pointer position in world coordinates.</param>
+void ScriptedInput::point(std::uint64_t frame, const sf::Vector2f &position)
+{
+    add({frame, EVENT_POINT, "", position});
+}
+
+/// <summary>
+/// Names a key by its code, for keys with no control bound to them.
+/// </summary>
+/// <param name="key">The key.</param>
+/// <returns>key: followed by the key's code.</returns>
+std::string ScriptedInput::key_control(sf::Keyboard::Key key)
+{
+    return "key:" + std::to_string(static_cast<int>(key));
+}
+
+/// <summary>
+/// Applies every event due by this frame.
+/// </summary>
+/// <param name="frame">The fixed update about to run.</param>
+void ScriptedInput::update(std::uint64_t frame)
+{
+    while (m_next < m_events.size() && m_events[m_next].frame <= frame)
+    {
+        const Event &event = m_events[m_next++];
+        switch (event.type)
+        {
+        case EVENT_PRESS: m_held[event.control] = true; break;
+        case EVENT_RELEASE: m_held[event.control] = false; break;
+        case EVENT_POINT: m_pointer = event.position; break;
+        }
+    }
+}
+
+/// <summary>
+/// Checks whether the script holds the key, or a control bound to it.
+/// </summary>
+/// <param name="key">The key to check.</param>
+/// <returns>Whether the key is held.</returns>
+bool ScriptedInput::is_key_pressed(sf::Keyboard::Key key) const
+{
+    if (is_held(key_control(key)))
+    {
+        return true;
+    }
+    for (const auto &control : params::getControls())
+    {
+        if (control.second == key && is_held(control.first))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// <summary>
+/// Checks whether the script holds the control bound to a mouse button.
+/// </summary>
+/// <param name="button">The button to check.</param>
+/// <returns>Whether the button is held.</returns>
+bool ScriptedInput::is_button_pressed(sf::Mouse::Button button) const
+{
+    for (const auto &control : params::getMouseControls())
+    {
+        if (control.second == button && is_held(control.first))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// <summary>
+/// Gets the scripted pointer position.
+/// </summary>
+/// <returns>The pointer in world coordinates.</returns>
+sf::Vector2f ScriptedInput::get_pointer_position() const
+{
+    return m_pointer;
+}
+
+/// <summary>
+/// Inserts an event after any others on the same frame.
+/// </summary>
+/// <param name="event">The event to add.</param>
+void ScriptedInput::add(const Event &event)
+{
+    auto position = std::upper_bound(m_events.begin() + m_next, m_events.end(), event.frame,
+        [](std::uint64_t frame, const Event &other) { return frame < other.frame; });
+    m_events.insert(position, event);
+}
+
+/// <summary>
+/// Checks whether a named control is held.
+/// </summary>
+/// <param name="control">The control name.</param>
+/// <returns>Whether it is held.</returns>
+bool ScriptedInput::is_held(const std::string &control) const
+{
+    auto it = m_held.find(control);
+    return it != m_held.end() && it->second;
+}
+
+/// <summary>
+/// Starts recording a source to a script.
+/// </summary>
+/// <param name="source">The source being recorded.</param>
+/// <param name="file_path">Path to write the script to.</param>
+RecordingInput::RecordingInput(std::unique_ptr<InputSource> source, const std::string &file_path)
+    : m_source(std::move(source)), m_file(file_path)
+{
+    if (!m_file.good())
+    {
+        throw std::string("Couldn't open input recording: ") + file_path;
+    }
+}
+
+/// <summary>
+/// Samples the recorded source and writes out what changed.
+/// </summary>
+/// <param name="frame">The fixed update about to run.</param>
+void RecordingInput::update(std::uint64_t frame)
+{
+    m_source->update(frame);
+
+    // Every key is sampled, so the menus' keys replay too. Bound keys are
+    // written as their controls, the rest by code.
+    for (int code = 0; code < sf::Keyboard::KeyCount; ++code)
+    {
+        const sf::Keyboard::Key key = static_cast<sf::Keyboard::Key>(code);
+        m_keys[key] = m_source->is_key_pressed(key);
+    }
+    for (const auto &control : params::getControls())
+    {
+        record(frame, control.first, m_keys[control.second]);
+    }
+    for (const auto &key : m_keys)
+    {
+        const bool bound = std::any_of(params::getControls().begin(), params::getControls().end(),
+            [&key](const auto &control) { return control.second == key.first; });
+        if (!bound)
+        {
+            record(frame, ScriptedInput::key_control(key.first), key.second);
+        }
+    }
+    for (const auto &control : params::getMouseControls())
+    {
+        const bool held = m_source->is_button_pressed(control.second);
+        m_buttons[control.second] = held;
+        record(frame, control.first, held);
+    }
+
+    const sf::Vector2f pointer = m_source->get_pointer_position();
+    if (m_first || pointer != m_pointer)
+    {
+        m_file << frame << " point " << pointer.x << " " << pointer.y << "\n";
+    }
+    m_pointer = pointer;
+    m_first = false;
+}
+
+/// <summary>
+/// Checks a key as sampled at the start of the update.
+/// </summary>
+/// <param name="key">The key to check.</param>
+/// <returns>Whether the key is held.</returns>
+bool RecordingInput::is_key_pressed(sf::Keyboard::Key key) const
+{
+    auto it = m_keys.find(key);
+    return it != m_keys.end() && it->second;
+}
+
+/// <summary>
+/// Checks a button as sampled at the start of the update.
+/// </summary>
+/// <param name="button">The button to check.</param>
+/// <returns>Whether the button is held.</returns>
+bool RecordingInput::is_button_pressed(sf::Mouse::Button button) const
+{
+    auto it = m_buttons.find(button);
+    return it != m_buttons.end() && it->second;
+}
+
+/// <summary>
+/// Gets the pointer as sampled at the start of the update.
+/// </summary>
+/// <returns>The pointer in world coordinates.</returns>
+sf::Vector2f RecordingInput::get_pointer_position() const
+{
+    return m_pointer;
+}
+
+/// <summary>
+/// Writes a press or release if a control changed.
+/// </summary>
+/// <param name="frame">The current fixed update.</param>
+/// <param name="control">The control name.</param>
+/// <param name="held">Whether it is held now.</param>
+void RecordingInput::record(std::uint64_t frame, const std::string &control, bool held)
+{
+    bool &was_held = m_held[control];
+    if (held != was_held)
+    {
+        m_file << frame << (held ? " press " : " release ") << control << "\n";
+        was_held = held;
+    }
+}
+
+/// <summary>
+/// Sets where input is read from.
+/// </summary>
+/// <param name="new_source">The new source.</param>
+void Input::set_source(std::unique_ptr<InputSource> new_source)
+{
+    source = std::move(new_source);
+}
+
+/// <summary>
+/// Gets the active input source.
+/// </summary>
+/// <returns>The source.</returns>
+InputSource &Input::get_source()
+{
+    return *source;
+}
+
+/// <summary>
+/// Advances the input source to a fixed update.
+/// </summary>
+/// <param name="frame">The fixed update about to run.</param>
+void Input::update(std::uint64_t frame)
+{
+    source->update(frame);
+}
+
+/// <summary>
+/// Checks whether a key is held.
+/// </summary>
+/// <param name="key">The key to check.</param>
+/// <returns>Whether the key is held.</returns>
+bool Input::is_key_pressed(sf::Keyboard::Key key)
+{
+    return source->is_key_pressed(key);
+}
+
+/// <summary>
+/// Checks whether a mouse button is held.
+/// </summary>
+/// <param name="button">The button to check.</param>
+/// <returns>Whether the button is held.</returns>
+bool Input::is_button_pressed(sf::Mouse::Button button)
+{
+    return source->is_button_pressed(button);
+}
+
+/// <summary>
+/// Gets the pointer in world coordinates.
+/// </summary>
+/// <returns>The pointer position.</returns>
+sf::Vector2f Input::get_pointer_position()
+{
+    return source->get_pointer_position();
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// InputSource
+// Where the game reads its controls from. Components ask the Input
+// namespace rather than sf::Keyboard and sf::Mouse, so a run can be driven
+// by the real devices or by a script with no window at all.
+class InputSource
+{
+public:
+    virtual ~InputSource() = default;
+
+    // Called once at the start of every fixed update.
+    virtual void update(std::uint64_t frame) {}
+
+    virtual bool is_key_pressed(sf::Keyboard::Key key) const = 0;
+    virtual bool is_button_pressed(sf::Mouse::Button button) const = 0;
+
+    // The pointer in world coordinates.
+    virtual sf::Vector2f get_pointer_position() const = 0;
+};
+
+// Reads the keyboard and the mouse over the render window.
+class DeviceInput : public InputSource
+{
+public:
+    bool is_key_pressed(sf::Keyboard::Key key) const override;
+    bool is_button_pressed(sf::Mouse::Button button) const override;
+    sf::Vector2f get_pointer_position() const override;
+};
+
+// ScriptedInput
+// Replays presses, releases and pointer moves at fixed update frames.
+// Scripts are text, one event per line:
+//     <frame> press <control>
+//     <frame> release <control>
+//     <frame> point <x> <y>
+// where <control> is a name from params::getControls() or
+// params::getMouseControls(), or key:<code> for a key with no control
+// bound to it, e.g. the menus' keys, <code> being its sf::Keyboard::Key
+// value. Lines starting with # are comments.
+class ScriptedInput : public InputSource
+{
+public:
+    ScriptedInput() = default;
+    explicit ScriptedInput(const std::string &file_path);
+
+    void press(std::uint64_t frame, const std::string &control);
+    void release(std::uint64_t frame, const std::string &control);
+    void point(std::uint64_t frame, const sf::Vector2f &position);
+
+    // The control name of a key with no control bound to it.
+    static std::string key_control(sf::Keyboard::Key key);
+
+    void update(std::uint64_t frame) override;
+    bool is_key_pressed(sf::Keyboard::Key key) const override;
+    bool is_button_pressed(sf::Mouse::Button button) const override;
+    sf::Vector2f get_pointer_position() const override;
+
+private:
+    enum EventType
+    {
+        EVENT_PRESS,
+        EVENT_RELEASE,
+        EVENT_POINT
+    };
+
+    struct Event
+    {
+        std::uint64_t frame;
+        EventType type;
+        std::string control;
+        sf::Vector2f position;
+    };
+
+    std::vector<Event> m_events;    // kept sorted by frame
+    std::size_t m_next = 0;
+    std::map<std::string, bool> m_held;
+    sf::Vector2f m_pointer;
+
+    void add(const Event &event);
+    bool is_held(const std::string &control) const;
+};
+
+// RecordingInput
+// Samples another source once per fixed update, answers from that sample and
+// writes every change out in the ScriptedInput format, so a played session
+// can be replayed headless.
+class RecordingInput : public InputSource
+{
+public:
+    RecordingInput(std::unique_ptr<InputSource> source, const std::string &file_path);
+
+    void update(std::uint64_t frame) override;
+    bool is_key_pressed(sf::Keyboard::Key key) const override;
+    bool is_button_pressed(sf::Mouse::Button button) const override;
+    sf::Vector2f get_pointer_position() const override;
+
+private:
+    std::unique_ptr<InputSource> m_source;
+    std::ofstream m_file;
+    std::map<std::string, bool> m_held;
+    std::map<sf::Keyboard::Key, bool> m_keys;
+    std::map<sf::Mouse::Button, bool> m_buttons;
+    sf::Vector2f m_pointer;
+    bool m_first = true;
+
+    void record(std::uint64_t frame, const std::string &control, bool held);
+};
+
+namespace Input
+{
+    // Replaces the active source. The game starts on DeviceInput.
+    void set_source(std::unique_ptr<InputSource> source);
+    InputSource &get_source();
+
+    void update(std::uint64_t frame);
+    bool is_key_pressed(sf::Keyboard::Key key);
+    bool is_button_pressed(sf::Mouse::Button button);
+    sf::Vector2f get_pointer_position();
+};
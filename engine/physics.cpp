@@ -1,4 +1,5 @@
 #include "physics.hpp"
+#include "profiler.hpp"
 
 b2WorldId Physics::m_world_id;
 
@@ -21,12 +22,13 @@ void Physics::shutdown()
 }
 
 /// <summary>
-/// Updates the physics.
+/// Steps the physics world.
 /// </summary>
-/// <param name="dt">Delta Time - Linked to frame rate.</param>
+/// <param name="dt">The fixed step to advance by.</param>
 void Physics::update(const float &dt)
 {
-    b2World_Step(m_world_id, time_step, sub_step_count);
+    PROFILE_ZONE("Physics::update");
+    b2World_Step(m_world_id, dt, sub_step_count);
 }
 
 /// <summary>
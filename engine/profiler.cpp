@@ -0,0 +1,347 @@
+#include "profiler.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#if defined(__GNUG__)
+#include <cstdlib>
+#include <cxxabi.h>
+#endif
+
+namespace
+{
+    struct Event
+    {
+        const char *name;
+        std::uint64_t start;
+        std::uint64_t end;
+    };
+
+    // One thread's zones. Only that thread writes head and only end_frame()
+    // moves tail, so neither side needs a lock.
+    struct Ring
+    {
+        std::array<Event, Profiler::ring_capacity> events;
+        std::atomic<std::uint64_t> head{0};
+        std::atomic<std::uint64_t> tail{0};
+        std::atomic<std::uint64_t> dropped{0};
+        std::uint32_t thread = 0;   // in order of each thread's first zone
+    };
+
+    struct TraceEvent
+    {
+        const char *name;
+        std::uint64_t start;
+        std::uint64_t end;
+        std::uint32_t thread;
+    };
+
+    // One zone's time in each of the last window_frames frames it ran in.
+    struct Window
+    {
+        const char *name;
+        std::array<double, Profiler::window_frames> ms{};
+        std::size_t next = 0;
+        std::size_t count = 0;
+        double this_frame = 0.0;
+        bool ran = false;
+    };
+
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+    std::mutex rings_mutex;
+    std::vector<std::shared_ptr<Ring>> rings;   // shared, so a ring outlives its thread until drained
+
+    // Only touched by the thread calling end_frame() and the readers after it.
+    std::map<std::string, Window> windows;
+    std::unordered_map<const char *, Window *> windows_by_pointer;
+    std::vector<TraceEvent> trace;
+    bool tracing = false;
+    std::uint64_t last_frame_end = 0;
+
+    std::mutex names_mutex;
+    std::deque<std::string> names;              // a deque never moves its strings
+    std::map<std::string, const char *> names_by_value;
+
+    Ring &local_ring()
+    {
+        thread_local std::shared_ptr<Ring> ring = []
+        {
+            std::shared_ptr<Ring> made = std::make_shared<Ring>();
+            std::lock_guard<std::mutex> lock(rings_mutex);
+            made->thread = static_cast<std::uint32_t>(rings.size());
+            rings.push_back(made);
+            return made;
+        }();
+        return *ring;
+    }
+
+    // Zone names may be different pointers to the same text, e.g. one
+    // literal in two files, so windows are keyed by text.
+    Window &window_for(const char *name)
+    {
+        auto found = windows_by_pointer.find(name);
+        if (found != windows_by_pointer.end())
+        {
+            return *found->second;
+        }
+
+        auto inserted = windows.emplace(name, Window());
+        Window &window = inserted.first->second;
+        window.name = inserted.first->first.c_str();
+        windows_by_pointer[name] = &window;
+        return window;
+    }
+
+    void drain()
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex);
+        for (const std::shared_ptr<Ring> &ring : rings)
+        {
+            const std::uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+            const std::uint64_t head = ring->head.load(std::memory_order_acquire);
+            for (std::uint64_t i = tail; i < head; ++i)
+            {
+                const Event &event = ring->events[i % Profiler::ring_capacity];
+                Window &window = window_for(event.name);
+                window.this_frame += (event.end - event.start) / 1.0e6;
+                window.ran = true;
+
+                if (tracing)
+                {
+                    trace.push_back({event.name, event.start, event.end, ring->thread});
+                }
+            }
+            ring->tail.store(head, std::memory_order_release);
+        }
+    }
+
+    double percentile(std::vector<double> &sorted, double fraction)
+    {
+        const std::size_t index = static_cast<std::size_t>(fraction * (sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+
+    void write_escaped(std::ostream &out, const char *text)
+    {
+        for (const char *c = text; *c; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+            {
+                out << '\\';
+            }
+            out << *c;
+        }
+    }
+}
+
+const char *const Profiler::frame_zone = "frame";
+
+/// <summary>
+/// Gets the time on the profiler's clock.
+/// </summary>
+/// <returns>Nanoseconds since the profiler started.</returns>
+std::uint64_t Profiler::now()
+{
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+}
+
+/// <summary>
+/// Records a zone in the calling thread's ring. If the ring is full the
+/// zone is counted as dropped rather than waiting.
+/// </summary>
+/// <param name="name">The zone's name.</param>
+/// <param name="start">When it started, from now().</param>
+/// <param name="end">When it ended, from now().</param>
+void Profiler::record(const char *name, std::uint64_t start, std::uint64_t end)
+{
+    Ring &ring = local_ring();
+    const std::uint64_t head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) >= ring_capacity)
+    {
+        ring.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring.events[head % ring_capacity] = {name, start, end};
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+/// <summary>
+/// Ends a frame: records the frame zone, drains every thread's zones and
+/// adds each zone's total for the frame to its rolling window.
+/// </summary>
+void Profiler::end_frame()
+{
+    const std::uint64_t end = now();
+    if (last_frame_end != 0)
+    {
+        record(frame_zone, last_frame_end, end);
+    }
+    last_frame_end = end;
+
+    drain();
+
+    for (auto &entry : windows)
+    {
+        Window &window = entry.second;
+        if (!window.ran)
+        {
+            continue;
+        }
+
+        window.ms[window.next] = window.this_frame;
+        window.next = (window.next + 1) % window_frames;
+        window.count = std::min(window.count + 1, window_frames);
+        window.this_frame = 0.0;
+        window.ran = false;
+    }
+}
+
+/// <summary>
+/// Works out the percentiles of every zone's rolling window.
+/// </summary>
+/// <param name="out">Receives a summary per zone.</param>
+void Profiler::get_summaries(std::vector<Summary> &out)
+{
+    out.clear();
+    std::vector<double> sorted;
+    for (const auto &entry : windows)
+    {
+        const Window &window = entry.second;
+        if (window.count == 0)
+        {
+            continue;
+        }
+
+        sorted.assign(window.ms.begin(), window.ms.begin() + window.count);
+        std::sort(sorted.begin(), sorted.end());
+        out.push_back({window.name, percentile(sorted, 0.5), percentile(sorted, 0.95), percentile(sorted, 0.99),
+                       sorted.back(), window.count});
+    }
+
+    std::sort(out.begin(), out.end(), [](const Summary &a, const Summary &b)
+    {
+        const bool a_frame = std::strcmp(a.name, frame_zone) == 0;
+        const bool b_frame = std::strcmp(b.name, frame_zone) == 0;
+        if (a_frame != b_frame)
+        {
+            return a_frame;
+        }
+        return a.p95 > b.p95;
+    });
+}
+
+/// <summary>
+/// Starts keeping every zone for a trace.
+/// </summary>
+void Profiler::start_trace()
+{
+    tracing = true;
+}
+
+/// <summary>
+/// Gets whether zones are being kept for a trace.
+/// </summary>
+/// <returns>Whether start_trace has been called.</returns>
+bool Profiler::is_tracing()
+{
+    return tracing;
+}
+
+/// <summary>
+/// Writes the trace as complete ("X") events, one track per thread.
+/// </summary>
+/// <param name="file_path">Where to write the JSON.</param>
+/// <returns>Whether the file was written.</returns>
+bool Profiler::write_trace(const std::string &file_path)
+{
+    drain();
+
+    std::ofstream out(file_path);
+    if (!out)
+    {
+        return false;
+    }
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    char numbers[64];
+    for (std::size_t i = 0; i < trace.size(); ++i)
+    {
+        const TraceEvent &event = trace[i];
+        out << (i == 0 ? "\n" : ",\n") << "{\"name\":\"";
+        write_escaped(out, event.name);
+        // Trace timestamps are in microseconds.
+        std::snprintf(numbers, sizeof(numbers), "%.3f,\"dur\":%.3f", event.start / 1000.0, (event.end - event.start) / 1000.0);
+        out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread << ",\"ts\":" << numbers << "}";
+    }
+    out << "\n]}\n";
+
+    return static_cast<bool>(out);
+}
+
+/// <summary>
+/// Gets how many zones were lost to full rings.
+/// </summary>
+/// <returns>The count, over every thread.</returns>
+std::uint64_t Profiler::get_dropped()
+{
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    std::uint64_t dropped = 0;
+    for (const std::shared_ptr<Ring> &ring : rings)
+    {
+        dropped += ring->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
+
+/// <summary>
+/// Keeps a copy of a name for the rest of the program.
+/// </summary>
+/// <param name="name">The name.</param>
+/// <returns>The copy. The same for every call with the same name.</returns>
+const char *Profiler::intern(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(names_mutex);
+    auto found = names_by_value.find(name);
+    if (found != names_by_value.end())
+    {
+        return found->second;
+    }
+
+    names.push_back(name);
+    const char *copy = names.back().c_str();
+    names_by_value.emplace(name, copy);
+    return copy;
+}
+
+/// <summary>
+/// Gets a type's name as written in code, where the compiler can say.
+/// </summary>
+/// <param name="type">The type.</param>
+/// <returns>The interned name.</returns>
+const char *Profiler::type_name(const std::type_info &type)
+{
+#if defined(__GNUG__)
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+    if (status == 0 && demangled)
+    {
+        const char *name = intern(demangled);
+        std::free(demangled);
+        return name;
+    }
+    std::free(demangled);
+#endif
+    return intern(type.name());
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+// Profiler
+// Times named zones of code. A zone is a scope opened with PROFILE_ZONE;
+// its start and end, in nanoseconds, go into a ring buffer owned by the
+// thread it ran on, so recording takes no lock. Once a frame the main
+// thread drains every ring in end_frame(): zone times are summed per frame
+// into rolling windows for percentiles, and kept for a Chrome trace if one
+// is being recorded. Zone names must outlive the profiler, e.g. literals
+// or names from intern().
+class Profiler
+{
+public:
+    // Times the scope it lives in.
+    class Zone
+    {
+    public:
+        explicit Zone(const char *name) : m_name(name), m_start(now()) {}
+        ~Zone() { record(m_name, m_start, now()); }
+
+        Zone(const Zone &) = delete;
+        Zone &operator=(const Zone &) = delete;
+
+    private:
+        const char *m_name;
+        std::uint64_t m_start;
+    };
+
+    // A zone's time per frame it ran in, over the rolling window, in ms.
+    struct Summary
+    {
+        const char *name;
+        double p50;
+        double p95;
+        double p99;
+        double max;
+        std::size_t frames;
+    };
+
+    // Frames in the rolling window.
+    static constexpr std::size_t window_frames = 240;
+    // Zones each thread can hold between two end_frame() calls.
+    static constexpr std::size_t ring_capacity = 1 << 14;
+    // Name of the zone end_frame() records for the whole frame.
+    static const char *const frame_zone;
+
+    // Nanoseconds since the profiler started.
+    static std::uint64_t now();
+    static void record(const char *name, std::uint64_t start, std::uint64_t end);
+
+    // Drains every thread's zones and closes the frame. Call from one thread.
+    static void end_frame();
+
+    // The frame zone first, then the rest by p95, slowest first.
+    static void get_summaries(std::vector<Summary> &out);
+
+    // Keeps every zone from now on, for write_trace().
+    static void start_trace();
+    static bool is_tracing();
+    // Writes the zones kept so far as Chrome trace-event JSON, for
+    // chrome://tracing or Perfetto. Returns false if the file can't be written.
+    static bool write_trace(const std::string &file_path);
+
+    // Zones lost because a thread's ring was full.
+    static std::uint64_t get_dropped();
+
+    // A copy of name that lives as long as the program, for zone names
+    // built at run time. The same name always gives the same pointer.
+    static const char *intern(const std::string &name);
+    // The readable name of a type, interned.
+    static const char *type_name(const std::type_info &type);
+};
+
+// Profiling can be compiled out with CUBEZONE_NO_PROFILER.
+#ifdef CUBEZONE_NO_PROFILER
+#define PROFILE_ZONE(name) ((void)0)
+#else
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) Profiler::Zone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#endif
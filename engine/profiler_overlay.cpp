@@ -0,0 +1,62 @@
+#include "profiler_overlay.hpp"
+#include <cstdio>
+#include <string>
+
+namespace
+{
+    constexpr unsigned int character_size = 16;
+}
+
+/// <summary>
+/// Makes the overlay.
+/// </summary>
+/// <param name="font_path">Path to the font for the text. A monospaced one keeps the columns lined up.</param>
+ProfilerOverlay::ProfilerOverlay(const std::string &font_path)
+    : m_ui(font_path, character_size), m_since_refresh(refresh_interval)
+{
+    m_ui.add_panel(sf::Vector2f(620.0f, (zones_shown + 3) * 20.0f), sf::Color(0, 0, 0, 160), UiLayer::ANCHOR_TOP_LEFT);
+    m_text = m_ui.add_text("", character_size, sf::Color::White, UiLayer::ANCHOR_TOP_LEFT, sf::Vector2f(8.0f, 8.0f));
+}
+
+/// <summary>
+/// Refreshes the text when it is due and queues the overlay in screen space.
+/// </summary>
+/// <param name="dt">Seconds since the last call.</param>
+void ProfilerOverlay::render(float dt)
+{
+    m_since_refresh += dt;
+    if (m_since_refresh >= refresh_interval)
+    {
+        m_since_refresh = 0.0f;
+        refresh();
+    }
+
+    m_ui.render();
+}
+
+/// <summary>
+/// Rebuilds the text from the profiler's summaries.
+/// </summary>
+void ProfilerOverlay::refresh()
+{
+    Profiler::get_summaries(m_summaries);
+
+    char line[128];
+    std::snprintf(line, sizeof(line), "%-24s %7s %7s %7s %7s\n", "zone (ms)", "p50", "p95", "p99", "max");
+    std::string text = line;
+    for (std::size_t i = 0; i < m_summaries.size() && i <= zones_shown; ++i)
+    {
+        const Profiler::Summary &summary = m_summaries[i];
+        std::snprintf(line, sizeof(line), "%-24.24s %7.2f %7.2f %7.2f %7.2f\n",
+                      summary.name, summary.p50, summary.p95, summary.p99, summary.max);
+        text += line;
+    }
+
+    const std::uint64_t dropped = Profiler::get_dropped();
+    if (dropped > 0)
+    {
+        text += "dropped zones: " + std::to_string(dropped) + "\n";
+    }
+
+    m_ui.set_text(m_text, text);
+}
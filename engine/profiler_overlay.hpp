@@ -0,0 +1,33 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <memory>
+#include <vector>
+#include "profiler.hpp"
+#include "ui_layer.hpp"
+
+// ProfilerOverlay
+// Shows the Profiler's rolling percentiles in the top left corner: the
+// whole frame, then the slowest zones. The text is only rebuilt a few
+// times a second, so the overlay does not cost a layout every frame.
+class ProfilerOverlay
+{
+public:
+    explicit ProfilerOverlay(const std::string &font_path);
+
+    // Refreshes the text when it is due and queues the overlay.
+    void render(float dt);
+
+    // Zones listed under the frame.
+    static constexpr std::size_t zones_shown = 10;
+    // Seconds between refreshes.
+    static constexpr float refresh_interval = 0.5f;
+
+private:
+    UiLayer m_ui;
+    UiLayer::Element m_text;
+    float m_since_refresh;
+    std::vector<Profiler::Summary> m_summaries;
+
+    void refresh();
+};
@@ -0,0 +1,210 @@
+#include "projectile_buffer.hpp"
+#include <cmath>
+
+namespace
+{
+    // Size of the disc texture in pixels.
+    constexpr unsigned int disc_size = 32;
+}
+
+/// <summary>
+/// Adds a projectile.
+/// </summary>
+/// <param name="projectile">Its starting state.</param>
+/// <returns>Its index, valid until the next remove_dead().</returns>
+std::size_t ProjectileBuffer::spawn(const Spawn &projectile)
+{
+    m_x.push_back(projectile.position.x);
+    m_y.push_back(projectile.position.y);
+    m_previous_x.push_back(projectile.position.x);
+    m_previous_y.push_back(projectile.position.y);
+    m_velocity_x.push_back(projectile.velocity.x);
+    m_velocity_y.push_back(projectile.velocity.y);
+    m_lifetime.push_back(projectile.lifetime);
+    m_damage.push_back(projectile.damage);
+    m_radius.push_back(projectile.radius);
+    m_color.push_back(projectile.color);
+    m_hit_mask.push_back(projectile.hit_mask);
+    m_owner.push_back(projectile.owner);
+    return m_x.size() - 1;
+}
+
+/// <summary>
+/// Removes every projectile. Keeps the memory.
+/// </summary>
+void ProjectileBuffer::clear()
+{
+    m_x.clear();
+    m_y.clear();
+    m_previous_x.clear();
+    m_previous_y.clear();
+    m_velocity_x.clear();
+    m_velocity_y.clear();
+    m_lifetime.clear();
+    m_damage.clear();
+    m_radius.clear();
+    m_color.clear();
+    m_hit_mask.clear();
+    m_owner.clear();
+    m_vertex_count = 0;
+}
+
+/// <summary>
+/// Moves and ages a range of projectiles.
+/// </summary>
+/// <param name="begin">First projectile.</param>
+/// <param name="end">One past the last projectile.</param>
+/// <param name="dt">Delta Time - linked to frame rate.</param>
+void ProjectileBuffer::integrate(std::size_t begin, std::size_t end, float dt)
+{
+    float *x = m_x.data();
+    float *y = m_y.data();
+    float *previous_x = m_previous_x.data();
+    float *previous_y = m_previous_y.data();
+    const float *velocity_x = m_velocity_x.data();
+    const float *velocity_y = m_velocity_y.data();
+    float *lifetime = m_lifetime.data();
+
+    for (std::size_t i = begin; i < end; ++i)
+    {
+        previous_x[i] = x[i];
+        previous_y[i] = y[i];
+        x[i] += velocity_x[i] * dt;
+        y[i] += velocity_y[i] * dt;
+        lifetime[i] -= dt;
+    }
+}
+
+/// <summary>
+/// Removes the dead projectiles with swap-and-pop.
+/// </summary>
+void ProjectileBuffer::remove_dead()
+{
+    std::size_t i = 0;
+    while (i < m_x.size())
+    {
+        if (m_lifetime[i] > 0.0f)
+        {
+            ++i;
+            continue;
+        }
+
+        // The moved-in projectile is checked on the next pass round.
+        if (i != m_x.size() - 1)
+        {
+            move_to(m_x.size() - 1, i);
+        }
+        pop_back();
+    }
+}
+
+/// <summary>
+/// Builds two triangles per projectile in bounds, sized to its radius.
+/// Also makes the disc the first time, and uploads it as a texture, which
+/// needs a graphics context, unless told not to.
+/// </summary>
+/// <param name="alpha">How far between the previous and current position to draw.</param>
+/// <param name="bounds">World area that can be seen.</param>
+/// <param name="upload">Whether to make the disc into a GPU texture.</param>
+void ProjectileBuffer::prepare(float alpha, const sf::FloatRect &bounds, bool upload)
+{
+    if (!m_disc_ready)
+    {
+        m_disc.create(disc_size, disc_size, sf::Color::Transparent);
+        const float centre = disc_size / 2.0f;
+        for (unsigned int py = 0; py < disc_size; ++py)
+        {
+            for (unsigned int px = 0; px < disc_size; ++px)
+            {
+                const float dx = px + 0.5f - centre;
+                const float dy = py + 0.5f - centre;
+                const float edge = centre - std::sqrt(dx * dx + dy * dy);
+                const float coverage = std::fmin(std::fmax(edge, 0.0f), 1.0f);
+                m_disc.setPixel(px, py, sf::Color(255, 255, 255, static_cast<sf::Uint8>(coverage * 255.0f)));
+            }
+        }
+        m_disc_ready = true;
+    }
+
+    m_upload = upload;
+    if (upload && !m_texture_ready)
+    {
+        m_texture_ready = m_texture.loadFromImage(m_disc);
+        m_texture.setSmooth(true);
+    }
+
+    // Only ever grows, so the loop just writes fields over old vertices.
+    if (m_vertices.size() < m_x.size() * 6)
+    {
+        m_vertices.resize(m_x.size() * 6);
+    }
+    sf::Vertex *out = m_vertices.data();
+    const float full = static_cast<float>(disc_size);
+    const float right = bounds.left + bounds.width;
+    const float bottom = bounds.top + bounds.height;
+
+    for (std::size_t i = 0; i < m_x.size(); ++i)
+    {
+        const float x = m_previous_x[i] + (m_x[i] - m_previous_x[i]) * alpha;
+        const float y = m_previous_y[i] + (m_y[i] - m_previous_y[i]) * alpha;
+        if (x < bounds.left || x >= right || y < bounds.top || y >= bottom)
+        {
+            continue;
+        }
+
+        const float r = m_radius[i];
+        const sf::Vector2f corners[6] = {{x - r, y - r}, {x + r, y - r}, {x + r, y + r},
+                                         {x - r, y - r}, {x + r, y + r}, {x - r, y + r}};
+        const sf::Vector2f uvs[6] = {{0.0f, 0.0f}, {full, 0.0f}, {full, full},
+                                     {0.0f, 0.0f}, {full, full}, {0.0f, full}};
+        for (int v = 0; v < 6; ++v)
+        {
+            out[v].position = corners[v];
+            out[v].color = m_color[i];
+            out[v].texCoords = uvs[v];
+        }
+        out += 6;
+    }
+
+    m_vertex_count = static_cast<std::size_t>(out - m_vertices.data());
+}
+
+/// <summary>
+/// Copies one projectile over another.
+/// </summary>
+/// <param name="from">Index to copy.</param>
+/// <param name="to">Index to overwrite.</param>
+void ProjectileBuffer::move_to(std::size_t from, std::size_t to)
+{
+    m_x[to] = m_x[from];
+    m_y[to] = m_y[from];
+    m_previous_x[to] = m_previous_x[from];
+    m_previous_y[to] = m_previous_y[from];
+    m_velocity_x[to] = m_velocity_x[from];
+    m_velocity_y[to] = m_velocity_y[from];
+    m_lifetime[to] = m_lifetime[from];
+    m_damage[to] = m_damage[from];
+    m_radius[to] = m_radius[from];
+    m_color[to] = m_color[from];
+    m_hit_mask[to] = m_hit_mask[from];
+    m_owner[to] = m_owner[from];
+}
+
+/// <summary>
+/// Drops the last projectile.
+/// </summary>
+void ProjectileBuffer::pop_back()
+{
+    m_x.pop_back();
+    m_y.pop_back();
+    m_previous_x.pop_back();
+    m_previous_y.pop_back();
+    m_velocity_x.pop_back();
+    m_velocity_y.pop_back();
+    m_lifetime.pop_back();
+    m_damage.pop_back();
+    m_radius.pop_back();
+    m_color.pop_back();
+    m_hit_mask.pop_back();
+    m_owner.pop_back();
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include "ecm.hpp"
+#include "entity_handle.hpp"
+#include <cstdint>
+#include <vector>
+
+// ProjectileBuffer
+// Every live projectile in a scene, stored as structure-of-arrays so the
+// per-frame loops run over plain float arrays the compiler can vectorize.
+// Projectiles are not entities: they have no components, are removed with
+// swap-and-pop, and are all drawn as one textured triangle list.
+class ProjectileBuffer
+{
+public:
+    struct Spawn
+    {
+        sf::Vector2f position;
+        sf::Vector2f velocity;
+        float lifetime = 3.0f;
+        float damage = 0.0f;
+        float radius = 3.0f;
+        sf::Color color = sf::Color::White;
+        LayerMask hit_mask = LAYER_PLAYER | LAYER_ENEMY;
+        EntityHandle owner;
+    };
+
+    std::size_t spawn(const Spawn &projectile);
+    void clear();
+    std::size_t size() const { return m_x.size(); }
+
+    // Moves projectiles [begin, end) by their velocity and ages them. Ranges
+    // do not share data, so disjoint ranges can be integrated in parallel.
+    void integrate(std::size_t begin, std::size_t end, float dt);
+    void integrate(float dt) { integrate(0, size(), dt); }
+
+    // Marks a projectile for removal by remove_dead().
+    void kill(std::size_t index) { m_lifetime[index] = 0.0f; }
+    bool is_dead(std::size_t index) const { return m_lifetime[index] <= 0.0f; }
+    // Removes dead projectiles. Moves the last ones into their places.
+    void remove_dead();
+
+    // Builds the vertices for the projectiles inside bounds, each drawn
+    // between its last two positions. Without upload the disc is never made
+    // into a GPU texture; get_texture() then only names get_image(), for
+    // the software rasterizer.
+    void prepare(float alpha, const sf::FloatRect &bounds, bool upload = true);
+    std::size_t get_prepared_count() const { return m_vertex_count / 6; }
+    // The prepared triangle list and the texture to draw it with.
+    const sf::Vertex *get_vertices() const { return m_vertices.data(); }
+    std::size_t get_vertex_count() const { return m_vertex_count; }
+    const sf::Texture *get_texture() const { return (m_texture_ready || (m_disc_ready && !m_upload)) ? &m_texture : nullptr; }
+    const sf::Image &get_image() const { return m_disc; }
+
+    // Per-projectile data, indexed 0 to size() - 1.
+    sf::Vector2f get_position(std::size_t index) const { return {m_x[index], m_y[index]}; }
+    sf::Vector2f get_previous_position(std::size_t index) const { return {m_previous_x[index], m_previous_y[index]}; }
+    float get_damage(std::size_t index) const { return m_damage[index]; }
+    LayerMask get_hit_mask(std::size_t index) const { return m_hit_mask[index]; }
+    EntityHandle get_owner(std::size_t index) const { return m_owner[index]; }
+
+private:
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_previous_x;
+    std::vector<float> m_previous_y;
+    std::vector<float> m_velocity_x;
+    std::vector<float> m_velocity_y;
+    std::vector<float> m_lifetime;
+    std::vector<float> m_damage;
+    std::vector<float> m_radius;
+    std::vector<sf::Color> m_color;
+    std::vector<LayerMask> m_hit_mask;
+    std::vector<EntityHandle> m_owner;
+
+    std::vector<sf::Vertex> m_vertices;    // reused between frames, only the first m_vertex_count are drawn
+    std::size_t m_vertex_count = 0;
+    sf::Image m_disc;           // a soft-edged disc every projectile is drawn with
+    sf::Texture m_texture;      // m_disc on the GPU
+    bool m_disc_ready = false;
+    bool m_texture_ready = false;   // uploaded
+    bool m_upload = true;           // as last passed to prepare()
+
+    void move_to(std::size_t from, std::size_t to);
+    void pop_back();
+};
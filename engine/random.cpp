@@ -0,0 +1,63 @@
+#include "random.hpp"
+
+static std::uint32_t current_seed = std::random_device{}();
+static std::mt19937 generator(current_seed);
+
+/// <summary>
+/// Restarts the generator from a seed.
+/// </summary>
+/// <param name="seed">The seed.</param>
+void Random::seed(std::uint32_t seed)
+{
+    current_seed = seed;
+    generator.seed(seed);
+}
+
+/// <summary>
+/// Gets the seed the generator was last started from.
+/// </summary>
+/// <returns>The seed.</returns>
+std::uint32_t Random::get_seed()
+{
+    return current_seed;
+}
+
+/// <summary>
+/// Gets the shared generator.
+/// </summary>
+/// <returns>The generator.</returns>
+std::mt19937 &Random::engine()
+{
+    return generator;
+}
+
+/// <summary>
+/// Draws a seed for a separate generator.
+/// </summary>
+/// <returns>The seed.</returns>
+std::uint32_t Random::next_seed()
+{
+    return generator();
+}
+
+/// <summary>
+/// Draws an integer between min and max, both included.
+/// </summary>
+/// <param name="min">Smallest value.</param>
+/// <param name="max">Largest value.</param>
+/// <returns>The value.</returns>
+int Random::range(int min, int max)
+{
+    return std::uniform_int_distribution<int>(min, max)(generator);
+}
+
+/// <summary>
+/// Draws a float between min and max.
+/// </summary>
+/// <param name="min">Smallest value.</param>
+/// <param name="max">Largest value.</param>
+/// <returns>The value.</returns>
+float Random::range(float min, float max)
+{
+    return std::uniform_real_distribution<float>(min, max)(generator);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+
+// One seeded generator for the whole game, so a run can be repeated from its
+// seed. Main thread only; anything updated in parallel should take its own
+// generator seeded from next_seed().
+namespace Random
+{
+    void seed(std::uint32_t seed);
+    std::uint32_t get_seed();
+
+    std::mt19937 &engine();
+
+    // A seed for a component's own generator.
+    std::uint32_t next_seed();
+
+    int range(int min, int max);            // inclusive
+    float range(float min, float max);
+};
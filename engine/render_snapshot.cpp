@@ -0,0 +1,40 @@
+#include "render_snapshot.hpp"
+
+/// <summary>
+/// Empties the snapshot.
+/// </summary>
+void RenderSnapshot::clear()
+{
+    vertices.clear();
+    texts.clear();
+    batches.clear();
+    screen_first = 0;
+}
+
+/// <summary>
+/// Draws the frame: clears, sets the view, then draws each batch in order,
+/// switching to the screen view for the screen-space batches.
+/// </summary>
+/// <param name="target">Where to draw.</param>
+void RenderSnapshot::draw(sf::RenderTarget &target) const
+{
+    target.clear(clear_color);
+    target.setView(view);
+
+    for (std::size_t i = 0; i < batches.size(); ++i)
+    {
+        if (i == screen_first)
+        {
+            target.setView(screen_view);
+        }
+
+        const Batch &batch = batches[i];
+        if (batch.text)
+        {
+            target.draw(texts[batch.first]);
+            continue;
+        }
+
+        target.draw(&vertices[batch.first], batch.count, batch.type, sf::RenderStates(batch.texture));
+    }
+}
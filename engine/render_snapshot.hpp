@@ -0,0 +1,41 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <vector>
+
+// RenderSnapshot
+// One frame's drawing, copied out of the scene: the view, every vertex and
+// the texture each run of vertices is drawn with. Nothing in it points at
+// entities or components, so it can be drawn on another thread while the
+// next frame is simulated. Textures and fonts are referenced rather than
+// copied; they belong to the ResourceCache and TextureAtlas.
+struct RenderSnapshot
+{
+    // A run of vertices drawn in one call, or one text.
+    struct Batch
+    {
+        std::size_t first;          // into vertices, or into texts for a text
+        std::size_t count;
+        sf::PrimitiveType type;
+        const sf::Texture *texture;
+        bool text;
+    };
+
+    sf::View view;
+    // Batches from screen_first on are drawn with screen_view, one pixel
+    // per unit from the top left, e.g. the HUD.
+    sf::View screen_view;
+    std::size_t screen_first = 0;
+    sf::Color clear_color = sf::Color::Black;
+    std::vector<sf::Vertex> vertices;
+    std::vector<sf::Text> texts;
+    std::vector<Batch> batches;
+
+    // Empties the frame. Keeps the memory for the next one.
+    void clear();
+    // Clears target and draws the frame on it.
+    void draw(sf::RenderTarget &target) const;
+
+    unsigned int get_draw_calls() const { return static_cast<unsigned int>(batches.size()); }
+};
@@ -0,0 +1,160 @@
+#include "render_thread.hpp"
+#include "profiler.hpp"
+#include <stdexcept>
+
+/// <summary>
+/// Makes a render thread for a window. Nothing runs until start().
+/// </summary>
+/// <param name="window">The window to draw to. Must outlive the thread.</param>
+RenderThread::RenderThread(sf::RenderWindow &window) : m_window(window)
+{
+}
+
+/// <summary>
+/// Stops the thread if it is running.
+/// </summary>
+RenderThread::~RenderThread()
+{
+    stop();
+}
+
+/// <summary>
+/// Hands the window's context to a new thread and starts drawing.
+/// </summary>
+void RenderThread::start()
+{
+    if (m_thread.joinable())
+    {
+        throw std::logic_error("The render thread is already running.");
+    }
+
+    // A context can only be active on one thread at a time.
+    m_window.setActive(false);
+    m_running = true;
+    m_thread = std::thread(&RenderThread::run, this);
+}
+
+/// <summary>
+/// Stops drawing and gives the window's context back to the calling thread.
+/// </summary>
+void RenderThread::stop()
+{
+    if (!m_thread.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+
+    m_ready = none;
+    m_idle.notify_all();
+    m_window.setActive(true);
+}
+
+/// <summary>
+/// Gets the snapshot for the simulation to fill.
+/// </summary>
+/// <returns>The snapshot, which the render thread does not touch until submit().</returns>
+RenderSnapshot &RenderThread::acquire()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_snapshots[m_filling];
+}
+
+/// <summary>
+/// Queues the filled snapshot to be drawn and moves the simulation on to a
+/// free one. A queued snapshot that was never drawn is dropped.
+/// </summary>
+void RenderThread::submit()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_ready != none)
+        {
+            ++m_frames_dropped;
+        }
+
+        m_ready = m_filling;
+
+        // Three snapshots and at most two taken, so one is always free.
+        for (int i = 0; i < static_cast<int>(m_snapshots.size()); ++i)
+        {
+            if (i != m_ready && i != m_drawing)
+            {
+                m_filling = i;
+                break;
+            }
+        }
+    }
+    m_wake.notify_one();
+}
+
+/// <summary>
+/// Waits until nothing is queued or being drawn.
+/// </summary>
+void RenderThread::wait_idle()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this] { return !m_running || (m_ready == none && m_drawing == none); });
+}
+
+/// <summary>
+/// Gets how many frames have been drawn.
+/// </summary>
+/// <returns>The frame count.</returns>
+std::uint64_t RenderThread::get_frames_drawn()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_frames_drawn;
+}
+
+/// <summary>
+/// Gets how many frames were replaced by a newer one before being drawn.
+/// </summary>
+/// <returns>The frame count.</returns>
+std::uint64_t RenderThread::get_frames_dropped()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_frames_dropped;
+}
+
+/// <summary>
+/// The render thread: waits for a snapshot, draws it and shows it.
+/// </summary>
+void RenderThread::run()
+{
+    m_window.setActive(true);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_wake.wait(lock, [this] { return !m_running || m_ready != none; });
+        if (!m_running)
+        {
+            break;
+        }
+
+        m_drawing = m_ready;
+        m_ready = none;
+        const RenderSnapshot &snapshot = m_snapshots[m_drawing];
+
+        lock.unlock();
+        {
+            PROFILE_ZONE("RenderThread::draw");
+            snapshot.draw(m_window);
+            m_window.display();
+        }
+        lock.lock();
+
+        m_drawing = none;
+        ++m_frames_drawn;
+        m_idle.notify_all();
+    }
+
+    m_window.setActive(false);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include "render_snapshot.hpp"
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+// RenderThread
+// Draws RenderSnapshots on its own thread, which holds the window's
+// graphics context while it runs. Events are still polled on the thread
+// that made the window. Snapshots are triple buffered: one being drawn,
+// one waiting to be drawn and one being filled by the simulation. If the
+// simulation finishes a frame before the waiting one was picked up, the
+// newer frame replaces it, so the simulation never waits on drawing.
+class RenderThread
+{
+public:
+    explicit RenderThread(sf::RenderWindow &window);
+    ~RenderThread();
+
+    RenderThread(const RenderThread &) = delete;
+    RenderThread &operator=(const RenderThread &) = delete;
+
+    void start();
+    // Stops after the frame being drawn. Frames not yet drawn are dropped.
+    void stop();
+
+    // The snapshot to fill for the next frame. Simulation thread only.
+    RenderSnapshot &acquire();
+    // Hands the filled snapshot over to be drawn.
+    void submit();
+    // Waits until every submitted snapshot has been drawn, e.g. before the
+    // textures they use are changed or freed.
+    void wait_idle();
+
+    std::uint64_t get_frames_drawn();
+    std::uint64_t get_frames_dropped();
+
+private:
+    static constexpr int none = -1;
+
+    sf::RenderWindow &m_window;
+    std::array<RenderSnapshot, 3> m_snapshots;
+    int m_filling = 0;          // the simulation's
+    int m_ready = none;         // next to draw
+    int m_drawing = none;       // the render thread's
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;     // a frame is ready or it is time to stop
+    std::condition_variable m_idle;     // a frame finished drawing
+    bool m_running = false;
+    std::uint64_t m_frames_drawn = 0;
+    std::uint64_t m_frames_dropped = 0;
+    std::thread m_thread;
+
+    void run();
+};
@@ -1,9 +1,23 @@
 #include "renderer.hpp"
-#include <queue>
+#include "render_thread.hpp"
+#include "software_rasterizer.hpp"
+#include "sprite_batch.hpp"
+#include "game_parameters.hpp"
+#include "profiler.hpp"
+#include <memory>
 
-static std::queue<const sf::Drawable *> sprites;
-static sf::RenderWindow *window;
-static sf::View *view;
+static SpriteBatch batch;
+static SpriteBatch screen_batch;                    // drawn after batch, in screen space
+static RenderSnapshot snapshot;                     // the frame, when drawn on this thread
+static std::unique_ptr<RenderThread> render_thread;
+static unsigned int draw_calls = 0;
+static std::unique_ptr<SoftwareRasterizer> rasterizer;  // instead of a window, see init_software
+static sf::View software_view;
+static sf::RenderWindow *window = nullptr;
+static sf::View *view = nullptr;
+static float interpolation = 1.0f;
+static Renderer::CullStats collecting;
+static Renderer::CullStats last_frame;
 
 /// <summary>
 /// Intialises the render window.
@@ -35,41 +49,279 @@ sf::View &Renderer::getView()
 }
 
 /// <summary>
-/// Shuts down the renderer.
-/// Pops all sprites.
+/// Gets whether there is a window to draw to.
 /// </summary>
-void Renderer::shutdown()
+/// <returns>Whether a window has been set.</returns>
+bool Renderer::has_window()
 {
-    while (!sprites.empty())
+    return window != nullptr;
+}
+
+/// <summary>
+/// Draws into memory from now on, with no window or GPU.
+/// </summary>
+/// <param name="width">Framebuffer width in pixels.</param>
+/// <param name="height">Framebuffer height in pixels.</param>
+void Renderer::init_software(unsigned int width, unsigned int height)
+{
+    if(window != nullptr)
     {
-        sprites.pop();
+        throw std::logic_error("The renderer already draws to a window.");
     }
+
+    rasterizer = std::make_unique<SoftwareRasterizer>(width, height);
+    software_view.reset(sf::FloatRect(0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height)));
+    view = &software_view;
 }
 
 /// <summary>
-/// Renders sprites.
+/// Gets whether frames are drawn by the software rasterizer.
 /// </summary>
-void Renderer::render()
+/// <returns>Whether init_software has been called.</returns>
+bool Renderer::is_software()
+{
+    return rasterizer != nullptr;
+}
+
+/// <summary>
+/// Gets the software framebuffer.
+/// </summary>
+/// <returns>The rasterizer, or nullptr when drawing to a window.</returns>
+const SoftwareRasterizer *Renderer::get_software_target()
+{
+    return rasterizer.get();
+}
+
+/// <summary>
+/// Gets whether there is anywhere to draw to.
+/// </summary>
+/// <returns>Whether there is a window or a software framebuffer.</returns>
+bool Renderer::has_target()
+{
+    return window != nullptr || rasterizer != nullptr;
+}
+
+/// <summary>
+/// Gives the software rasterizer the pixels of a texture. Only the first
+/// image given for a texture is kept.
+/// </summary>
+/// <param name="texture">The texture, as queued.</param>
+/// <param name="image">Its pixels.</param>
+void Renderer::set_texture_image(const sf::Texture *texture, const sf::Image &image)
+{
+    if(rasterizer && texture && !rasterizer->has_image(texture))
+    {
+        rasterizer->set_image(texture, image);
+    }
+}
+
+/// <summary>
+/// Gives the software rasterizer the pixels of a texture, replacing any it
+/// already has, e.g. after more images are packed into an atlas.
+/// </summary>
+/// <param name="texture">The texture, as queued.</param>
+/// <param name="image">Its pixels.</param>
+void Renderer::update_texture_image(const sf::Texture *texture, const sf::Image &image)
+{
+    if(rasterizer && texture)
+    {
+        rasterizer->set_image(texture, image);
+    }
+}
+
+/// <summary>
+/// Starts drawing on a separate thread.
+/// </summary>
+void Renderer::start_render_thread()
 {
     if(window == nullptr)
     {
         throw std::logic_error("No render window is set.");
     }
 
-    while(!sprites.empty())
+    if(render_thread)
+    {
+        return;
+    }
+
+    render_thread = std::make_unique<RenderThread>(*window);
+    render_thread->start();
+}
+
+/// <summary>
+/// Gets whether frames are drawn on a separate thread.
+/// </summary>
+/// <returns>Whether the render thread is running.</returns>
+bool Renderer::has_render_thread()
+{
+    return render_thread != nullptr;
+}
+
+/// <summary>
+/// Waits for the render thread to finish the frames handed to it.
+/// Does nothing without a render thread.
+/// </summary>
+void Renderer::sync()
+{
+    if(render_thread)
+    {
+        render_thread->wait_idle();
+    }
+}
+
+/// <summary>
+/// Shuts down the renderer.
+/// Stops the render thread and drops all queued sprites.
+/// </summary>
+void Renderer::shutdown()
+{
+    render_thread.reset();
+    rasterizer.reset();
+    batch.clear();
+    screen_batch.clear();
+    snapshot.clear();
+}
+
+/// <summary>
+/// Builds the frame from the queued sprites, sorted and batched by texture,
+/// then draws and shows it, or gives it to the render thread to.
+/// </summary>
+void Renderer::render()
+{
+    PROFILE_ZONE("Renderer::render");
+    if(!has_target())
+    {
+        throw std::logic_error("No render window is set.");
+    }
+
+    RenderSnapshot &frame = render_thread ? render_thread->acquire() : snapshot;
+    frame.clear();
+    frame.view = *view;
+    batch.build(frame);
+
+    const sf::Vector2f screen_size = get_screen_size();
+    frame.screen_view = sf::View(sf::FloatRect(0.0f, 0.0f, screen_size.x, screen_size.y));
+    frame.screen_first = frame.batches.size();
+    screen_batch.build(frame);
+    draw_calls = frame.get_draw_calls();
+
+    if(rasterizer)
+    {
+        rasterizer->draw(frame);
+    }
+    else if(render_thread)
     {
-        window->draw(*sprites.front());
-        sprites.pop();
+        render_thread->submit();
     }
+    else
+    {
+        frame.draw(*window);
+        window->display();
+    }
+
+    last_frame = collecting;
+    collecting = CullStats();
+}
+
+/// <summary>
+/// Gets the culling counts for the frame being collected.
+/// </summary>
+/// <returns>The counts, to add to.</returns>
+Renderer::CullStats &Renderer::frame_cull_stats()
+{
+    return collecting;
+}
+
+/// <summary>
+/// Gets the culling counts for the last frame drawn.
+/// </summary>
+/// <returns>The counts.</returns>
+const Renderer::CullStats &Renderer::get_cull_stats()
+{
+    return last_frame;
+}
+
+/// <summary>
+/// Gets the area of the world the view shows.
+/// Ignores view rotation, which the game does not use.
+/// </summary>
+/// <returns>The view's bounds in world coordinates.</returns>
+sf::FloatRect Renderer::get_view_bounds()
+{
+    const sf::Vector2f size = view->getSize();
+    const sf::Vector2f centre = view->getCenter();
+    return sf::FloatRect(centre.x - size.x / 2.0f, centre.y - size.y / 2.0f, size.x, size.y);
 }
 
 /// <summary>
 /// Queues the input sprite.
+/// It is copied, so it can change as soon as this returns.
 /// </summary>
 /// <param name="sprite">The sprite to queue.</param>
-void Renderer::queue(const sf::Drawable *sprite)
+/// <param name="layer">Draw order between groups; lower is further back.</param>
+/// <param name="depth">Draw order within a layer and texture.</param>
+void Renderer::queue(const sf::Drawable *sprite, std::uint8_t layer, std::uint16_t depth)
+{
+    batch.add(sprite, layer, depth);
+}
+
+/// <summary>
+/// Queues raw vertices. They are copied.
+/// </summary>
+/// <param name="vertices">The vertices.</param>
+/// <param name="count">How many vertices.</param>
+/// <param name="type">How to join them.</param>
+/// <param name="texture">Texture to draw them with, or nullptr for none.</param>
+/// <param name="layer">Draw order between groups; lower is further back.</param>
+/// <param name="depth">Draw order within a layer and texture.</param>
+void Renderer::queue_vertices(const sf::Vertex *vertices, std::size_t count, sf::PrimitiveType type,
+                              const sf::Texture *texture, std::uint8_t layer, std::uint16_t depth)
 {
-    sprites.push(sprite);
+    batch.add_vertices(vertices, count, type, texture, layer, depth);
+}
+
+/// <summary>
+/// Queues raw vertices in screen space. They are copied.
+/// </summary>
+/// <param name="vertices">The vertices, in pixels from the window's top left.</param>
+/// <param name="count">How many vertices.</param>
+/// <param name="type">How to join them.</param>
+/// <param name="texture">Texture to draw them with, or nullptr for none.</param>
+/// <param name="layer">Draw order between groups; lower is further back.</param>
+/// <param name="depth">Draw order within a layer and texture.</param>
+void Renderer::queue_screen_vertices(const sf::Vertex *vertices, std::size_t count, sf::PrimitiveType type,
+                                     const sf::Texture *texture, std::uint8_t layer, std::uint16_t depth)
+{
+    screen_batch.add_vertices(vertices, count, type, texture, layer, depth);
+}
+
+/// <summary>
+/// Gets the size of the screen space.
+/// </summary>
+/// <returns>The window's size in pixels, or the game's window size when there is none.</returns>
+sf::Vector2f Renderer::get_screen_size()
+{
+    if(rasterizer)
+    {
+        return sf::Vector2f(static_cast<float>(rasterizer->get_width()), static_cast<float>(rasterizer->get_height()));
+    }
+
+    if(window == nullptr)
+    {
+        return sf::Vector2f(static_cast<float>(params::window_width), static_cast<float>(params::window_height));
+    }
+
+    const sf::Vector2u size = window->getSize();
+    return sf::Vector2f(static_cast<float>(size.x), static_cast<float>(size.y));
+}
+
+/// <summary>
+/// Gets how many draw calls the last frame took.
+/// </summary>
+/// <returns>The draw call count.</returns>
+unsigned int Renderer::get_draw_calls()
+{
+    return draw_calls;
 }
 
 /// <summary>
@@ -79,4 +331,23 @@ void Renderer::queue(const sf::Drawable *sprite)
 void Renderer::update(const float &dt)
 {
     
-}
\ No newline at end of file
+}
+
+/// <summary>
+/// Sets how far the frame being drawn is between the previous and the
+/// current fixed update.
+/// </summary>
+/// <param name="alpha">0 draws the previous state, 1 the current one.</param>
+void Renderer::set_interpolation(float alpha)
+{
+    interpolation = alpha;
+}
+
+/// <summary>
+/// Gets the interpolation factor for the frame being drawn.
+/// </summary>
+/// <returns>The factor, from 0 to 1.</returns>
+float Renderer::get_interpolation()
+{
+    return interpolation;
+}
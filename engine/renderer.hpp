@@ -1,15 +1,83 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
+#include <cstdint>
+
+class SoftwareRasterizer;
+
+// Layers for Renderer::queue. Lower layers are drawn first.
+enum RenderLayer : std::uint8_t
+{
+    RENDER_LAYER_LEVEL = 0,
+    RENDER_LAYER_ENTITIES = 1,
+    RENDER_LAYER_PROJECTILES = 2
+};
 
 namespace Renderer
 {
     void init(sf::RenderWindow &win, sf::View &v);
     sf::RenderWindow& getWindow();
     sf::View& getView();
+    bool has_window();      // false when running headless
+    // Draws into a SoftwareRasterizer instead of a window, so a headless run
+    // can render with no GPU. The renderer owns the view.
+    void init_software(unsigned int width, unsigned int height);
+    bool is_software();
+    // The software framebuffer, or nullptr when drawing to a window.
+    const SoftwareRasterizer *get_software_target();
+    // Whether there is a window or software framebuffer to draw to.
+    bool has_target();
+    // Gives the software rasterizer a CPU copy of a texture, once. Does
+    // nothing when drawing to a window.
+    void set_texture_image(const sf::Texture *texture, const sf::Image &image);
+    // Replaces it, for a texture whose pixels change, e.g. an atlas page.
+    void update_texture_image(const sf::Texture *texture, const sf::Image &image);
     
+    // Draws on a RenderThread from now on instead of in render(). The
+    // window's context moves to that thread until shutdown().
+    void start_render_thread();
+    bool has_render_thread();
+    // Waits until the render thread has drawn every frame handed to it.
+    // Call before changing or freeing textures a queued frame may use.
+    void sync();
+
     void shutdown();
     void update(const float &dt);
-    void queue(const sf::Drawable *sprite);
+    // Copies the drawable into this frame's commands, see SpriteBatch.
+    // Sprites and shapes are batched by texture.
+    void queue(const sf::Drawable *sprite, std::uint8_t layer = RENDER_LAYER_ENTITIES, std::uint16_t depth = 0);
+    void queue_vertices(const sf::Vertex *vertices, std::size_t count, sf::PrimitiveType type,
+                        const sf::Texture *texture, std::uint8_t layer = RENDER_LAYER_ENTITIES, std::uint16_t depth = 0);
+    // Queues vertices in screen space, in pixels from the top left of the
+    // window, drawn after and over the world whatever the view, e.g. UiLayer.
+    void queue_screen_vertices(const sf::Vertex *vertices, std::size_t count, sf::PrimitiveType type,
+                               const sf::Texture *texture, std::uint8_t layer = 0, std::uint16_t depth = 0);
+    // The window's size in pixels, or the configured size when headless.
+    sf::Vector2f get_screen_size();
+
+    // Turns the queued commands into a RenderSnapshot and draws it, or hands
+    // it to the render thread.
     void render();
+    unsigned int get_draw_calls();
+
+    // What the culling pass drew and skipped in one frame.
+    struct CullStats
+    {
+        unsigned int chunks_drawn = 0;
+        unsigned int chunks_culled = 0;
+        unsigned int entities_drawn = 0;
+        unsigned int entities_culled = 0;
+    };
+
+    // Counts for the frame being collected; render() finishes them.
+    CullStats &frame_cull_stats();
+    // Counts for the last frame drawn.
+    const CullStats &get_cull_stats();
+
+    // The area of the world the view shows.
+    sf::FloatRect get_view_bounds();
+
+    // How far the frame is between the last two fixed updates, 0 to 1.
+    void set_interpolation(float alpha);
+    float get_interpolation();
 };
\ No newline at end of file
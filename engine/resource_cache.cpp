@@ -0,0 +1,237 @@
+#include "resource_cache.hpp"
+
+std::mutex ResourceCache::m_mutex;
+ResourceCache::Cache<sf::Image> ResourceCache::m_images;
+ResourceCache::Cache<sf::Texture> ResourceCache::m_textures;
+ResourceCache::Cache<sf::Font> ResourceCache::m_fonts;
+ResourceCache::Cache<SoftwareFont> ResourceCache::m_software_fonts;
+std::set<std::string> ResourceCache::m_pending;
+std::condition_variable ResourceCache::m_loaded;
+ThreadPool::TaskGroup ResourceCache::m_preloads;
+std::atomic<std::size_t> ResourceCache::m_disk_loads{0};
+
+/// <summary>
+/// Reads a resource from disk.
+/// </summary>
+/// <param name="file_path">Path to the file.</param>
+/// <returns>The resource, or nullptr if it could not be loaded.</returns>
+template <typename T>
+std::shared_ptr<const T> ResourceCache::load(const std::string &file_path)
+{
+    ++m_disk_loads;
+    std::shared_ptr<T> resource = std::make_shared<T>();
+    if (!resource->loadFromFile(file_path))
+    {
+        return nullptr;
+    }
+    return resource;
+}
+
+/// <summary>
+/// Gets a cached resource, loading it on this thread if it has not been
+/// asked for, or waiting for it if it is being loaded elsewhere. The lock
+/// is not held while loading, so loads of different files run side by side.
+/// </summary>
+/// <param name="cache">The cache for the resource type.</param>
+/// <param name="file_path">Path to the file.</param>
+/// <returns>The resource, or nullptr if it could not be loaded.</returns>
+template <typename T>
+std::shared_ptr<const T> ResourceCache::get(Cache<T> &cache, const std::string &file_path)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true)
+    {
+        auto found = cache.find(file_path);
+        if (found != cache.end())
+        {
+            return found->second;
+        }
+        if (!m_pending.count(file_path))
+        {
+            break;
+        }
+
+        // Helps run the preloads, in case no worker has picked this one up,
+        // then waits out a load another get started.
+        lock.unlock();
+        ThreadPool::shared().wait(m_preloads);
+        lock.lock();
+        m_loaded.wait(lock, [&file_path]() { return !m_pending.count(file_path); });
+    }
+
+    m_pending.insert(file_path);
+    lock.unlock();
+    std::shared_ptr<const T> resource = load<T>(file_path);
+    lock.lock();
+
+    // Failures are cached too, so a missing file is only looked for once.
+    cache[file_path] = resource;
+    m_pending.erase(file_path);
+    m_loaded.notify_all();
+    return resource;
+}
+
+/// <summary>
+/// Loads a resource on the thread pool unless it is cached or already loading.
+/// </summary>
+/// <param name="cache">The cache for the resource type.</param>
+/// <param name="file_path">Path to the file.</param>
+template <typename T>
+void ResourceCache::preload(Cache<T> &cache, const std::string &file_path)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (cache.count(file_path) || m_pending.count(file_path))
+        {
+            return;
+        }
+        m_pending.insert(file_path);
+    }
+
+    ThreadPool::shared().submit(m_preloads, [&cache, file_path]() {
+        std::shared_ptr<const T> resource = load<T>(file_path);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        cache[file_path] = resource;
+        m_pending.erase(file_path);
+        m_loaded.notify_all();
+    });
+}
+
+/// <summary>
+/// Gets a decoded image.
+/// </summary>
+/// <param name="file_path">Path to the image.</param>
+/// <returns>The image, or nullptr if it could not be loaded.</returns>
+std::shared_ptr<const sf::Image> ResourceCache::get_image(const std::string &file_path)
+{
+    return get(m_images, file_path);
+}
+
+/// <summary>
+/// Gets a texture, uploading it from the cached image the first time.
+/// Main thread only.
+/// </summary>
+/// <param name="file_path">Path to the image.</param>
+/// <returns>The texture, or nullptr if it could not be loaded.</returns>
+std::shared_ptr<const sf::Texture> ResourceCache::get_texture(const std::string &file_path)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto found = m_textures.find(file_path);
+        if (found != m_textures.end())
+        {
+            return found->second;
+        }
+    }
+
+    std::shared_ptr<const sf::Image> image = get_image(file_path);
+    std::shared_ptr<sf::Texture> texture;
+    if (image)
+    {
+        texture = std::make_shared<sf::Texture>();
+        if (!texture->loadFromImage(*image))
+        {
+            texture.reset();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_textures[file_path] = texture;
+    return texture;
+}
+
+/// <summary>
+/// Gets a font.
+/// </summary>
+/// <param name="file_path">Path to the font.</param>
+/// <returns>The font, or nullptr if it could not be loaded.</returns>
+std::shared_ptr<const sf::Font> ResourceCache::get_font(const std::string &file_path)
+{
+    return get(m_fonts, file_path);
+}
+
+/// <summary>
+/// Gets a font whose glyphs are drawn in memory, for the software renderer.
+/// </summary>
+/// <param name="file_path">Path to the font.</param>
+/// <returns>The font, or nullptr if it could not be loaded.</returns>
+std::shared_ptr<const SoftwareFont> ResourceCache::get_software_font(const std::string &file_path)
+{
+    return get(m_software_fonts, file_path);
+}
+
+/// <summary>
+/// Starts decoding an image in the background.
+/// </summary>
+/// <param name="file_path">Path to the image.</param>
+void ResourceCache::preload_image(const std::string &file_path)
+{
+    preload(m_images, file_path);
+}
+
+/// <summary>
+/// Starts loading a font in the background.
+/// </summary>
+/// <param name="file_path">Path to the font.</param>
+void ResourceCache::preload_font(const std::string &file_path)
+{
+    preload(m_fonts, file_path);
+}
+
+/// <summary>
+/// Waits for the preloads started so far, helping to run them.
+/// </summary>
+void ResourceCache::wait()
+{
+    ThreadPool::shared().wait(m_preloads);
+}
+
+namespace
+{
+    template <typename Cache>
+    void erase_unused(Cache &cache)
+    {
+        for (auto it = cache.begin(); it != cache.end();)
+        {
+            it = (it->second.use_count() <= 1) ? cache.erase(it) : std::next(it);
+        }
+    }
+}
+
+/// <summary>
+/// Drops the resources only the cache holds.
+/// Failed loads are dropped too, so they are tried again next time.
+/// </summary>
+void ResourceCache::release_unused()
+{
+    wait();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    erase_unused(m_textures);
+    erase_unused(m_images);
+    erase_unused(m_fonts);
+    erase_unused(m_software_fonts);
+}
+
+/// <summary>
+/// Drops every cached resource. Handles already given out stay valid.
+/// </summary>
+void ResourceCache::clear()
+{
+    wait();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_textures.clear();
+    m_images.clear();
+    m_fonts.clear();
+    m_software_fonts.clear();
+}
+
+/// <summary>
+/// Gets how many files have been read from disk.
+/// </summary>
+/// <returns>The count.</returns>
+std::size_t ResourceCache::get_disk_loads()
+{
+    return m_disk_loads.load();
+}
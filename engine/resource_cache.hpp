@@ -0,0 +1,63 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include "software_font.hpp"
+#include "thread_pool.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+// ResourceCache
+// Loads each image, texture and font once per path and hands out shared
+// handles to it. A resource stays cached while the cache holds it; handles
+// keep it alive after it is released. Images and fonts can be preloaded on
+// the shared thread pool. Textures need the graphics context, so they are
+// made on the thread that asks for them, from the cached image. Software
+// fonts are the same font files drawn by FreeType, for the software renderer.
+class ResourceCache
+{
+public:
+    // nullptr if the file could not be loaded.
+    static std::shared_ptr<const sf::Image> get_image(const std::string &file_path);
+    static std::shared_ptr<const sf::Texture> get_texture(const std::string &file_path);
+    static std::shared_ptr<const sf::Font> get_font(const std::string &file_path);
+    static std::shared_ptr<const SoftwareFont> get_software_font(const std::string &file_path);
+
+    // Starts loading in the background. A get for the same path waits for it.
+    static void preload_image(const std::string &file_path);
+    static void preload_font(const std::string &file_path);
+    // Waits for every preload started so far.
+    static void wait();
+
+    // Drops every resource that no one else holds a handle to.
+    static void release_unused();
+    static void clear();
+
+    // Files read from disk so far, to check that caching works.
+    static std::size_t get_disk_loads();
+
+private:
+    template <typename T>
+    using Cache = std::map<std::string, std::shared_ptr<const T>>;
+
+    static std::mutex m_mutex;
+    static Cache<sf::Image> m_images;
+    static Cache<sf::Texture> m_textures;
+    static Cache<sf::Font> m_fonts;
+    static Cache<SoftwareFont> m_software_fonts;
+    static std::set<std::string> m_pending;     // paths being loaded, by a preload or a get
+    static std::condition_variable m_loaded;    // signalled as each load is published
+    static ThreadPool::TaskGroup m_preloads;
+    static std::atomic<std::size_t> m_disk_loads;
+
+    template <typename T>
+    static std::shared_ptr<const T> get(Cache<T> &cache, const std::string &file_path);
+    template <typename T>
+    static void preload(Cache<T> &cache, const std::string &file_path);
+    template <typename T>
+    static std::shared_ptr<const T> load(const std::string &file_path);
+};
@@ -0,0 +1,175 @@
+#include "software_font.hpp"
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <stdexcept>
+
+namespace
+{
+    // Tallest the page grows to.
+    constexpr unsigned int max_page_height = 8192;
+}
+
+/// <summary>
+/// Frees the face and the FreeType library.
+/// </summary>
+SoftwareFont::~SoftwareFont()
+{
+    if (m_face)
+    {
+        FT_Done_Face(static_cast<FT_Face>(m_face));
+    }
+    if (m_library)
+    {
+        FT_Done_FreeType(static_cast<FT_Library>(m_library));
+    }
+}
+
+/// <summary>
+/// Opens a font file and starts an empty page with the white square.
+/// </summary>
+/// <param name="file_path">Path to the font.</param>
+/// <returns>Whether the font could be opened.</returns>
+bool SoftwareFont::loadFromFile(const std::string &file_path)
+{
+    FT_Library library;
+    if (FT_Init_FreeType(&library) != 0)
+    {
+        return false;
+    }
+    m_library = library;
+
+    FT_Face face;
+    if (FT_New_Face(library, file_path.c_str(), 0, &face) != 0)
+    {
+        return false;
+    }
+    m_face = face;
+
+    if (FT_Select_Charmap(face, FT_ENCODING_UNICODE) != 0)
+    {
+        return false;
+    }
+
+    // Panels sample the middle of this, as they do on sf::Font's pages.
+    m_page.create(page_width, 128, sf::Color::Transparent);
+    for (unsigned int x = 0; x < 2; ++x)
+    {
+        for (unsigned int y = 0; y < 2; ++y)
+        {
+            m_page.setPixel(x, y, sf::Color::White);
+        }
+    }
+    m_next_top = 3;
+    return true;
+}
+
+/// <summary>
+/// Gets a glyph, drawing it onto the page the first time. Metrics are the
+/// ones sf::Font gives; the page holds white with the coverage as alpha, so
+/// the vertex colour tints it.
+/// </summary>
+/// <param name="code_point">The character.</param>
+/// <param name="character_size">Character size in pixels.</param>
+/// <returns>The glyph. Empty if the font has no such character.</returns>
+const sf::Glyph &SoftwareFont::get_glyph(sf::Uint32 code_point, unsigned int character_size) const
+{
+    const std::uint64_t key = (static_cast<std::uint64_t>(character_size) << 32) | code_point;
+    auto found = m_glyphs.find(key);
+    if (found != m_glyphs.end())
+    {
+        return found->second;
+    }
+
+    sf::Glyph &glyph = m_glyphs[key];
+    FT_Face face = static_cast<FT_Face>(m_face);
+    if (!face || FT_Set_Pixel_Sizes(face, 0, character_size) != 0 ||
+        FT_Load_Char(face, code_point, FT_LOAD_TARGET_NORMAL | FT_LOAD_FORCE_AUTOHINT) != 0 ||
+        FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL) != 0)
+    {
+        return glyph;
+    }
+
+    glyph.advance = static_cast<float>(face->glyph->metrics.horiAdvance) / 64.0f;
+
+    const FT_Bitmap &bitmap = face->glyph->bitmap;
+    const unsigned int width = bitmap.width;
+    const unsigned int height = bitmap.rows;
+    if (width == 0 || height == 0)
+    {
+        return glyph;
+    }
+
+    const sf::IntRect slot = place(width + 2 * padding, height + 2 * padding);
+    glyph.textureRect = sf::IntRect(slot.left + padding, slot.top + padding, width, height);
+    glyph.bounds = sf::FloatRect(static_cast<float>(face->glyph->bitmap_left), -static_cast<float>(face->glyph->bitmap_top),
+                                 static_cast<float>(width), static_cast<float>(height));
+
+    const unsigned char *row = bitmap.buffer;
+    for (unsigned int y = 0; y < height; ++y, row += bitmap.pitch)
+    {
+        for (unsigned int x = 0; x < width; ++x)
+        {
+            const sf::Uint8 alpha = bitmap.pixel_mode == FT_PIXEL_MODE_MONO
+                                        ? (((row[x / 8] >> (7 - x % 8)) & 1) ? 255 : 0)
+                                        : row[x];
+            m_page.setPixel(glyph.textureRect.left + x, glyph.textureRect.top + y, sf::Color(255, 255, 255, alpha));
+        }
+    }
+    return glyph;
+}
+
+/// <summary>
+/// Finds room on the page, on a row close to the glyph's height or a new
+/// one, making the page taller when it is full.
+/// Throws std::length_error if the page cannot grow any more.
+/// </summary>
+/// <param name="width">Width to fit, padding included.</param>
+/// <param name="height">Height to fit, padding included.</param>
+/// <returns>Where it goes.</returns>
+sf::IntRect SoftwareFont::place(unsigned int width, unsigned int height) const
+{
+    if (width > page_width)
+    {
+        throw std::length_error("Glyph is wider than the font page.");
+    }
+
+    Row *row = nullptr;
+    for (Row &candidate : m_rows)
+    {
+        if (height <= candidate.height && height * 10 >= candidate.height * 7 && candidate.next_x + width <= page_width)
+        {
+            row = &candidate;
+            break;
+        }
+    }
+
+    if (!row)
+    {
+        // A little taller than the glyph, so similar ones can share it.
+        const unsigned int row_height = height + height / 10;
+        unsigned int page_height = m_page.getSize().y;
+        while (m_next_top + row_height > page_height)
+        {
+            page_height *= 2;
+            if (page_height > max_page_height)
+            {
+                throw std::length_error("Font page is full.");
+            }
+        }
+        if (page_height != m_page.getSize().y)
+        {
+            sf::Image grown;
+            grown.create(page_width, page_height, sf::Color::Transparent);
+            grown.copy(m_page, 0, 0);
+            m_page = std::move(grown);
+        }
+
+        m_rows.push_back({m_next_top, row_height, 0});
+        m_next_top += row_height;
+        row = &m_rows.back();
+    }
+
+    const sf::IntRect slot(row->next_x, row->top, width, height);
+    row->next_x += width;
+    return slot;
+}
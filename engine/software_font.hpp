@@ -0,0 +1,57 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// SoftwareFont
+// Draws a font's glyphs into an image in memory with FreeType, for the
+// software renderer, which has no GPU to make sf::Font's page textures.
+// Glyphs are measured and placed the way sf::Font does it, and the page
+// keeps the same white square at its top left for panels, so UiLayer can
+// lay out with either. Every size shares one page. The page is named by a
+// texture that is never created: vertices that sample it are queued with
+// that texture, and the page is given to the rasterizer as its pixels.
+class SoftwareFont
+{
+public:
+    SoftwareFont() = default;
+    ~SoftwareFont();
+    SoftwareFont(const SoftwareFont &) = delete;
+    SoftwareFont &operator=(const SoftwareFont &) = delete;
+
+    // Named like sf::Font's, so the ResourceCache loads it the same way.
+    bool loadFromFile(const std::string &file_path);
+
+    // Draws the glyph onto the page the first time it is asked for.
+    const sf::Glyph &get_glyph(sf::Uint32 code_point, unsigned int character_size) const;
+
+    const sf::Texture *get_texture() const { return &m_texture; }
+    const sf::Image &get_image() const { return m_page; }
+
+private:
+    // A row of glyphs across the page, as tall as its tallest glyph.
+    struct Row
+    {
+        unsigned int top;
+        unsigned int height;
+        unsigned int next_x;
+    };
+
+    // Gap left around each glyph so sampling does not bleed between them.
+    static constexpr unsigned int padding = 1;
+    static constexpr unsigned int page_width = 512;
+
+    // FreeType's, kept opaque so its headers stay out of the engine's.
+    void *m_library = nullptr;
+    void *m_face = nullptr;
+    sf::Texture m_texture;
+    mutable sf::Image m_page;
+    mutable std::vector<Row> m_rows;
+    mutable unsigned int m_next_top = 0;
+    mutable std::map<std::uint64_t, sf::Glyph> m_glyphs;   // by size then code point
+
+    sf::IntRect place(unsigned int width, unsigned int height) const;
+};
@@ -0,0 +1,543 @@
+#include "software_rasterizer.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CUBEZONE_SSE2 1
+#endif
+
+// Pixels are stored as one 32-bit word with red in the lowest byte, which on
+// the little-endian machines the game runs on is sf::Image's RGBA byte order.
+namespace
+{
+    std::uint32_t pack(std::uint32_t r, std::uint32_t g, std::uint32_t b, std::uint32_t a)
+    {
+        return r | (g << 8) | (b << 16) | (a << 24);
+    }
+
+    std::uint32_t pack(const sf::Color &color)
+    {
+        return pack(color.r, color.g, color.b, color.a);
+    }
+
+    std::uint32_t channel(std::uint32_t pixel, int index)
+    {
+        return (pixel >> (index * 8)) & 0xFFu;
+    }
+
+    // x / 255, rounded, for x up to 255 * 255. Exact, and the same sum the
+    // SIMD path does, so both give the same pixels.
+    std::uint32_t div255(std::uint32_t x)
+    {
+        x += 128;
+        return (x + (x >> 8)) >> 8;
+    }
+
+    // SFML's alpha blending: colour = src * a + dst * (1 - a),
+    // alpha = a + dst alpha * (1 - a). The source's alpha channel is
+    // treated as 255 so every channel is the same sum.
+    std::uint32_t blend(std::uint32_t src, std::uint32_t dst)
+    {
+        const std::uint32_t a = src >> 24;
+        if (a == 255)
+        {
+            return src;
+        }
+        if (a == 0)
+        {
+            return dst;
+        }
+
+        const std::uint32_t inv = 255 - a;
+        return pack(div255(channel(src, 0) * a + channel(dst, 0) * inv),
+                    div255(channel(src, 1) * a + channel(dst, 1) * inv),
+                    div255(channel(src, 2) * a + channel(dst, 2) * inv),
+                    div255(255 * a + channel(dst, 3) * inv));
+    }
+
+    // Blends one colour over a run of pixels.
+    void fill_span(std::uint32_t *out, std::size_t count, std::uint32_t color)
+    {
+        const std::uint32_t a = color >> 24;
+        if (a == 0)
+        {
+            return;
+        }
+
+        std::size_t i = 0;
+        if (a == 255)
+        {
+#ifdef CUBEZONE_SSE2
+            const __m128i fill = _mm_set1_epi32(static_cast<int>(color));
+            for (; i + 4 <= count; i += 4)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), fill);
+            }
+#endif
+            std::fill(out + i, out + count, color);
+            return;
+        }
+
+        const std::uint32_t inv = 255 - a;
+        const std::uint32_t premul[4] = {channel(color, 0) * a, channel(color, 1) * a, channel(color, 2) * a, 255 * a};
+
+#ifdef CUBEZONE_SSE2
+        // Four pixels as two registers of eight 16-bit channels. Every sum
+        // fits in 16 bits: at most 255 * 255 + 128 + 255.
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i source = _mm_set_epi16(
+            static_cast<short>(premul[3]), static_cast<short>(premul[2]), static_cast<short>(premul[1]), static_cast<short>(premul[0]),
+            static_cast<short>(premul[3]), static_cast<short>(premul[2]), static_cast<short>(premul[1]), static_cast<short>(premul[0]));
+        const __m128i weight = _mm_set1_epi16(static_cast<short>(inv));
+        const __m128i bias = _mm_set1_epi16(128);
+
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128i dst = _mm_loadu_si128(reinterpret_cast<const __m128i *>(out + i));
+
+            __m128i low = _mm_unpacklo_epi8(dst, zero);
+            low = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(low, weight), source), bias);
+            low = _mm_srli_epi16(_mm_add_epi16(low, _mm_srli_epi16(low, 8)), 8);
+
+            __m128i high = _mm_unpackhi_epi8(dst, zero);
+            high = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(high, weight), source), bias);
+            high = _mm_srli_epi16(_mm_add_epi16(high, _mm_srli_epi16(high, 8)), 8);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(low, high));
+        }
+#endif
+
+        for (; i < count; ++i)
+        {
+            const std::uint32_t dst = out[i];
+            out[i] = pack(div255(premul[0] + channel(dst, 0) * inv),
+                          div255(premul[1] + channel(dst, 1) * inv),
+                          div255(premul[2] + channel(dst, 2) * inv),
+                          div255(premul[3] + channel(dst, 3) * inv));
+        }
+    }
+
+    std::uint32_t to_channel(float value)
+    {
+        return static_cast<std::uint32_t>(std::min(std::max(value, 0.0f), 255.0f) + 0.5f);
+    }
+}
+
+/// <summary>
+/// Makes a rasterizer with a black framebuffer.
+/// </summary>
+/// <param name="width">Framebuffer width in pixels.</param>
+/// <param name="height">Framebuffer height in pixels.</param>
+SoftwareRasterizer::SoftwareRasterizer(unsigned int width, unsigned int height)
+{
+    resize(width, height);
+}
+
+/// <summary>
+/// Resizes the framebuffer. Its contents are lost.
+/// </summary>
+/// <param name="width">Width in pixels.</param>
+/// <param name="height">Height in pixels.</param>
+void SoftwareRasterizer::resize(unsigned int width, unsigned int height)
+{
+    if (width == 0 || height == 0)
+    {
+        throw std::length_error("Software framebuffer must not be empty.");
+    }
+
+    m_width = width;
+    m_height = height;
+    m_tiles_x = (width + tile_size - 1) / tile_size;
+    m_tiles_y = (height + tile_size - 1) / tile_size;
+    m_pixels.assign(static_cast<std::size_t>(width) * height, pack(0, 0, 0, 255));
+    m_bins.assign(static_cast<std::size_t>(m_tiles_x) * m_tiles_y, {});
+}
+
+/// <summary>
+/// Gives the pixels to draw a texture with.
+/// </summary>
+/// <param name="texture">The texture, as the snapshot refers to it.</param>
+/// <param name="image">Its pixels. Copied.</param>
+void SoftwareRasterizer::set_image(const sf::Texture *texture, const sf::Image &image)
+{
+    const sf::Vector2u size = image.getSize();
+    Surface &surface = m_surfaces[texture];
+    surface.width = size.x;
+    surface.height = size.y;
+    surface.pixels.resize(static_cast<std::size_t>(size.x) * size.y);
+    if (!surface.pixels.empty())
+    {
+        std::memcpy(surface.pixels.data(), image.getPixelsPtr(), surface.pixels.size() * sizeof(std::uint32_t));
+    }
+}
+
+/// <summary>
+/// Gets whether a texture has pixels to draw with.
+/// </summary>
+/// <param name="texture">The texture.</param>
+/// <returns>Whether set_image has been called for it.</returns>
+bool SoftwareRasterizer::has_image(const sf::Texture *texture) const
+{
+    return m_surfaces.count(texture) != 0;
+}
+
+/// <summary>
+/// Draws a frame. The snapshot's triangles are mapped through its views,
+/// binned by tile, then each tile is cleared and drawn on the thread pool.
+/// </summary>
+/// <param name="snapshot">The frame.</param>
+void SoftwareRasterizer::draw(const RenderSnapshot &snapshot)
+{
+    m_triangles.clear();
+    for (std::vector<std::uint32_t> &bin : m_bins)
+    {
+        bin.clear();
+    }
+
+    const Mapping world = make_mapping(snapshot.view, m_width, m_height);
+    const Mapping screen = make_mapping(snapshot.screen_view, m_width, m_height);
+
+    for (std::size_t i = 0; i < snapshot.batches.size(); ++i)
+    {
+        const RenderSnapshot::Batch &batch = snapshot.batches[i];
+        if (batch.text)
+        {
+            continue;
+        }
+
+        const Mapping &mapping = i < snapshot.screen_first ? world : screen;
+        auto found = batch.texture ? m_surfaces.find(batch.texture) : m_surfaces.end();
+        const Surface *surface = found != m_surfaces.end() ? &found->second : nullptr;
+        const sf::Vertex *v = &snapshot.vertices[batch.first];
+        const std::size_t count = batch.count;
+
+        switch (batch.type)
+        {
+            case sf::Triangles:
+                for (std::size_t k = 0; k + 2 < count; k += 3)
+                {
+                    add_triangle(v[k], v[k + 1], v[k + 2], mapping, surface);
+                }
+                break;
+            case sf::TriangleStrip:
+                for (std::size_t k = 2; k < count; ++k)
+                {
+                    add_triangle(v[k - 2], v[k - 1], v[k], mapping, surface);
+                }
+                break;
+            case sf::TriangleFan:
+                for (std::size_t k = 2; k < count; ++k)
+                {
+                    add_triangle(v[0], v[k - 1], v[k], mapping, surface);
+                }
+                break;
+            case sf::Quads:
+                for (std::size_t k = 0; k + 3 < count; k += 4)
+                {
+                    add_triangle(v[k], v[k + 1], v[k + 2], mapping, surface);
+                    add_triangle(v[k], v[k + 2], v[k + 3], mapping, surface);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    const std::uint32_t clear_color = pack(snapshot.clear_color);
+    ThreadPool::shared().parallel_for(m_bins.size(), 1, [this, clear_color](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t tile = begin; tile < end; ++tile)
+        {
+            draw_tile(tile, clear_color);
+        }
+    });
+}
+
+/// <summary>
+/// Copies the framebuffer into an image, e.g. to save it.
+/// </summary>
+/// <param name="image">Receives the frame.</param>
+void SoftwareRasterizer::copy_to_image(sf::Image &image) const
+{
+    image.create(m_width, m_height, reinterpret_cast<const sf::Uint8 *>(m_pixels.data()));
+}
+
+/// <summary>
+/// Counts the pixels that differ from an image, e.g. a golden frame.
+/// </summary>
+/// <param name="image">The image to compare with.</param>
+/// <param name="tolerance">How far a channel may be off and still match.</param>
+/// <returns>How many pixels differ.</returns>
+std::size_t SoftwareRasterizer::compare(const sf::Image &image, unsigned int tolerance) const
+{
+    const sf::Vector2u size = image.getSize();
+    if (size.x != m_width || size.y != m_height)
+    {
+        return m_pixels.size();
+    }
+
+    const sf::Uint8 *other = image.getPixelsPtr();
+    std::size_t differing = 0;
+    for (std::size_t i = 0; i < m_pixels.size(); ++i)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            const int difference = static_cast<int>(channel(m_pixels[i], c)) - static_cast<int>(other[i * 4 + c]);
+            if (static_cast<unsigned int>(std::abs(difference)) > tolerance)
+            {
+                ++differing;
+                break;
+            }
+        }
+    }
+    return differing;
+}
+
+/// <summary>
+/// Works out how a view maps onto the framebuffer. Rotation and viewports
+/// are ignored; the game uses neither.
+/// </summary>
+/// <param name="view">The view.</param>
+/// <param name="width">Framebuffer width.</param>
+/// <param name="height">Framebuffer height.</param>
+/// <returns>The mapping.</returns>
+SoftwareRasterizer::Mapping SoftwareRasterizer::make_mapping(const sf::View &view, unsigned int width, unsigned int height)
+{
+    const sf::Vector2f size = view.getSize();
+    const sf::Vector2f centre = view.getCenter();
+    return {centre.x - size.x / 2.0f, centre.y - size.y / 2.0f,
+            size.x != 0.0f ? width / size.x : 0.0f, size.y != 0.0f ? height / size.y : 0.0f};
+}
+
+/// <summary>
+/// Sets a triangle up for drawing and adds it to the bins of the tiles it
+/// touches. Degenerate and off-screen triangles are dropped.
+/// </summary>
+/// <param name="a">First vertex.</param>
+/// <param name="b">Second vertex.</param>
+/// <param name="c">Third vertex.</param>
+/// <param name="mapping">Maps the vertices onto the framebuffer.</param>
+/// <param name="surface">Pixels to texture it with, or nullptr for none.</param>
+void SoftwareRasterizer::add_triangle(const sf::Vertex &a, const sf::Vertex &b, const sf::Vertex &c,
+                                      const Mapping &mapping, const Surface *surface)
+{
+    const sf::Vertex *v[3] = {&a, &b, &c};
+    Triangle triangle;
+    for (int i = 0; i < 3; ++i)
+    {
+        triangle.x[i] = (v[i]->position.x - mapping.left) * mapping.scale_x;
+        triangle.y[i] = (v[i]->position.y - mapping.top) * mapping.scale_y;
+    }
+
+    float area = (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0])
+               - (triangle.y[1] - triangle.y[0]) * (triangle.x[2] - triangle.x[0]);
+    if (!(std::fabs(area) > 0.0f) || !std::isfinite(area))
+    {
+        return;
+    }
+
+    // Both windings are drawn; flip to one so inside is where every edge is positive.
+    if (area < 0.0f)
+    {
+        std::swap(v[1], v[2]);
+        std::swap(triangle.x[1], triangle.x[2]);
+        std::swap(triangle.y[1], triangle.y[2]);
+        area = -area;
+    }
+
+    // Pixel i is covered when its centre, i + 0.5, is inside.
+    const float min_x = std::min({triangle.x[0], triangle.x[1], triangle.x[2]});
+    const float max_x = std::max({triangle.x[0], triangle.x[1], triangle.x[2]});
+    const float min_y = std::min({triangle.y[0], triangle.y[1], triangle.y[2]});
+    const float max_y = std::max({triangle.y[0], triangle.y[1], triangle.y[2]});
+    if (max_x < 0.0f || max_y < 0.0f || min_x > static_cast<float>(m_width) || min_y > static_cast<float>(m_height))
+    {
+        return;
+    }
+
+    triangle.min_x = std::max(0, static_cast<int>(std::ceil(min_x - 0.5f)));
+    triangle.min_y = std::max(0, static_cast<int>(std::ceil(min_y - 0.5f)));
+    triangle.max_x = std::min(static_cast<int>(m_width) - 1, static_cast<int>(std::floor(max_x - 0.5f)));
+    triangle.max_y = std::min(static_cast<int>(m_height) - 1, static_cast<int>(std::floor(max_y - 0.5f)));
+    if (triangle.min_x > triangle.max_x || triangle.min_y > triangle.max_y)
+    {
+        return;
+    }
+
+    triangle.surface = surface;
+    triangle.flat = !surface && v[0]->color == v[1]->color && v[0]->color == v[2]->color;
+    triangle.color = pack(v[0]->color);
+
+    if (!triangle.flat)
+    {
+        // Each attribute as a plane through its three vertex values.
+        const float ex1 = triangle.x[1] - triangle.x[0];
+        const float ey1 = triangle.y[1] - triangle.y[0];
+        const float ex2 = triangle.x[2] - triangle.x[0];
+        const float ey2 = triangle.y[2] - triangle.y[0];
+        for (int k = 0; k < 6; ++k)
+        {
+            float f[3];
+            for (int i = 0; i < 3; ++i)
+            {
+                switch (k)
+                {
+                    case 0: f[i] = v[i]->color.r; break;
+                    case 1: f[i] = v[i]->color.g; break;
+                    case 2: f[i] = v[i]->color.b; break;
+                    case 3: f[i] = v[i]->color.a; break;
+                    case 4: f[i] = v[i]->texCoords.x; break;
+                    default: f[i] = v[i]->texCoords.y; break;
+                }
+            }
+            triangle.dx[k] = ((f[1] - f[0]) * ey2 - (f[2] - f[0]) * ey1) / area;
+            triangle.dy[k] = ((f[2] - f[0]) * ex1 - (f[1] - f[0]) * ex2) / area;
+            triangle.base[k] = f[0] - triangle.dx[k] * triangle.x[0] - triangle.dy[k] * triangle.y[0];
+        }
+    }
+
+    const std::uint32_t index = static_cast<std::uint32_t>(m_triangles.size());
+    m_triangles.push_back(triangle);
+
+    for (unsigned int ty = triangle.min_y / tile_size; ty <= triangle.max_y / tile_size; ++ty)
+    {
+        for (unsigned int tx = triangle.min_x / tile_size; tx <= triangle.max_x / tile_size; ++tx)
+        {
+            m_bins[ty * m_tiles_x + tx].push_back(index);
+        }
+    }
+}
+
+/// <summary>
+/// Clears one tile and draws its triangles in order. Tiles share no
+/// pixels, so they can be drawn on any thread.
+/// </summary>
+/// <param name="tile">The tile's index.</param>
+/// <param name="clear_color">Colour to clear to.</param>
+void SoftwareRasterizer::draw_tile(std::size_t tile, std::uint32_t clear_color)
+{
+    const int left = static_cast<int>((tile % m_tiles_x) * tile_size);
+    const int top = static_cast<int>((tile / m_tiles_x) * tile_size);
+    const int right = std::min(left + static_cast<int>(tile_size), static_cast<int>(m_width)) - 1;
+    const int bottom = std::min(top + static_cast<int>(tile_size), static_cast<int>(m_height)) - 1;
+
+    for (int y = top; y <= bottom; ++y)
+    {
+        std::uint32_t *row = &m_pixels[static_cast<std::size_t>(y) * m_width];
+        std::fill(row + left, row + right + 1, clear_color);
+    }
+
+    for (std::uint32_t index : m_bins[tile])
+    {
+        draw_triangle(m_triangles[index], left, top, right, bottom);
+    }
+}
+
+/// <summary>
+/// Draws the part of a triangle inside a rectangle. Each row's span is
+/// found from the edges, so flat triangles are filled a span at a time.
+/// A pixel centre on an edge belongs to one side only: the edge's owner
+/// is picked by its direction, which is reversed in the triangle across it.
+/// </summary>
+/// <param name="triangle">The triangle.</param>
+/// <param name="left">Leftmost pixel to draw.</param>
+/// <param name="top">Top pixel row to draw.</param>
+/// <param name="right">Rightmost pixel to draw.</param>
+/// <param name="bottom">Bottom pixel row to draw.</param>
+void SoftwareRasterizer::draw_triangle(const Triangle &triangle, int left, int top, int right, int bottom)
+{
+    const int first_row = std::max(top, triangle.min_y);
+    const int last_row = std::min(bottom, triangle.max_y);
+    const int first_column = std::max(left, triangle.min_x);
+    const int last_column = std::min(right, triangle.max_x);
+
+    for (int y = first_row; y <= last_row; ++y)
+    {
+        const double cy = y + 0.5;
+        double start = first_column;
+        double end = last_column;
+        bool empty = false;
+
+        for (int e = 0; e < 3 && !empty; ++e)
+        {
+            const int next = (e + 1) % 3;
+            const double ex = static_cast<double>(triangle.x[next]) - triangle.x[e];
+            const double ey = static_cast<double>(triangle.y[next]) - triangle.y[e];
+            const bool owned = ey > 0.0 || (ey == 0.0 && ex < 0.0);
+
+            // The edge function along the row: c + a * x, inside where positive.
+            const double a = -ey;
+            const double c = ex * (cy - triangle.y[e]) + ey * triangle.x[e];
+            if (a == 0.0)
+            {
+                empty = !(c > 0.0 || (c == 0.0 && owned));
+                continue;
+            }
+
+            // Pixel i is inside on the far side of t, measured at i + 0.5.
+            const double t = -c / a - 0.5;
+            if (a > 0.0)
+            {
+                start = std::max(start, owned ? std::ceil(t) : std::floor(t) + 1.0);
+            }
+            else
+            {
+                end = std::min(end, owned ? std::floor(t) : std::ceil(t) - 1.0);
+            }
+            empty = start > end;
+        }
+
+        if (empty)
+        {
+            continue;
+        }
+
+        const int x0 = static_cast<int>(start);
+        const int x1 = static_cast<int>(end);
+        std::uint32_t *row = &m_pixels[static_cast<std::size_t>(y) * m_width];
+
+        if (triangle.flat)
+        {
+            fill_span(row + x0, static_cast<std::size_t>(x1 - x0 + 1), triangle.color);
+            continue;
+        }
+
+        float value[6];
+        for (int k = 0; k < 6; ++k)
+        {
+            value[k] = triangle.base[k] + triangle.dx[k] * (x0 + 0.5f) + triangle.dy[k] * static_cast<float>(cy);
+        }
+
+        const Surface *surface = triangle.surface;
+        for (int x = x0; x <= x1; ++x)
+        {
+            std::uint32_t r = to_channel(value[0]);
+            std::uint32_t g = to_channel(value[1]);
+            std::uint32_t b = to_channel(value[2]);
+            std::uint32_t a = to_channel(value[3]);
+
+            if (surface && surface->width > 0 && surface->height > 0)
+            {
+                const int u = std::min(std::max(static_cast<int>(std::floor(value[4])), 0), static_cast<int>(surface->width) - 1);
+                const int v = std::min(std::max(static_cast<int>(std::floor(value[5])), 0), static_cast<int>(surface->height) - 1);
+                const std::uint32_t texel = surface->pixels[static_cast<std::size_t>(v) * surface->width + u];
+                r = div255(r * channel(texel, 0));
+                g = div255(g * channel(texel, 1));
+                b = div255(b * channel(texel, 2));
+                a = div255(a * channel(texel, 3));
+            }
+
+            row[x] = blend(pack(r, g, b, a), row[x]);
+
+            for (int k = 0; k < 6; ++k)
+            {
+                value[k] += triangle.dx[k];
+            }
+        }
+    }
+}
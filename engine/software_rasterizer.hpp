@@ -0,0 +1,100 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+#include "render_snapshot.hpp"
+
+// SoftwareRasterizer
+// Draws a RenderSnapshot into a framebuffer in memory, with no GPU or
+// window, so frames of a headless run can be saved, compared against
+// golden images and timed. Triangles are binned into tiles and the tiles
+// are filled in parallel on the shared thread pool, each drawing its bin
+// in submission order. Runs of one colour are blended four pixels at a
+// time with SSE2 where it is available.
+//
+// It follows SFML's defaults: pixel texture coordinates, nearest sampling
+// and alpha blending. Textures are GPU objects, so a texture is only
+// sampled once a CPU copy of it has been given with set_image(); without
+// one its triangles are drawn in their vertex colours. The sprite atlas,
+// the projectile disc and SoftwareFont pages all give theirs, so sprites
+// and UiLayer text are drawn. sf::Texts, lines and points are skipped.
+class SoftwareRasterizer
+{
+public:
+    SoftwareRasterizer(unsigned int width, unsigned int height);
+
+    void resize(unsigned int width, unsigned int height);
+    unsigned int get_width() const { return m_width; }
+    unsigned int get_height() const { return m_height; }
+
+    // Copies image to be sampled wherever texture is drawn.
+    void set_image(const sf::Texture *texture, const sf::Image &image);
+    bool has_image(const sf::Texture *texture) const;
+
+    // Clears the framebuffer and draws the snapshot on it.
+    void draw(const RenderSnapshot &snapshot);
+
+    // RGBA, 8 bits a channel, in sf::Image's byte order, row by row.
+    const std::vector<std::uint32_t> &get_pixels() const { return m_pixels; }
+    void copy_to_image(sf::Image &image) const;
+    // Pixels with a channel more than tolerance away from image's. Every
+    // pixel differs if the sizes do not match.
+    std::size_t compare(const sf::Image &image, unsigned int tolerance = 0) const;
+
+    // Triangles drawn in the last frame.
+    std::size_t get_triangles() const { return m_triangles.size(); }
+
+    // Width and height of a tile in pixels.
+    static constexpr unsigned int tile_size = 64;
+
+private:
+    // A texture's pixels.
+    struct Surface
+    {
+        unsigned int width;
+        unsigned int height;
+        std::vector<std::uint32_t> pixels;
+    };
+
+    // Maps world or screen coordinates onto the framebuffer.
+    struct Mapping
+    {
+        float left;
+        float top;
+        float scale_x;
+        float scale_y;
+    };
+
+    // A triangle in framebuffer pixels, wound so its area is positive,
+    // with its attributes as planes: value = base + dx * x + dy * y.
+    struct Triangle
+    {
+        float x[3];
+        float y[3];
+        int min_x, min_y, max_x, max_y;     // inclusive pixel bounds, on screen
+        std::uint32_t color;                // when flat
+        bool flat;                          // one colour, no texture
+        const Surface *surface;
+        float base[6];                      // r, g, b, a, u, v
+        float dx[6];
+        float dy[6];
+    };
+
+    unsigned int m_width = 0;
+    unsigned int m_height = 0;
+    unsigned int m_tiles_x = 0;
+    unsigned int m_tiles_y = 0;
+    std::vector<std::uint32_t> m_pixels;
+    std::vector<Triangle> m_triangles;
+    std::vector<std::vector<std::uint32_t>> m_bins;   // triangle indices per tile, in order
+    std::map<const sf::Texture *, Surface> m_surfaces;
+
+    static Mapping make_mapping(const sf::View &view, unsigned int width, unsigned int height);
+    void add_triangle(const sf::Vertex &a, const sf::Vertex &b, const sf::Vertex &c,
+                      const Mapping &mapping, const Surface *surface);
+    void draw_tile(std::size_t tile, std::uint32_t clear_color);
+    void draw_triangle(const Triangle &triangle, int left, int top, int right, int bottom);
+};
@@ -0,0 +1,103 @@
+#include "spatial_hash.hpp"
+#include <cmath>
+#include <stdexcept>
+
+/// <summary>
+/// Creates an empty grid.
+/// </summary>
+/// <param name="cell_size">Width and height of a cell in pixels.</param>
+SpatialHash::SpatialHash(float cell_size)
+    : m_cell_size(cell_size), m_inverse_cell_size(1.0f / cell_size)
+{
+    if (cell_size <= 0.0f)
+    {
+        throw std::logic_error("Spatial hash cells must have a positive size.");
+    }
+}
+
+/// <summary>
+/// Removes every item. Keeps the memory for the next build.
+/// </summary>
+void SpatialHash::clear()
+{
+    m_items.clear();
+    m_sorted.clear();
+}
+
+/// <summary>
+/// Adds an item to be sorted by the next build.
+/// </summary>
+/// <param name="handle">The entity the item stands for.</param>
+/// <param name="position">Where it is.</param>
+void SpatialHash::insert(EntityHandle handle, const sf::Vector2f &position)
+{
+    m_items.push_back({handle, position, cell_of(position.x), cell_of(position.y)});
+}
+
+/// <summary>
+/// Sorts the items into buckets by cell with a counting sort.
+/// There are about twice as many buckets as items, so few cells share one.
+/// </summary>
+void SpatialHash::build()
+{
+    std::uint32_t bucket_count = 16;
+    while (bucket_count < m_items.size() * 2)
+    {
+        bucket_count <<= 1;
+    }
+    m_bucket_mask = bucket_count - 1;
+
+    m_starts.assign(bucket_count + 1, 0);
+    for (const Item &item : m_items)
+    {
+        ++m_starts[bucket_of(item.cell_x, item.cell_y) + 1];
+    }
+    for (std::uint32_t b = 0; b < bucket_count; ++b)
+    {
+        m_starts[b + 1] += m_starts[b];
+    }
+
+    // Fills each bucket in insertion order, so queries visit items in a fixed order.
+    m_sorted.resize(m_items.size());
+    std::vector<std::uint32_t> next(m_starts.begin(), m_starts.end() - 1);
+    for (const Item &item : m_items)
+    {
+        m_sorted[next[bucket_of(item.cell_x, item.cell_y)]++] = item;
+    }
+}
+
+/// <summary>
+/// Collects the items within a radius.
+/// </summary>
+/// <param name="centre">Centre of the query.</param>
+/// <param name="radius">Distance from the centre.</param>
+/// <param name="out">Receives the handles; not cleared first.</param>
+void SpatialHash::query_radius(const sf::Vector2f &centre, float radius, std::vector<EntityHandle> &out) const
+{
+    query_radius(centre, radius, [&out](EntityHandle handle, const sf::Vector2f &) {
+        out.push_back(handle);
+        return true;
+    });
+}
+
+/// <summary>
+/// Gets the cell a coordinate falls in.
+/// </summary>
+/// <param name="coordinate">An x or y position.</param>
+/// <returns>The cell's column or row.</returns>
+std::int32_t SpatialHash::cell_of(float coordinate) const
+{
+    return static_cast<std::int32_t>(std::floor(coordinate * m_inverse_cell_size));
+}
+
+/// <summary>
+/// Hashes a cell to its bucket.
+/// </summary>
+/// <param name="cell_x">The cell's column.</param>
+/// <param name="cell_y">The cell's row.</param>
+/// <returns>The bucket index.</returns>
+std::uint32_t SpatialHash::bucket_of(std::int32_t cell_x, std::int32_t cell_y) const
+{
+    const std::uint32_t hash = static_cast<std::uint32_t>(cell_x) * 73856093u ^ static_cast<std::uint32_t>(cell_y) * 19349663u;
+    return hash & m_bucket_mask;
+}
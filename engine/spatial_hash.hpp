@@ -0,0 +1,117 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include "entity_handle.hpp"
+#include "game_parameters.hpp"
+#include <cstdint>
+#include <vector>
+
+// SpatialHash
+// A uniform grid over the world for finding what is near a point.
+// Items are points. They are inserted, then build() sorts them by cell so
+// queries only look at the cells the query overlaps. Rebuild it whenever
+// the items move; a rebuild is linear in the item count.
+class SpatialHash
+{
+public:
+    explicit SpatialHash(float cell_size = params::tile_size);
+
+    // Removes every item.
+    void clear();
+
+    // Adds an item. Not visible to queries until build().
+    void insert(EntityHandle handle, const sf::Vector2f &position);
+
+    // Sorts the inserted items into their cells.
+    void build();
+
+    // Visits every item within radius of centre. The visitor is called as
+    // visit(handle, position) and returns false to stop the query.
+    template <typename Visitor>
+    void query_radius(const sf::Vector2f &centre, float radius, Visitor &&visit) const;
+
+    // Visits every item inside rect, as query_radius does.
+    template <typename Visitor>
+    void query_rect(const sf::FloatRect &rect, Visitor &&visit) const;
+
+    // Collects the handles within radius of centre into out.
+    void query_radius(const sf::Vector2f &centre, float radius, std::vector<EntityHandle> &out) const;
+
+    std::size_t size() const { return m_items.size(); }
+    float get_cell_size() const { return m_cell_size; }
+
+private:
+    struct Item
+    {
+        EntityHandle handle;
+        sf::Vector2f position;
+        std::int32_t cell_x;
+        std::int32_t cell_y;
+    };
+
+    float m_cell_size;
+    float m_inverse_cell_size;
+    std::vector<Item> m_items;          // in insertion order
+    std::vector<Item> m_sorted;         // grouped by bucket after build()
+    std::vector<std::uint32_t> m_starts;    // bucket b is m_sorted[m_starts[b], m_starts[b + 1])
+    std::uint32_t m_bucket_mask = 0;
+
+    std::int32_t cell_of(float coordinate) const;
+    std::uint32_t bucket_of(std::int32_t cell_x, std::int32_t cell_y) const;
+
+    template <typename Test, typename Visitor>
+    void query_cells(const sf::FloatRect &bounds, Test &&test, Visitor &&visit) const;
+};
+
+template <typename Test, typename Visitor>
+void SpatialHash::query_cells(const sf::FloatRect &bounds, Test &&test, Visitor &&visit) const
+{
+    if (m_sorted.empty())
+    {
+        return;
+    }
+
+    const std::int32_t min_x = cell_of(bounds.left);
+    const std::int32_t max_x = cell_of(bounds.left + bounds.width);
+    const std::int32_t min_y = cell_of(bounds.top);
+    const std::int32_t max_y = cell_of(bounds.top + bounds.height);
+
+    for (std::int32_t y = min_y; y <= max_y; ++y)
+    {
+        for (std::int32_t x = min_x; x <= max_x; ++x)
+        {
+            const std::uint32_t bucket = bucket_of(x, y);
+            for (std::uint32_t i = m_starts[bucket]; i < m_starts[bucket + 1]; ++i)
+            {
+                // Other cells can share the bucket.
+                const Item &item = m_sorted[i];
+                if (item.cell_x != x || item.cell_y != y || !test(item.position))
+                {
+                    continue;
+                }
+                if (!visit(item.handle, item.position))
+                {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+template <typename Visitor>
+void SpatialHash::query_radius(const sf::Vector2f &centre, float radius, Visitor &&visit) const
+{
+    const float radius_sq = radius * radius;
+    query_cells(sf::FloatRect(centre.x - radius, centre.y - radius, radius * 2.0f, radius * 2.0f),
+        [&](const sf::Vector2f &position) {
+            const sf::Vector2f diff = position - centre;
+            return diff.x * diff.x + diff.y * diff.y < radius_sq;
+        },
+        visit);
+}
+
+template <typename Visitor>
+void SpatialHash::query_rect(const sf::FloatRect &rect, Visitor &&visit) const
+{
+    query_cells(rect, [&](const sf::Vector2f &position) { return rect.contains(position); }, visit);
+}
@@ -0,0 +1,373 @@
+#include "sprite_batch.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+    // Whether two runs of this primitive can be joined into one draw.
+    bool is_list(sf::PrimitiveType type)
+    {
+        return type == sf::Points || type == sf::Lines || type == sf::Triangles || type == sf::Quads;
+    }
+
+    // Unit normal of the edge from p1 to p2.
+    sf::Vector2f edge_normal(const sf::Vector2f &p1, const sf::Vector2f &p2)
+    {
+        sf::Vector2f normal(p1.y - p2.y, p2.x - p1.x);
+        const float length = std::sqrt(normal.x * normal.x + normal.y * normal.y);
+        if (length != 0.0f)
+        {
+            normal /= length;
+        }
+        return normal;
+    }
+}
+
+/// <summary>
+/// Copies a drawable into render commands.
+/// </summary>
+/// <param name="drawable">What to draw. Only read during the call.</param>
+/// <param name="layer">Draw order between groups; lower is further back.</param>
+/// <param name="depth">Draw order within a layer and texture.</param>
+void SpriteBatch::add(const sf::Drawable *drawable, std::uint8_t layer, std::uint16_t depth)
+{
+    const std::size_t first = m_vertices.size();
+
+    if (const sf::Sprite *sprite = dynamic_cast<const sf::Sprite *>(drawable))
+    {
+        append_sprite(*sprite);
+        push_geometry(make_key(layer, texture_id(sprite->getTexture()), depth), sf::Triangles, sprite->getTexture(), first);
+    }
+    else if (const sf::Shape *shape = dynamic_cast<const sf::Shape *>(drawable))
+    {
+        const std::uint32_t key = make_key(layer, texture_id(shape->getTexture()), depth);
+        append_shape(*shape);
+        push_geometry(key, sf::Triangles, shape->getTexture(), first);
+
+        // The outline is untextured, but keeps the fill's key so the stable
+        // sort leaves it straight after the fill.
+        if (shape->getOutlineThickness() != 0.0f)
+        {
+            const std::size_t outline_first = m_vertices.size();
+            append_outline(*shape);
+            push_geometry(key, sf::Triangles, nullptr, outline_first);
+        }
+    }
+    else if (const sf::VertexArray *vertices = dynamic_cast<const sf::VertexArray *>(drawable))
+    {
+        for (std::size_t i = 0; i < vertices->getVertexCount(); ++i)
+        {
+            m_vertices.push_back((*vertices)[i]);
+        }
+        push_geometry(make_key(layer, untextured_id, depth), vertices->getPrimitiveType(), nullptr, first);
+    }
+    else if (const sf::Text *text = dynamic_cast<const sf::Text *>(drawable))
+    {
+        // Lays the copy out here, so drawing it does not look glyphs up in
+        // the font from another thread.
+        m_texts.push_back(*text);
+        m_texts.back().getLocalBounds();
+
+        RenderCommand command{make_key(layer, unbatched_id, depth), COMMAND_TEXT, sf::Triangles, nullptr,
+                              static_cast<std::uint32_t>(m_texts.size() - 1), 1};
+        m_commands.push_back(command);
+    }
+    else
+    {
+        throw std::logic_error("SpriteBatch cannot copy this type of drawable.");
+    }
+}
+
+/// <summary>
+/// Copies raw vertices into a render command.
+/// </summary>
+/// <param name="vertices">The vertices. Only read during the call.</param>
+/// <param name="count">How many vertices.</param>
+/// <param name="type">How to join them.</param>
+/// <param name="texture">Texture to draw them with, or nullptr for none.</param>
+/// <param name="layer">Draw order between groups; lower is further back.</param>
+/// <param name="depth">Draw order within a layer and texture.</param>
+void SpriteBatch::add_vertices(const sf::Vertex *vertices, std::size_t count, sf::PrimitiveType type,
+                               const sf::Texture *texture, std::uint8_t layer, std::uint16_t depth)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    const std::size_t first = m_vertices.size();
+    m_vertices.insert(m_vertices.end(), vertices, vertices + count);
+    push_geometry(make_key(layer, texture_id(texture), depth), type, texture, first);
+}
+
+/// <summary>
+/// Sorts the commands into the snapshot, merging consecutive commands with
+/// the same texture into one batch.
+/// </summary>
+/// <param name="snapshot">Where to put the frame. Added to, not cleared.</param>
+void SpriteBatch::build(RenderSnapshot &snapshot)
+{
+    sort();
+
+    // Never merge into batches already in the snapshot, which may be drawn
+    // with a different view.
+    const std::size_t first_batch = snapshot.batches.size();
+
+    for (std::uint32_t index : m_order)
+    {
+        const RenderCommand &command = m_commands[index];
+
+        if (command.kind == COMMAND_TEXT)
+        {
+            snapshot.texts.push_back(std::move(m_texts[command.first]));
+            snapshot.batches.push_back({snapshot.texts.size() - 1, 1, sf::Triangles, nullptr, true});
+            continue;
+        }
+
+        RenderSnapshot::Batch *last = snapshot.batches.size() > first_batch ? &snapshot.batches.back() : nullptr;
+        if (last && !last->text && last->texture == command.texture && last->type == command.type && is_list(command.type))
+        {
+            last->count += command.count;
+        }
+        else
+        {
+            snapshot.batches.push_back({snapshot.vertices.size(), command.count, command.type, command.texture, false});
+        }
+
+        snapshot.vertices.insert(snapshot.vertices.end(),
+            m_vertices.begin() + command.first, m_vertices.begin() + command.first + command.count);
+    }
+
+    clear();
+}
+
+/// <summary>
+/// Forgets every command without building.
+/// </summary>
+void SpriteBatch::clear()
+{
+    m_commands.clear();
+    m_texture_ids.clear();
+    m_vertices.clear();
+    m_texts.clear();
+}
+
+/// <summary>
+/// Gives each texture seen this frame a small id for the sort key.
+/// </summary>
+/// <param name="texture">The texture, or nullptr for none.</param>
+/// <returns>The texture's id.</returns>
+std::uint32_t SpriteBatch::texture_id(const sf::Texture *texture)
+{
+    if (!texture)
+    {
+        return untextured_id;
+    }
+
+    auto found = m_texture_ids.find(texture);
+    if (found != m_texture_ids.end())
+    {
+        return found->second;
+    }
+
+    // Past the id range textures share the last id. Batches still only
+    // merge on the same texture, they just are not grouped together.
+    const std::uint32_t id = std::min<std::uint32_t>(m_texture_ids.size() + 1, unbatched_id - 1);
+    m_texture_ids.emplace(texture, id);
+    return id;
+}
+
+/// <summary>
+/// Packs a sort key.
+/// </summary>
+/// <param name="layer">The layer.</param>
+/// <param name="texture">The texture's id.</param>
+/// <param name="depth">The depth, clamped to its bits.</param>
+/// <returns>The key.</returns>
+std::uint32_t SpriteBatch::make_key(std::uint8_t layer, std::uint32_t texture, std::uint16_t depth)
+{
+    const std::uint32_t clamped_depth = std::min<std::uint32_t>(depth, (1u << depth_bits) - 1);
+    return (std::uint32_t(layer) << (texture_bits + depth_bits)) | (texture << depth_bits) | clamped_depth;
+}
+
+/// <summary>
+/// Records the vertices from first to the end as a command.
+/// </summary>
+/// <param name="key">The command's sort key.</param>
+/// <param name="type">How the vertices are joined.</param>
+/// <param name="texture">Texture to draw them with, or nullptr for none.</param>
+/// <param name="first">Where the command's vertices start.</param>
+void SpriteBatch::push_geometry(std::uint32_t key, sf::PrimitiveType type, const sf::Texture *texture, std::size_t first)
+{
+    const std::size_t count = m_vertices.size() - first;
+    if (count == 0)
+    {
+        return;
+    }
+
+    m_commands.push_back({key, COMMAND_GEOMETRY, type, texture,
+                          static_cast<std::uint32_t>(first), static_cast<std::uint32_t>(count)});
+}
+
+/// <summary>
+/// Orders the commands by key with a stable LSD radix sort, a byte at a
+/// time. Bytes that are the same in every key are skipped, so a frame all
+/// on one layer costs three passes or fewer.
+/// </summary>
+void SpriteBatch::sort()
+{
+    const std::size_t count = m_commands.size();
+    m_order.resize(count);
+    m_scratch.resize(count);
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        m_order[i] = i;
+    }
+
+    for (std::uint32_t shift = 0; shift < 32; shift += 8)
+    {
+        std::uint32_t counts[257] = {};
+        for (const RenderCommand &command : m_commands)
+        {
+            ++counts[((command.key >> shift) & 0xFF) + 1];
+        }
+
+        // Every key has the same byte here, so this pass would not move anything.
+        if (std::find(std::begin(counts) + 1, std::end(counts), std::uint32_t(count)) != std::end(counts))
+        {
+            continue;
+        }
+
+        for (int b = 0; b < 256; ++b)
+        {
+            counts[b + 1] += counts[b];
+        }
+        for (std::uint32_t index : m_order)
+        {
+            m_scratch[counts[(m_commands[index].key >> shift) & 0xFF]++] = index;
+        }
+        m_order.swap(m_scratch);
+    }
+}
+
+/// <summary>
+/// Adds a sprite's quad as two triangles.
+/// </summary>
+/// <param name="sprite">The sprite.</param>
+void SpriteBatch::append_sprite(const sf::Sprite &sprite)
+{
+    const sf::IntRect &rect = sprite.getTextureRect();
+    const float width = static_cast<float>(std::abs(rect.width));
+    const float height = static_cast<float>(std::abs(rect.height));
+
+    const float left = static_cast<float>(rect.left);
+    const float top = static_cast<float>(rect.top);
+    const float right = left + rect.width;
+    const float bottom = top + rect.height;
+
+    const sf::Transform &transform = sprite.getTransform();
+    const sf::Color &color = sprite.getColor();
+
+    const sf::Vertex corners[4] = {
+        sf::Vertex(transform.transformPoint(0.0f, 0.0f), color, {left, top}),
+        sf::Vertex(transform.transformPoint(width, 0.0f), color, {right, top}),
+        sf::Vertex(transform.transformPoint(width, height), color, {right, bottom}),
+        sf::Vertex(transform.transformPoint(0.0f, height), color, {left, bottom})
+    };
+
+    m_vertices.insert(m_vertices.end(), {corners[0], corners[1], corners[2], corners[0], corners[2], corners[3]});
+}
+
+/// <summary>
+/// Adds a convex shape's fill as a triangle fan from its first point.
+/// Texture coordinates map the shape's bounds onto its texture rect.
+/// </summary>
+/// <param name="shape">The shape.</param>
+void SpriteBatch::append_shape(const sf::Shape &shape)
+{
+    const std::size_t point_count = shape.getPointCount();
+    if (point_count < 3)
+    {
+        return;
+    }
+
+    const sf::Transform &transform = shape.getTransform();
+    const sf::Color &color = shape.getFillColor();
+    const sf::FloatRect bounds = shape.getLocalBounds();
+    const sf::IntRect &rect = shape.getTextureRect();
+
+    auto vertex = [&](const sf::Vector2f &point) {
+        const float u = bounds.width > 0.0f ? (point.x - bounds.left) / bounds.width : 0.0f;
+        const float v = bounds.height > 0.0f ? (point.y - bounds.top) / bounds.height : 0.0f;
+        return sf::Vertex(transform.transformPoint(point), color,
+            {rect.left + rect.width * u, rect.top + rect.height * v});
+    };
+
+    const sf::Vertex first = vertex(shape.getPoint(0));
+    sf::Vertex previous = vertex(shape.getPoint(1));
+    for (std::size_t i = 2; i < point_count; ++i)
+    {
+        const sf::Vertex current = vertex(shape.getPoint(i));
+        m_vertices.insert(m_vertices.end(), {first, previous, current});
+        previous = current;
+    }
+}
+
+/// <summary>
+/// Adds a shape's outline as two triangles per edge. Each point is pushed
+/// out along the mean of its two edge normals, the way SFML builds it.
+/// </summary>
+/// <param name="shape">The shape.</param>
+void SpriteBatch::append_outline(const sf::Shape &shape)
+{
+    const std::size_t point_count = shape.getPointCount();
+    if (point_count < 3)
+    {
+        return;
+    }
+
+    const sf::Transform &transform = shape.getTransform();
+    const sf::Color &color = shape.getOutlineColor();
+    const float thickness = shape.getOutlineThickness();
+
+    // Points inside the shape are on the other side of each edge from its normal.
+    std::vector<sf::Vector2f> points(point_count);
+    sf::Vector2f centre;
+    for (std::size_t i = 0; i < point_count; ++i)
+    {
+        points[i] = shape.getPoint(i);
+        centre += points[i];
+    }
+    centre /= static_cast<float>(point_count);
+
+    std::vector<sf::Vertex> ring(point_count * 2);
+    for (std::size_t i = 0; i < point_count; ++i)
+    {
+        const sf::Vector2f &p0 = points[(i + point_count - 1) % point_count];
+        const sf::Vector2f &p1 = points[i];
+        const sf::Vector2f &p2 = points[(i + 1) % point_count];
+
+        sf::Vector2f n1 = edge_normal(p0, p1);
+        sf::Vector2f n2 = edge_normal(p1, p2);
+        const sf::Vector2f inward = centre - p1;
+        if (n1.x * inward.x + n1.y * inward.y > 0.0f) n1 = -n1;
+        if (n2.x * inward.x + n2.y * inward.y > 0.0f) n2 = -n2;
+
+        const float factor = 1.0f + (n1.x * n2.x + n1.y * n2.y);
+        const sf::Vector2f normal = factor != 0.0f ? (n1 + n2) / factor : n1;
+
+        ring[i * 2] = sf::Vertex(transform.transformPoint(p1), color);
+        ring[i * 2 + 1] = sf::Vertex(transform.transformPoint(p1 + normal * thickness), color);
+    }
+
+    for (std::size_t i = 0; i < point_count; ++i)
+    {
+        const std::size_t j = (i + 1) % point_count;
+        const sf::Vertex &inner_i = ring[i * 2];
+        const sf::Vertex &outer_i = ring[i * 2 + 1];
+        const sf::Vertex &inner_j = ring[j * 2];
+        const sf::Vertex &outer_j = ring[j * 2 + 1];
+        m_vertices.insert(m_vertices.end(), {inner_i, outer_i, inner_j, outer_i, outer_j, inner_j});
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include "render_snapshot.hpp"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// SpriteBatch
+// Collects a frame's drawables as render commands, sorts them by a
+// layer/texture/depth key and builds a RenderSnapshot in which runs that
+// share a texture are one triangle list. Drawables are copied when they
+// are added: sf::Sprite, sf::Shape and sf::VertexArray are turned into
+// vertices and sf::Text is copied whole, so the caller's objects can
+// change or go away straight after.
+class SpriteBatch
+{
+public:
+    // Adds a drawable for this frame. Lower layers are drawn first; within a
+    // layer commands are grouped by texture, then ordered by depth. Throws
+    // std::logic_error for a drawable type that cannot be copied.
+    void add(const sf::Drawable *drawable, std::uint8_t layer = 0, std::uint16_t depth = 0);
+    // Adds raw vertices for this frame, e.g. a particle buffer's.
+    void add_vertices(const sf::Vertex *vertices, std::size_t count, sf::PrimitiveType type,
+                      const sf::Texture *texture, std::uint8_t layer = 0, std::uint16_t depth = 0);
+
+    // Sorts everything added since the last build into snapshot, merging
+    // runs that can be drawn together, and forgets it.
+    void build(RenderSnapshot &snapshot);
+    void clear();
+
+    std::size_t size() const { return m_commands.size(); }
+
+private:
+    enum CommandKind : std::uint8_t
+    {
+        COMMAND_GEOMETRY,
+        COMMAND_TEXT
+    };
+
+    struct RenderCommand
+    {
+        std::uint32_t key;
+        CommandKind kind;
+        sf::PrimitiveType type;
+        const sf::Texture *texture;
+        std::uint32_t first;        // into m_vertices, or into m_texts for a text
+        std::uint32_t count;
+    };
+
+    // Key layout, high to low: layer 8 bits, texture 12 bits, depth 12 bits.
+    static constexpr std::uint32_t texture_bits = 12;
+    static constexpr std::uint32_t depth_bits = 12;
+    static constexpr std::uint32_t untextured_id = 0;
+    static constexpr std::uint32_t unbatched_id = (1u << texture_bits) - 1;
+
+    std::vector<RenderCommand> m_commands;
+    std::vector<std::uint32_t> m_order;     // command indices, sorted by key
+    std::vector<std::uint32_t> m_scratch;
+    std::unordered_map<const sf::Texture *, std::uint32_t> m_texture_ids;   // this frame's
+    std::vector<sf::Vertex> m_vertices;     // every command's vertices, in the order added
+    std::vector<sf::Text> m_texts;
+
+    std::uint32_t texture_id(const sf::Texture *texture);
+    static std::uint32_t make_key(std::uint8_t layer, std::uint32_t texture, std::uint16_t depth);
+    void push_geometry(std::uint32_t key, sf::PrimitiveType type, const sf::Texture *texture, std::size_t first);
+    void sort();
+    void append_sprite(const sf::Sprite &sprite);
+    void append_shape(const sf::Shape &shape);
+    void append_outline(const sf::Shape &shape);
+};
@@ -0,0 +1,104 @@
+#include "system.hpp"
+#include <atomic>
+
+/// <summary>
+/// Checks whether two systems may not run at the same time.
+/// </summary>
+/// <param name="other">The other system's access.</param>
+/// <returns>True if either writes something the other touches.</returns>
+bool SystemAccess::conflicts_with(const SystemAccess &other) const
+{
+    const ComponentMask my_components = read_components | write_components;
+    const ComponentMask other_components = other.read_components | other.write_components;
+    const std::uint32_t my_resources = read_resources | write_resources;
+    const std::uint32_t other_resources = other.read_resources | other.write_resources;
+
+    return (write_components & other_components) != 0
+        || (other.write_components & my_components) != 0
+        || (write_resources & other_resources) != 0
+        || (other.write_resources & my_resources) != 0;
+}
+
+/// <summary>
+/// Removes every system and hands their components back to Entity::update.
+/// </summary>
+/// <param name="entities">The entities the systems were driving.</param>
+void Scheduler::clear(EntityManager &entities)
+{
+    for (const std::unique_ptr<System> &system : m_systems)
+    {
+        entities.scheduled &= ~system->get_driven();
+    }
+    m_systems.clear();
+}
+
+/// <summary>
+/// Runs every system in a phase once. Builds the dependency graph from the
+/// declared access sets, then runs systems on the thread pool as soon as
+/// everything they depend on has finished.
+/// </summary>
+/// <param name="entities">The entities to run the systems over.</param>
+/// <param name="phase">The phase being run.</param>
+/// <param name="dt">Delta Time - linked to frame rate.</param>
+void Scheduler::run(EntityManager &entities, FramePhase phase, const float &dt)
+{
+    std::vector<System *> systems;
+    for (const std::unique_ptr<System> &system : m_systems)
+    {
+        if (system->get_phase() == phase)
+        {
+            systems.push_back(system.get());
+        }
+    }
+
+    const std::size_t count = systems.size();
+    if (count == 0)
+    {
+        return;
+    }
+
+    // Edges go from each system to the later systems that conflict with it,
+    // so conflicting systems keep their registration order.
+    std::vector<std::vector<std::size_t>> dependents(count);
+    std::unique_ptr<std::atomic<int>[]> waiting_on(new std::atomic<int>[count]);
+
+    for (std::size_t j = 0; j < count; ++j)
+    {
+        waiting_on[j].store(0, std::memory_order_relaxed);
+        for (std::size_t i = 0; i < j; ++i)
+        {
+            if (systems[i]->get_access().conflicts_with(systems[j]->get_access()))
+            {
+                dependents[i].push_back(j);
+                waiting_on[j].fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    ThreadPool &pool = ThreadPool::shared();
+    ThreadPool::TaskGroup group;
+
+    std::function<void(std::size_t)> launch = [&](std::size_t index) {
+        pool.submit(group, [&, index]() {
+            systems[index]->run(entities, dt);
+
+            for (std::size_t next : dependents[index])
+            {
+                if (waiting_on[next].fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    launch(next);
+                }
+            }
+        });
+    };
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (waiting_on[i].load(std::memory_order_relaxed) == 0)
+        {
+            launch(i);
+        }
+    }
+
+    pool.wait(group);
+}
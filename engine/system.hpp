@@ -0,0 +1,95 @@
+#pragma once
+
+#include "ecm.hpp"
+#include "thread_pool.hpp"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Shared engine state that systems touch outside of components.
+enum SystemResource : std::uint32_t
+{
+    RESOURCE_TRANSFORM = 1u << 0,   // other entities' positions and rotations
+    RESOURCE_PHYSICS = 1u << 1,     // the Box2D world and its bodies
+    RESOURCE_LEVEL = 1u << 2,       // the LevelSystem tile grid
+    RESOURCE_ENTITIES = 1u << 3,    // creating, pooling or destroying entities, and resolving handles
+    RESOURCE_PROJECTILES = 1u << 4  // the scene's ProjectileBuffer
+};
+
+// What a system reads and writes. Two systems conflict when either one
+// writes something the other reads or writes.
+struct SystemAccess
+{
+    ComponentMask read_components = 0;
+    ComponentMask write_components = 0;
+    std::uint32_t read_resources = 0;
+    std::uint32_t write_resources = 0;
+
+    bool conflicts_with(const SystemAccess &other) const;
+};
+
+// System
+// Runs one piece of game logic over a component query, once per frame in
+// its phase. Systems declare their phase, reads and writes in their
+// constructor so the Scheduler can run the ones that do not conflict at
+// the same time. The components a system drives are skipped by
+// Entity::update while the system is scheduled.
+class System
+{
+public:
+    virtual ~System() = default;
+    virtual void run(EntityManager &entities, const float &dt) = 0;
+
+    const SystemAccess &get_access() const { return m_access; }
+    ComponentMask get_driven() const { return m_driven; }
+    FramePhase get_phase() const { return m_phase; }
+
+protected:
+    void runs_in(FramePhase phase) { m_phase = phase; }
+    template<typename T> void reads() { m_access.read_components |= ComponentType::bit<T>(); }
+    template<typename T> void writes() { m_access.write_components |= ComponentType::bit<T>(); }
+    template<typename T> void drives() { writes<T>(); m_driven |= ComponentType::bit<T>(); }
+    void reads_resource(std::uint32_t r) { m_access.read_resources |= r; }
+    void writes_resource(std::uint32_t r) { m_access.write_resources |= r; }
+
+    // Runs fn on every component in parallel chunks on the shared pool.
+    template<typename T, typename F>
+    void parallel_each(const std::vector<T *> &components, F fn, std::size_t min_chunk = 16)
+    {
+        ThreadPool::shared().parallel_for(components.size(), min_chunk,
+            [&components, &fn](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    fn(*components[i]);
+                }
+            });
+    }
+
+private:
+    SystemAccess m_access;
+    ComponentMask m_driven = 0;
+    FramePhase m_phase = PHASE_PRE_PHYSICS;
+};
+
+// Scheduler
+// Builds a dependency graph over the systems in a phase every frame. A
+// system depends on every earlier-registered system it conflicts with, and
+// the graph is run on the shared work-stealing pool as dependencies clear.
+class Scheduler
+{
+public:
+    template<typename T, typename... Targs>
+    T &add(EntityManager &entities, Targs... params)
+    {
+        m_systems.push_back(std::make_unique<T>(params...));
+        entities.scheduled |= m_systems.back()->get_driven();
+        return static_cast<T &>(*m_systems.back());
+    }
+
+    void clear(EntityManager &entities);
+    void run(EntityManager &entities, FramePhase phase, const float &dt);
+    bool empty() const { return m_systems.empty(); }
+
+private:
+    std::vector<std::unique_ptr<System>> m_systems;
+};
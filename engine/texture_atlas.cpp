@@ -0,0 +1,118 @@
+#include "texture_atlas.hpp"
+#include "renderer.hpp"
+#include "resource_cache.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+/// <summary>
+/// Creates an empty atlas. The texture is made on the first add, so an atlas
+/// that is never used never needs a graphics context.
+/// </summary>
+/// <param name="size">Width and height of the atlas texture in pixels.</param>
+TextureAtlas::TextureAtlas(unsigned int size) : m_size(size) {}
+
+/// <summary>
+/// Gets the atlas shared by sprite components.
+/// </summary>
+/// <returns>The atlas.</returns>
+TextureAtlas &TextureAtlas::shared()
+{
+    // Asking the GPU for its limit needs a graphics context.
+    static TextureAtlas atlas(Renderer::is_software() ? 2048u : std::min(2048u, sf::Texture::getMaximumSize()));
+    return atlas;
+}
+
+/// <summary>
+/// Loads an image file into the atlas. Loading the same path again returns
+/// the region it already has.
+/// </summary>
+/// <param name="file_path">Path to the image.</param>
+/// <param name="region">Receives where the image is in the atlas.</param>
+/// <returns>Whether the image could be loaded.</returns>
+bool TextureAtlas::load(const std::string &file_path, sf::IntRect &region)
+{
+    auto loaded = m_loaded.find(file_path);
+    if (loaded != m_loaded.end())
+    {
+        region = loaded->second;
+        return true;
+    }
+
+    // Decoded through the cache, so a preloaded image is not read again.
+    std::shared_ptr<const sf::Image> image = ResourceCache::get_image(file_path);
+    if (!image)
+    {
+        return false;
+    }
+
+    region = add(*image);
+    m_loaded[file_path] = region;
+    return true;
+}
+
+/// <summary>
+/// Copies an image onto the first shelf it fits without wasting more than
+/// half the shelf's height, or onto a new shelf.
+/// </summary>
+/// <param name="image">The image to add.</param>
+/// <returns>Where the image is in the atlas.</returns>
+sf::IntRect TextureAtlas::add(const sf::Image &image)
+{
+    const sf::Vector2u image_size = image.getSize();
+    const unsigned int width = image_size.x + padding;
+    const unsigned int height = image_size.y + padding;
+
+    if (width > m_size || height > m_size)
+    {
+        throw std::length_error("Image is larger than the texture atlas.");
+    }
+
+    if (!m_created)
+    {
+        m_software = Renderer::is_software();
+        if (m_software)
+        {
+            m_image.create(m_size, m_size, sf::Color::Transparent);
+        }
+        else if (!m_texture.create(m_size, m_size))
+        {
+            throw std::string("Couldn't create the texture atlas.");
+        }
+        m_created = true;
+    }
+
+    Shelf *shelf = nullptr;
+    for (Shelf &candidate : m_shelves)
+    {
+        if (height <= candidate.height && height * 2 >= candidate.height && candidate.next_x + width <= m_size)
+        {
+            shelf = &candidate;
+            break;
+        }
+    }
+
+    if (!shelf)
+    {
+        if (m_next_top + height > m_size)
+        {
+            throw std::length_error("Texture atlas is full.");
+        }
+        m_shelves.push_back({m_next_top, height, 0});
+        m_next_top += height;
+        shelf = &m_shelves.back();
+    }
+
+    const sf::IntRect region(shelf->next_x, shelf->top, image_size.x, image_size.y);
+    shelf->next_x += width;
+
+    if (m_software)
+    {
+        m_image.copy(image, region.left, region.top);
+        Renderer::update_texture_image(&m_texture, m_image);
+    }
+    else
+    {
+        m_texture.update(image, region.left, region.top);
+    }
+    return region;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+// TextureAtlas
+// Packs many small images into one texture, so sprites that use them share
+// a texture and the renderer can draw them in one batch. Images are placed
+// on shelves: rows as tall as their tallest image, filled left to right.
+// With the software renderer there is no GPU, so the atlas is kept as an
+// image instead; the texture is never created and only names it, and the
+// rasterizer is given the image each time something is added.
+class TextureAtlas
+{
+public:
+    explicit TextureAtlas(unsigned int size = 1024);
+
+    // The atlas used by sprite components.
+    static TextureAtlas &shared();
+
+    // Loads an image file into the atlas, once per path, through the ResourceCache.
+    // Returns false if the file could not be loaded.
+    bool load(const std::string &file_path, sf::IntRect &region);
+
+    // Copies an image into the atlas and returns where it went.
+    // Throws std::length_error if there is no room left.
+    sf::IntRect add(const sf::Image &image);
+
+    const sf::Texture &get_texture() const { return m_texture; }
+    unsigned int get_size() const { return m_size; }
+
+private:
+    struct Shelf
+    {
+        unsigned int top;
+        unsigned int height;
+        unsigned int next_x;    // where the next image on this shelf goes
+    };
+
+    // Gap left around each image so filtering does not bleed between them.
+    static constexpr unsigned int padding = 1;
+
+    unsigned int m_size;
+    bool m_created = false;
+    bool m_software = false;    // pixels are in m_image, not m_texture
+    sf::Texture m_texture;
+    sf::Image m_image;
+    std::vector<Shelf> m_shelves;
+    unsigned int m_next_top = 0;    // top of the next new shelf
+    std::map<std::string, sf::IntRect> m_loaded;
+};
@@ -0,0 +1,232 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+
+namespace
+{
+    // Which pool and queue the current thread works from.
+    thread_local ThreadPool *t_pool = nullptr;
+    thread_local std::size_t t_queue = 0;
+}
+
+/// <summary>
+/// Starts the pool's worker threads.
+/// </summary>
+/// <param name="worker_count">Number of worker threads. Zero runs every task on the waiting thread.</param>
+ThreadPool::ThreadPool(std::size_t worker_count)
+{
+    // The last queue is shared by threads outside the pool.
+    for (std::size_t i = 0; i < worker_count + 1; ++i)
+    {
+        m_queues.push_back(std::make_unique<Queue>());
+    }
+
+    for (std::size_t i = 0; i < worker_count; ++i)
+    {
+        m_workers.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+/// <summary>
+/// Stops and joins the workers once every queued task has run.
+/// </summary>
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (std::thread &worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+/// <summary>
+/// Gets the pool shared by the engine, sized to the machine.
+/// </summary>
+/// <returns>The shared pool.</returns>
+ThreadPool &ThreadPool::shared()
+{
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+/// <summary>
+/// Gets how many threads can run tasks at once, counting the caller.
+/// </summary>
+/// <returns>The worker count plus one.</returns>
+std::size_t ThreadPool::get_concurrency() const
+{
+    return m_workers.size() + 1;
+}
+
+/// <summary>
+/// Queues a task as part of a group.
+/// Workers push onto their own queue, other threads onto the shared one.
+/// </summary>
+/// <param name="group">The group the task belongs to.</param>
+/// <param name="task">The task to run.</param>
+void ThreadPool::submit(TaskGroup &group, Task task)
+{
+    group.m_pending.fetch_add(1, std::memory_order_relaxed);
+
+    const std::size_t home = (t_pool == this) ? t_queue : m_queues.size() - 1;
+    {
+        std::lock_guard<std::mutex> lock(m_queues[home]->mutex);
+        m_queues[home]->tasks.emplace_back(&group, std::move(task));
+    }
+    m_queued.fetch_add(1, std::memory_order_release);
+
+    // Taking the lock orders this wake-up after a sleeping worker's check.
+    {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+    }
+    m_wake.notify_one();
+}
+
+/// <summary>
+/// Waits for every task in the group, running queued tasks meanwhile.
+/// Rethrows the first exception any of them threw.
+/// </summary>
+/// <param name="group">The group to wait on.</param>
+void ThreadPool::wait(TaskGroup &group)
+{
+    const std::size_t home = (t_pool == this) ? t_queue : m_queues.size() - 1;
+
+    while (!group.done())
+    {
+        if (!try_run_one(home))
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(group.m_error_mutex);
+        error = std::move(group.m_error);
+        group.m_error = nullptr;
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+/// <summary>
+/// Runs fn over [0, count) in chunks spread across the pool.
+/// </summary>
+/// <param name="count">Number of items.</param>
+/// <param name="min_chunk">Smallest chunk worth handing to another thread.</param>
+/// <param name="fn">Called with each chunk's [begin, end).</param>
+void ThreadPool::parallel_for(std::size_t count, std::size_t min_chunk, const std::function<void(std::size_t, std::size_t)> &fn)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    min_chunk = std::max<std::size_t>(min_chunk, 1);
+    const std::size_t max_chunks = get_concurrency() * 4;
+    const std::size_t chunks = std::min(max_chunks, (count + min_chunk - 1) / min_chunk);
+
+    if (chunks <= 1)
+    {
+        fn(0, count);
+        return;
+    }
+
+    const std::size_t chunk_size = (count + chunks - 1) / chunks;
+    TaskGroup group;
+
+    for (std::size_t begin = 0; begin < count; begin += chunk_size)
+    {
+        const std::size_t end = std::min(count, begin + chunk_size);
+        submit(group, [&fn, begin, end]() { fn(begin, end); });
+    }
+
+    wait(group);
+}
+
+/// <summary>
+/// Runs one task, preferring the newest task on the home queue and
+/// otherwise stealing the oldest task from another queue.
+/// </summary>
+/// <param name="home">The caller's own queue.</param>
+/// <returns>Whether a task was run.</returns>
+bool ThreadPool::try_run_one(std::size_t home)
+{
+    std::pair<TaskGroup *, Task> item{nullptr, nullptr};
+
+    {
+        std::lock_guard<std::mutex> lock(m_queues[home]->mutex);
+        if (!m_queues[home]->tasks.empty())
+        {
+            item = std::move(m_queues[home]->tasks.back());
+            m_queues[home]->tasks.pop_back();
+        }
+    }
+
+    for (std::size_t i = 1; !item.first && i < m_queues.size(); ++i)
+    {
+        Queue &victim = *m_queues[(home + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            item = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+
+    if (!item.first)
+    {
+        return false;
+    }
+
+    m_queued.fetch_sub(1, std::memory_order_relaxed);
+    try
+    {
+        item.second();
+    }
+    catch (...)
+    {
+        // Kept for wait(); the task still counts as finished so waiters wake.
+        std::lock_guard<std::mutex> lock(item.first->m_error_mutex);
+        if (!item.first->m_error)
+        {
+            item.first->m_error = std::current_exception();
+        }
+    }
+    item.first->m_pending.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+/// <summary>
+/// Worker thread body. Runs tasks until the pool stops, sleeping when idle.
+/// </summary>
+/// <param name="index">The worker's queue index.</param>
+void ThreadPool::worker_loop(std::size_t index)
+{
+    t_pool = this;
+    t_queue = index;
+
+    while (true)
+    {
+        if (try_run_one(index))
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleep_mutex);
+        m_wake.wait(lock, [this]() {
+            return m_stopping || m_queued.load(std::memory_order_acquire) > 0;
+        });
+
+        if (m_stopping && m_queued.load(std::memory_order_acquire) == 0)
+        {
+            return;
+        }
+    }
+}
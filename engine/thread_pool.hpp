@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ThreadPool
+// A small work-stealing pool. Every worker owns a task deque: it pops its
+// own work from the back and steals from the front of the others' deques
+// when it runs dry. Threads that wait on a TaskGroup help run tasks
+// instead of blocking, so nested parallel work cannot deadlock the pool.
+class ThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+    // Counts outstanding tasks so a caller can wait for a batch to finish.
+    // The first exception a task throws is kept for wait() to rethrow.
+    class TaskGroup
+    {
+    public:
+        bool done() const { return m_pending.load(std::memory_order_acquire) == 0; }
+    private:
+        friend class ThreadPool;
+        std::atomic<int> m_pending{0};
+        std::mutex m_error_mutex;
+        std::exception_ptr m_error;
+    };
+
+    explicit ThreadPool(std::size_t worker_count);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Shared pool with one worker per extra hardware thread.
+    static ThreadPool &shared();
+
+    void submit(TaskGroup &group, Task task);
+    // Rethrows the first exception thrown by a task in the group, once
+    // every task in it has finished.
+    void wait(TaskGroup &group);
+
+    // Splits [0, count) into chunks of at least min_chunk and runs fn(begin, end)
+    // for each chunk across the pool. Returns when every chunk has run.
+    void parallel_for(std::size_t count, std::size_t min_chunk, const std::function<void(std::size_t, std::size_t)> &fn);
+
+    // Workers plus the calling thread.
+    std::size_t get_concurrency() const;
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::pair<TaskGroup *, Task>> tasks;
+    };
+
+    bool try_run_one(std::size_t home);
+    void worker_loop(std::size_t index);
+
+    std::vector<std::unique_ptr<Queue>> m_queues;   // one per worker, plus one for outside threads
+    std::vector<std::thread> m_workers;
+    std::atomic<int> m_queued{0};
+    std::mutex m_sleep_mutex;
+    std::condition_variable m_wake;
+    bool m_stopping = false;
+};
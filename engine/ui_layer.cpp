@@ -0,0 +1,441 @@
+#include "ui_layer.hpp"
+#include "renderer.hpp"
+#include "resource_cache.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    // Where an anchor sits across and down the screen, and the element, 0 to 1.
+    sf::Vector2f anchor_point(UiLayer::Anchor anchor)
+    {
+        return sf::Vector2f((anchor % 3) * 0.5f, (anchor / 3) * 0.5f);
+    }
+
+    // Two triangles covering a rectangle, with one colour.
+    void append_quad(std::vector<sf::Vertex> &out, const sf::FloatRect &rect, const sf::FloatRect &uv, const sf::Color &color)
+    {
+        const float right = rect.left + rect.width;
+        const float bottom = rect.top + rect.height;
+        const float u_right = uv.left + uv.width;
+        const float v_bottom = uv.top + uv.height;
+
+        const sf::Vertex top_left({rect.left, rect.top}, color, {uv.left, uv.top});
+        const sf::Vertex top_right({right, rect.top}, color, {u_right, uv.top});
+        const sf::Vertex bottom_right({right, bottom}, color, {u_right, v_bottom});
+        const sf::Vertex bottom_left({rect.left, bottom}, color, {uv.left, v_bottom});
+
+        out.insert(out.end(), {top_left, top_right, bottom_right, top_left, bottom_right, bottom_left});
+    }
+}
+
+/// <summary>
+/// Makes a layer with a font.
+/// </summary>
+/// <param name="font_path">Path to the font for the layer's text.</param>
+/// <param name="character_size">Size whose font page panels are drawn from.</param>
+UiLayer::UiLayer(const std::string &font_path, unsigned int character_size)
+{
+    set_font(font_path, character_size);
+}
+
+/// <summary>
+/// Sets the font. Everything is laid out again. The software renderer
+/// draws its glyphs from a SoftwareFont of the same file, and without one
+/// the layer has no font at all, as sf::Font's glyphs need a GPU.
+/// </summary>
+/// <param name="font_path">Path to the font for the layer's text.</param>
+/// <param name="character_size">Size whose font page panels are drawn from.</param>
+/// <returns>Whether the font could be loaded.</returns>
+bool UiLayer::set_font(const std::string &font_path, unsigned int character_size)
+{
+    m_font = ResourceCache::get_font(font_path);
+    m_glyphs = Renderer::is_software() ? ResourceCache::get_software_font(font_path) : nullptr;
+    if (Renderer::is_software() && !m_glyphs)
+    {
+        m_font.reset();
+    }
+    m_character_size = character_size;
+    m_warm_sizes.clear();
+    warm(character_size);
+    for (ElementData &element : m_elements)
+    {
+        element.dirty = true;
+    }
+    m_dirty = true;
+    return m_font != nullptr;
+}
+
+/// <summary>
+/// Adds a text.
+/// </summary>
+/// <param name="text">The string. New lines start new lines.</param>
+/// <param name="character_size">Character size in pixels.</param>
+/// <param name="color">Text colour.</param>
+/// <param name="anchor">Where on the screen it sits.</param>
+/// <param name="offset">Pixels to move it from the anchor.</param>
+/// <returns>The element, for the setters.</returns>
+UiLayer::Element UiLayer::add_text(const std::string &text, unsigned int character_size, const sf::Color &color,
+                                   Anchor anchor, const sf::Vector2f &offset)
+{
+    ElementData element;
+    element.kind = ELEMENT_TEXT;
+    element.text = text;
+    element.character_size = character_size;
+    element.color = color;
+    element.anchor = anchor;
+    element.offset = offset;
+    warm(character_size);
+    return add(std::move(element));
+}
+
+/// <summary>
+/// Adds a solid rectangle.
+/// </summary>
+/// <param name="size">Size in pixels. A zero side stretches across the screen.</param>
+/// <param name="color">Fill colour.</param>
+/// <param name="anchor">Where on the screen it sits.</param>
+/// <param name="offset">Pixels to move it from the anchor.</param>
+/// <returns>The element, for the setters.</returns>
+UiLayer::Element UiLayer::add_panel(const sf::Vector2f &size, const sf::Color &color,
+                                    Anchor anchor, const sf::Vector2f &offset)
+{
+    ElementData element;
+    element.kind = ELEMENT_PANEL;
+    element.character_size = 0;
+    element.color = color;
+    element.anchor = anchor;
+    element.offset = offset;
+    element.size = size;
+    return add(std::move(element));
+}
+
+/// <summary>
+/// Changes a text's string. Only lays it out again if it is different.
+/// </summary>
+/// <param name="element">The text.</param>
+/// <param name="text">The new string.</param>
+void UiLayer::set_text(Element element, const std::string &text)
+{
+    ElementData &data = m_elements.at(element);
+    if (data.text == text)
+    {
+        return;
+    }
+
+    data.text = text;
+    data.dirty = true;
+    m_dirty = true;
+}
+
+/// <summary>
+/// Changes a panel's size.
+/// </summary>
+/// <param name="element">The panel.</param>
+/// <param name="size">The new size. A zero side stretches across the screen.</param>
+void UiLayer::set_size(Element element, const sf::Vector2f &size)
+{
+    ElementData &data = m_elements.at(element);
+    if (data.size == size)
+    {
+        return;
+    }
+
+    data.size = size;
+    data.dirty = true;
+    m_dirty = true;
+}
+
+/// <summary>
+/// Recolours an element without laying it out again.
+/// </summary>
+/// <param name="element">The element.</param>
+/// <param name="color">The new colour.</param>
+void UiLayer::set_color(Element element, const sf::Color &color)
+{
+    ElementData &data = m_elements.at(element);
+    if (data.color == color)
+    {
+        return;
+    }
+
+    data.color = color;
+    for (sf::Vertex &vertex : data.local)
+    {
+        vertex.color = color;
+    }
+    m_dirty = true;
+}
+
+/// <summary>
+/// Shows or hides an element.
+/// </summary>
+/// <param name="element">The element.</param>
+/// <param name="visible">Whether to draw it.</param>
+void UiLayer::set_visible(Element element, bool visible)
+{
+    ElementData &data = m_elements.at(element);
+    if (data.visible == visible)
+    {
+        return;
+    }
+
+    data.visible = visible;
+    m_dirty = true;
+}
+
+/// <summary>
+/// Brings the layer up to date and queues it to be drawn in screen space.
+/// Costs a copy of the vertices when nothing has changed.
+/// </summary>
+void UiLayer::render()
+{
+    const sf::Vector2f screen_size = Renderer::get_screen_size();
+    if (screen_size != m_screen_size)
+    {
+        m_screen_size = screen_size;
+        m_dirty = true;
+
+        // Only stretched panels depend on the screen's size; the rest just move.
+        for (ElementData &element : m_elements)
+        {
+            if (element.kind == ELEMENT_PANEL && (element.size.x == 0.0f || element.size.y == 0.0f))
+            {
+                element.dirty = true;
+            }
+        }
+    }
+
+    if (m_dirty)
+    {
+        rebuild();
+    }
+
+    // Runs are layered in order, so the batcher's texture sort cannot
+    // draw a later element under an earlier one.
+    for (std::size_t i = 0; i < m_runs.size(); ++i)
+    {
+        const Run &run = m_runs[i];
+        const std::uint8_t layer = static_cast<std::uint8_t>(std::min<std::size_t>(i, 255));
+        Renderer::queue_screen_vertices(&m_vertices[run.first], run.count, sf::Triangles, run.texture, layer);
+    }
+}
+
+/// <summary>
+/// Removes every element.
+/// </summary>
+void UiLayer::clear()
+{
+    m_elements.clear();
+    m_vertices.clear();
+    m_runs.clear();
+    m_dirty = true;
+}
+
+/// <summary>
+/// Stores a new element.
+/// </summary>
+/// <param name="element">The element.</param>
+/// <returns>Its index.</returns>
+UiLayer::Element UiLayer::add(ElementData element)
+{
+    m_elements.push_back(std::move(element));
+    m_dirty = true;
+    return m_elements.size() - 1;
+}
+
+/// <summary>
+/// Lays an element out around its own origin.
+/// </summary>
+/// <param name="element">The element.</param>
+void UiLayer::layout(ElementData &element)
+{
+    element.local.clear();
+    element.bounds = sf::FloatRect();
+    element.texture = nullptr;
+
+    if (element.kind == ELEMENT_TEXT)
+    {
+        layout_text(element);
+    }
+    else
+    {
+        layout_panel(element);
+    }
+
+    element.dirty = false;
+    ++m_layouts;
+}
+
+/// <summary>
+/// Lays a text out a glyph at a time, the way sf::Text does: lines start
+/// at x 0 with the first baseline one character size down.
+/// </summary>
+/// <param name="element">The text.</param>
+void UiLayer::layout_text(ElementData &element)
+{
+    if (!m_font || element.text.empty())
+    {
+        return;
+    }
+
+    const sf::Font &font = *m_font;
+    const unsigned int size = element.character_size;
+    warm(size);
+    const float line_spacing = font.getLineSpacing(size);
+    element.texture = m_glyphs ? m_glyphs->get_texture() : &font.getTexture(size);
+
+    float x = 0.0f;
+    float y = static_cast<float>(size);
+    float min_x = std::numeric_limits<float>::max();
+    float min_y = std::numeric_limits<float>::max();
+    float max_x = std::numeric_limits<float>::lowest();
+    float max_y = std::numeric_limits<float>::lowest();
+    sf::Uint32 previous = 0;
+
+    for (unsigned char character : element.text)
+    {
+        const sf::Uint32 current = character;
+        if (current == '\r')
+        {
+            continue;
+        }
+
+        x += font.getKerning(previous, current, size);
+        previous = current;
+
+        if (current == '\n')
+        {
+            x = 0.0f;
+            y += line_spacing;
+            continue;
+        }
+
+        const sf::Glyph &glyph = m_glyphs ? m_glyphs->get_glyph(current, size) : font.getGlyph(current, size, false);
+        if (glyph.bounds.width > 0.0f && glyph.bounds.height > 0.0f)
+        {
+            const sf::FloatRect rect(x + glyph.bounds.left, y + glyph.bounds.top, glyph.bounds.width, glyph.bounds.height);
+            const sf::FloatRect uv(static_cast<float>(glyph.textureRect.left), static_cast<float>(glyph.textureRect.top),
+                                   static_cast<float>(glyph.textureRect.width), static_cast<float>(glyph.textureRect.height));
+            append_quad(element.local, rect, uv, element.color);
+
+            min_x = std::min(min_x, rect.left);
+            min_y = std::min(min_y, rect.top);
+            max_x = std::max(max_x, rect.left + rect.width);
+            max_y = std::max(max_y, rect.top + rect.height);
+        }
+        x += glyph.advance;
+    }
+
+    if (!element.local.empty())
+    {
+        element.bounds = sf::FloatRect(min_x, min_y, max_x - min_x, max_y - min_y);
+    }
+}
+
+/// <summary>
+/// Lays a panel out as one quad. With a font it samples the white square
+/// at the corner of the font's page, so it batches with the text.
+/// </summary>
+/// <param name="element">The panel.</param>
+void UiLayer::layout_panel(ElementData &element)
+{
+    const sf::Vector2f size(element.size.x == 0.0f ? m_screen_size.x : element.size.x,
+                            element.size.y == 0.0f ? m_screen_size.y : element.size.y);
+    if (size.x <= 0.0f || size.y <= 0.0f)
+    {
+        return;
+    }
+
+    if (m_font)
+    {
+        element.texture = m_glyphs ? m_glyphs->get_texture() : &m_font->getTexture(m_character_size);
+    }
+
+    element.bounds = sf::FloatRect(0.0f, 0.0f, size.x, size.y);
+    append_quad(element.local, element.bounds, sf::FloatRect(1.0f, 1.0f, 0.0f, 0.0f), element.color);
+}
+
+/// <summary>
+/// Lays out the elements that changed, places every visible element on the
+/// screen and joins neighbours with the same texture into runs.
+/// </summary>
+void UiLayer::rebuild()
+{
+    m_vertices.clear();
+    m_runs.clear();
+
+    for (ElementData &element : m_elements)
+    {
+        if (!element.visible)
+        {
+            continue;
+        }
+
+        if (element.dirty)
+        {
+            layout(element);
+        }
+
+        if (element.local.empty())
+        {
+            continue;
+        }
+
+        // The element's anchor point goes on the screen's anchor point.
+        const sf::Vector2f anchor = anchor_point(element.anchor);
+        const sf::Vector2f pivot(element.bounds.left + element.bounds.width * anchor.x,
+                                 element.bounds.top + element.bounds.height * anchor.y);
+        const sf::Vector2f position(m_screen_size.x * anchor.x + element.offset.x - pivot.x,
+                                    m_screen_size.y * anchor.y + element.offset.y - pivot.y);
+
+        if (m_runs.empty() || m_runs.back().texture != element.texture)
+        {
+            m_runs.push_back({m_vertices.size(), 0, element.texture});
+        }
+
+        for (sf::Vertex vertex : element.local)
+        {
+            vertex.position += position;
+            m_vertices.push_back(vertex);
+        }
+        m_runs.back().count += element.local.size();
+    }
+
+    m_dirty = false;
+}
+
+/// <summary>
+/// Makes the font's glyph for every character a text can hold at a size,
+/// after waiting for the render thread, so laying out never changes the
+/// font's texture while a frame is drawn with it. Does nothing for sizes
+/// already made. A software font's page is given to the rasterizer after.
+/// </summary>
+/// <param name="character_size">The character size.</param>
+void UiLayer::warm(unsigned int character_size)
+{
+    if (!m_font || std::find(m_warm_sizes.begin(), m_warm_sizes.end(), character_size) != m_warm_sizes.end())
+    {
+        return;
+    }
+
+    if (m_glyphs)
+    {
+        for (sf::Uint32 character = 0; character <= std::numeric_limits<unsigned char>::max(); ++character)
+        {
+            m_glyphs->get_glyph(character, character_size);
+        }
+        Renderer::update_texture_image(m_glyphs->get_texture(), m_glyphs->get_image());
+        m_warm_sizes.push_back(character_size);
+        return;
+    }
+
+    Renderer::sync();
+    m_font->getTexture(character_size);
+    // Texts are laid out a byte at a time, so these are all it can ask for.
+    for (sf::Uint32 character = 0; character <= std::numeric_limits<unsigned char>::max(); ++character)
+    {
+        m_font->getGlyph(character, character_size, false);
+    }
+    m_warm_sizes.push_back(character_size);
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include "software_font.hpp"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// UiLayer
+// Retained screen-space text and panels, e.g. menus and the HUD. Elements
+// are made once and changed through setters; an element is only laid out
+// again when its string or size changes, and positions are only worked
+// out again when the screen size does. Each frame render() queues the
+// vertices it already has. Glyphs come straight from the font's texture
+// and panels use the white square every font page keeps, so a layer with
+// one font and character size is a single draw. The software renderer has
+// no GPU for the font's textures, so there glyphs and the white square come
+// from a SoftwareFont's page of the same file instead.
+//
+// Asking a font for a glyph it has not made yet writes to, or replaces,
+// its page texture, which a render thread may be drawing with. So every
+// glyph a text can use is made up front, once per character size and with
+// the render thread idle, and laying out only ever finds them.
+class UiLayer
+{
+public:
+    // Where an element sits on the screen, and which point of the element
+    // is put there, e.g. ANCHOR_TOP centres the element along the top edge.
+    enum Anchor
+    {
+        ANCHOR_TOP_LEFT,
+        ANCHOR_TOP,
+        ANCHOR_TOP_RIGHT,
+        ANCHOR_LEFT,
+        ANCHOR_CENTRE,
+        ANCHOR_RIGHT,
+        ANCHOR_BOTTOM_LEFT,
+        ANCHOR_BOTTOM,
+        ANCHOR_BOTTOM_RIGHT
+    };
+
+    using Element = std::size_t;
+
+    UiLayer() = default;
+    UiLayer(const std::string &font_path, unsigned int character_size);
+
+    // Font for every text, through the ResourceCache, and the size panels
+    // take their texture from. Returns false if the font could not be loaded.
+    bool set_font(const std::string &font_path, unsigned int character_size);
+
+    Element add_text(const std::string &text, unsigned int character_size, const sf::Color &color,
+                     Anchor anchor, const sf::Vector2f &offset = {});
+    // A zero width or height stretches the panel across the screen.
+    Element add_panel(const sf::Vector2f &size, const sf::Color &color,
+                      Anchor anchor, const sf::Vector2f &offset = {});
+
+    // Setters only mark work to do when the value actually changes.
+    void set_text(Element element, const std::string &text);
+    void set_size(Element element, const sf::Vector2f &size);
+    void set_color(Element element, const sf::Color &color);
+    void set_visible(Element element, bool visible);
+
+    // Lays out whatever changed and queues the layer in screen space.
+    void render();
+    void clear();
+
+    // Times any element was laid out, to check layout is not per frame.
+    std::size_t get_layouts() const { return m_layouts; }
+
+private:
+    enum ElementKind
+    {
+        ELEMENT_TEXT,
+        ELEMENT_PANEL
+    };
+
+    struct ElementData
+    {
+        ElementKind kind;
+        std::string text;
+        unsigned int character_size;
+        sf::Color color;
+        Anchor anchor;
+        sf::Vector2f offset;
+        sf::Vector2f size;                  // panels: as given, zero stretches
+        bool visible = true;
+        bool dirty = true;                  // needs laying out again
+        std::vector<sf::Vertex> local;      // laid out around the element's own origin
+        sf::FloatRect bounds;               // of local
+        const sf::Texture *texture = nullptr;
+    };
+
+    struct Run
+    {
+        std::size_t first;
+        std::size_t count;
+        const sf::Texture *texture;
+    };
+
+    std::shared_ptr<const sf::Font> m_font;
+    std::shared_ptr<const SoftwareFont> m_glyphs;   // with the software renderer
+    unsigned int m_character_size = 30;
+    std::vector<ElementData> m_elements;
+    std::vector<sf::Vertex> m_vertices;     // every visible element on screen, in order
+    std::vector<Run> m_runs;
+    sf::Vector2f m_screen_size;
+    bool m_dirty = true;                    // m_vertices needs rebuilding
+    std::size_t m_layouts = 0;
+    std::vector<unsigned int> m_warm_sizes; // character sizes whose glyphs m_font has made
+
+    Element add(ElementData element);
+    void layout(ElementData &element);
+    void layout_text(ElementData &element);
+    void layout_panel(ElementData &element);
+    void rebuild();
+    void warm(unsigned int character_size);
+};
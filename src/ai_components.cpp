@@ -62,7 +62,7 @@ void SteeringComponent::update(const float& dt) {
 /// <param name="e">The entity being given the component.</param>
 /// <param name="player">The target entity.</param>
 /// <param name="max_speed">The maximum speed for travel.</param>
-SteeringComponent::SteeringComponent(Entity* e, Entity* target, float max_speed):
+SteeringComponent::SteeringComponent(Entity* e, EntityHandle target, float max_speed):
 	_player(target), _max_speed(max_speed), Component(e){ }
 
 
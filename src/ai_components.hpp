@@ -24,12 +24,13 @@ struct SteeringBehaviours {
 /// </summary>
 class SteeringComponent : public Component {
 	protected:
-		Entity* _player;
+		EntityHandle _player;
 		float _max_speed;
 	public:
+		static constexpr PhaseMask phases = 0;
 		void update(const float&) override;
 		void render() override {}
-		explicit SteeringComponent(Entity* e, Entity* target, float max_speed);
+		explicit SteeringComponent(Entity* e, EntityHandle target, float max_speed);
 		SteeringComponent() = delete;
 };
 
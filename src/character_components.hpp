@@ -12,6 +12,8 @@ protected:
     void kill();
 
 public:
+    static constexpr PhaseMask phases = 0;   // only changes when damaged
+
     float get_max_health();
     float get_current_health();
 
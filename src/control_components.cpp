@@ -2,6 +2,7 @@
 #include "game_parameters.hpp"
 #include "game_system.hpp"
 #include "physics.hpp"
+#include "input.hpp"
 #include "ai_components.hpp"
 #include <array>
 
@@ -49,17 +50,44 @@ bool PlayerControlComponent::is_grounded() const
 /// </summary>
 /// <param name="dt">Delta Time - Linked to Frame Rate.</param>
 void PlayerControlComponent::update(const float& dt)
+{
+    handle_input(dt);
+    PhysicsComponent::update(dt);
+}
+
+/// <summary>
+/// Reads the controls in the input phase; the body is handled in the physics phases.
+/// </summary>
+/// <param name="phase">The phase being run.</param>
+/// <param name="dt">Delta Time - Linked to Frame Rate.</param>
+void PlayerControlComponent::update_phase(FramePhase phase, const float& dt)
+{
+    if (phase == PHASE_INPUT)
+    {
+        handle_input(dt);
+    }
+    else
+    {
+        PhysicsComponent::update_phase(phase, dt);
+    }
+}
+
+/// <summary>
+/// Turns the controls into player movement.
+/// </summary>
+/// <param name="dt">Delta Time - Linked to Frame Rate.</param>
+void PlayerControlComponent::handle_input(const float& dt)
 {
     const sf::Vector2f pos = m_parent->get_position();
     b2Vec2 b2_pos = Physics::sv2_to_bv2(Physics::invert_height(pos, params::window_height));
 
-    if (sf::Keyboard::isKeyPressed(params::getControls().at("Left")))
+    if (Input::is_key_pressed(params::getControls().at("Left")))
     {
         m_direction.x = -1.0f;
         // Set sprite to face left
         m_parent->set_facing_right(false);
     }
-    else if (sf::Keyboard::isKeyPressed(params::getControls().at("Right")))
+    else if (Input::is_key_pressed(params::getControls().at("Right")))
     {
         m_direction.x = 1.0f;
         // Set sprite to face right
@@ -73,7 +101,7 @@ void PlayerControlComponent::update(const float& dt)
 
     set_velocity({ m_ground_speed * m_direction.x, get_velocity().y });
 
-    if (sf::Keyboard::isKeyPressed(params::getControls().at("Up")))
+    if (Input::is_key_pressed(params::getControls().at("Up")))
     {
         m_grounded = is_grounded();
 
@@ -102,8 +130,6 @@ void PlayerControlComponent::update(const float& dt)
     v.x = copysign(std::min(abs(v.x), m_max_velocity.x), v.x);
     v.y = copysign(std::min(abs(v.y), m_max_velocity.y), v.y);
     set_velocity(v);
-
-    PhysicsComponent::update(dt);
 }
 
 /// <summary>
@@ -157,14 +183,58 @@ void EnemyControlComponent::update(const float& dt)
 {
     if (this->m_parent->is_alive())
     {
-        // Need to make the enemy consider whether or not its movement is valid
-        // This should be based on whether or not the next tile is empty.
-        const sf::Vector2f pos = m_parent->get_position();
-        b2Vec2 b2_pos = Physics::sv2_to_bv2(Physics::invert_height(pos, params::window_height));
-
-        auto distance = [](const sf::Vector2f& a, const sf::Vector2f& b) -> float {
-            return std::sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y));
-            };
+        steer(dt);
+        PhysicsComponent::update(dt);
+    }
+}
+
+/// <summary>
+/// Steers before the physics step and reads the body back after it.
+/// </summary>
+/// <param name="phase">The phase being run.</param>
+/// <param name="dt">Delta Time - Linked to Frame Rate.</param>
+void EnemyControlComponent::update_phase(FramePhase phase, const float& dt)
+{
+    if (!this->m_parent->is_alive())
+    {
+        return;
+    }
+
+    if (phase == PHASE_PRE_PHYSICS)
+    {
+        steer(dt);
+    }
+    PhysicsComponent::update_phase(phase, dt);
+}
+
+/// <summary>
+/// Steers the enemy towards or away from its target.
+/// </summary>
+/// <param name="dt">Delta Time - Linked to Frame Rate.</param>
+void EnemyControlComponent::steer(const float& dt)
+{
+    choose_direction();
+    apply_steering();
+}
+
+/// <summary>
+/// Picks the direction to move in from the target's position.
+/// Makes no Box2D calls and only writes this enemy, so it can run in
+/// parallel across enemies.
+/// </summary>
+void EnemyControlComponent::choose_direction()
+{
+    // Need to make the enemy consider whether or not its movement is valid
+    // This should be based on whether or not the next tile is empty.
+    const sf::Vector2f pos = m_parent->get_position();
+    b2Vec2 b2_pos = Physics::sv2_to_bv2(Physics::invert_height(pos, params::window_height));
+
+    auto distance = [](const sf::Vector2f& a, const sf::Vector2f& b) -> float {
+        return std::sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y));
+        };
+    // Keep the last steering output once the target is gone.
+    const Entity* target = m_parent->resolve(this->target);
+    if (target) {
         //If target is further than 200 pixels away then seek.
         if (distance(m_parent->get_position(), target->get_position()) > 150.0f) {
             output = SteeringBehaviours::seek(target->get_position(), m_parent->get_position());
@@ -175,57 +245,63 @@ void EnemyControlComponent::update(const float& dt)
             output = SteeringBehaviours::flee(target->get_position(), m_parent->get_position());
             m_seeking = false;
         }
+    }
 
-        m_direction.x = output.direction.x;
-
-        // Update sprite facing based on movement direction
-        if (m_direction.x < -0.1f) {
-            // Moving left
-            m_parent->set_facing_right(false);
-        }
-        else if (m_direction.x > 0.1f) {
-            // Moving right
-            m_parent->set_facing_right(true);
-        }
-        // If direction is near zero, keep current facing
-
-        set_velocity({ m_ground_speed * m_direction.x, get_velocity().y });
+    m_direction.x = output.direction.x;
 
-        if (m_seeking && (output.direction.y < -0.1) || !m_seeking) {
-            m_grounded = is_grounded();
-            if (m_grounded)
-            {
-                m_grounded = false;
-                impulse({ 0.0f, -params::enemy_jump });
-            }
-        }
+    // Update sprite facing based on movement direction
+    if (m_direction.x < -0.1f) {
+        // Moving left
+        m_parent->set_facing_right(false);
+    }
+    else if (m_direction.x > 0.1f) {
+        // Moving right
+        m_parent->set_facing_right(true);
+    }
+    // If direction is near zero, keep current facing
+}
 
-        dampen({ 1.0f, 1.0f });
+/// <summary>
+/// Moves the enemy's body in the chosen direction, jumping when it should.
+/// Box2D is not thread safe, so this must run on one thread at a time.
+/// </summary>
+void EnemyControlComponent::apply_steering()
+{
+    set_velocity({ m_ground_speed * m_direction.x, get_velocity().y });
 
-        // Disable friction while in the air
-        if (!m_grounded)
-        {
-            m_grounded = is_grounded();
-            //set_friction(0.0f);
-        }
-        else
+    if (m_seeking && (output.direction.y < -0.1) || !m_seeking) {
+        m_grounded = is_grounded();
+        if (m_grounded)
         {
-            set_friction(m_friction);
+            m_grounded = false;
+            impulse({ 0.0f, -params::enemy_jump });
         }
+    }
 
-        // Clamp velocity
-        sf::Vector2f v = get_velocity();
-        v.x = copysign(std::min(abs(v.x), m_max_velocity.x), v.x);
-        v.y = copysign(std::min(abs(v.y), m_max_velocity.y), v.y);
-        set_velocity(v);
-        PhysicsComponent::update(dt);
+    dampen({ 1.0f, 1.0f });
+
+    // Disable friction while in the air
+    if (!m_grounded)
+    {
+        m_grounded = is_grounded();
+        //set_friction(0.0f);
     }
+    else
+    {
+        set_friction(m_friction);
+    }
+
+    // Clamp velocity
+    sf::Vector2f v = get_velocity();
+    v.x = copysign(std::min(abs(v.x), m_max_velocity.x), v.x);
+    v.y = copysign(std::min(abs(v.y), m_max_velocity.y), v.y);
+    set_velocity(v);
 }
 
 /// <summary>
 /// Sets the enemy's target.
 /// </summary>
 /// <param name="targetEntity">The target for the enemy.</param>
-void EnemyControlComponent::set_target(std::shared_ptr<Entity> targetEntity) {
+void EnemyControlComponent::set_target(EntityHandle targetEntity) {
     target = targetEntity;
 }
\ No newline at end of file
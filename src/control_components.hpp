@@ -5,7 +5,11 @@
 class PlayerControlComponent : public PhysicsComponent
 {
     public:
+        using base_component = PhysicsComponent;
+        static constexpr PhaseMask phases = phase_bits(PHASE_INPUT, PHASE_PRE_PHYSICS, PHASE_POST_PHYSICS);
+
         void update(const float& dt) override;
+        void update_phase(FramePhase phase, const float& dt) override;
         explicit PlayerControlComponent(Entity* p, const sf::Vector2f& size);
         PlayerControlComponent() = delete;
 
@@ -17,14 +21,23 @@ class PlayerControlComponent : public PhysicsComponent
         float m_ground_speed;
 
         bool is_grounded() const;
+        void handle_input(const float& dt);
 };
 class EnemyControlComponent : public PhysicsComponent
 {
     public:
+        using base_component = PhysicsComponent;
+
         void update(const float& dt) override;
+        void update_phase(FramePhase phase, const float& dt) override;
         explicit EnemyControlComponent(Entity* e, const sf::Vector2f& size);
         EnemyControlComponent() = delete;
-        void set_target(std::shared_ptr<Entity> targetEntity);
+        void set_target(EntityHandle targetEntity);
+        void steer(const float& dt);
+        // steer() in two halves: the first touches no Box2D state, so it
+        // can run in parallel; the second makes every Box2D call.
+        void choose_direction();
+        void apply_steering();
     protected:
         b2Vec2 m_size;
         sf::Vector2f m_max_velocity;
@@ -32,7 +45,7 @@ class EnemyControlComponent : public PhysicsComponent
         bool m_grounded;
         float m_ground_speed;
         SteeringOutput output;
-        std::shared_ptr<Entity> target;
+        EntityHandle target;
         bool m_seeking;
 
         bool is_grounded() const;
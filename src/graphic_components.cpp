@@ -1,43 +1,58 @@
 #include "graphic_components.hpp"
 #include "renderer.hpp"
+#include "game_system.hpp"
+#include "texture_atlas.hpp"
 #include <iostream>
 #include <cmath>
 
 /// <summary>
 /// Updates the shape component.
+/// Nothing to do per update; see sync_transform.
 /// </summary>
 /// <param name="dt">Delta Time - Linked to Frame Rate.</param>
-void ShapeComponent::update(const float &dt) {
-  _shape->setPosition(m_parent->get_position());
-  if (this->m_parent->is_visible())
-  {
-	  // Get current scale to preserve size
-	  sf::Vector2f currentScale = _shape->getScale();
-	  float scaleX = std::abs(currentScale.x);
-	  float scaleY = currentScale.y;
-
-	  // Mirror shape based on facing direction
-	  if (!m_parent->is_facing_right())
-	  {
-		  _shape->setScale(-scaleX, scaleY);
-	  }
-	  else
-	  {
-		  _shape->setScale(scaleX, scaleY);
-	  }
-  }
-}
+void ShapeComponent::update(const float &dt) {}
 
 /// <summary>
 /// Renders the shape component.
+/// Drawn between the entity's last two positions, see Renderer::get_interpolation.
 /// </summary>
 void ShapeComponent::render() { 
 	if (this->m_parent->is_visible())
 	{
+		sync_transform();
 		Renderer::queue(_shape.get());
 	}
 }
 
+/// <summary>
+/// Copies the entity's position and facing onto the shape. Skipped when
+/// the entity is at rest and its transform has not changed since the last
+/// sync, so a still shape costs nothing.
+/// </summary>
+void ShapeComponent::sync_transform()
+{
+	const std::uint32_t version = m_parent->get_transform_version();
+	const bool moving = m_parent->is_moving();
+	if (!m_transform_dirty && version == m_synced_version && !moving && m_synced_at_rest)
+	{
+		return;
+	}
+
+	if (m_transform_dirty || version != m_synced_version)
+	{
+		// Mirror shape based on facing direction, preserving its size
+		const sf::Vector2f currentScale = _shape->getScale();
+		const float scaleX = std::abs(currentScale.x);
+		_shape->setScale(m_parent->is_facing_right() ? scaleX : -scaleX, currentScale.y);
+	}
+
+	_shape->setPosition(moving ? m_parent->get_interpolated_position(Renderer::get_interpolation()) : m_parent->get_position());
+
+	m_synced_version = version;
+	m_transform_dirty = false;
+	m_synced_at_rest = !moving;
+}
+
 /// <summary>
 /// Gets the shape of the ShapeComponent.
 /// </summary>
@@ -67,41 +82,50 @@ sf::Sprite& SpriteComponent::get_sprite() const
 
 /// <summary>
 /// Updates the sprite.
+/// Nothing to do per update; see sync_transform.
 /// </summary>
 /// <param name="dt">Delta Time - Linked to Frame Rate.</param>
-void SpriteComponent::update(const float &dt)
+void SpriteComponent::update(const float &dt) {}
+
+/// <summary>
+/// Renders the SpriteComponent.
+/// Drawn between the entity's last two positions, see Renderer::get_interpolation.
+/// </summary>
+void SpriteComponent::render()
 {
-	m_sprite->setPosition(m_parent->get_position());
-	
 	if (this->m_parent->is_visible())
 	{
-		// Get current scale to preserve size
-		sf::Vector2f currentScale = m_sprite->getScale();
-		float scaleX = std::abs(currentScale.x);
-		float scaleY = currentScale.y;
-
-		// Mirror sprite based on facing direction
-		// If facing left, flip horizontally using negative scale
-		if (!m_parent->is_facing_right())
-		{
-			m_sprite->setScale(-scaleX, scaleY);
-		}
-		else
-		{
-			m_sprite->setScale(scaleX, scaleY);
-		}
+		sync_transform();
+		Renderer::queue(m_sprite.get());
 	}
 }
 
 /// <summary>
-/// Renders the SpriteComponent.
+/// Copies the entity's position and facing onto the sprite, the same way
+/// as ShapeComponent::sync_transform.
 /// </summary>
-void SpriteComponent::render()
+void SpriteComponent::sync_transform()
 {
-	if (this->m_parent->is_visible())
+	const std::uint32_t version = m_parent->get_transform_version();
+	const bool moving = m_parent->is_moving();
+	if (!m_transform_dirty && version == m_synced_version && !moving && m_synced_at_rest)
 	{
-		Renderer::queue(m_sprite.get());
+		return;
+	}
+
+	if (m_transform_dirty || version != m_synced_version)
+	{
+		// If facing left, flip horizontally using negative scale
+		const sf::Vector2f currentScale = m_sprite->getScale();
+		const float scaleX = std::abs(currentScale.x);
+		m_sprite->setScale(m_parent->is_facing_right() ? scaleX : -scaleX, currentScale.y);
 	}
+
+	m_sprite->setPosition(moving ? m_parent->get_interpolated_position(Renderer::get_interpolation()) : m_parent->get_position());
+
+	m_synced_version = version;
+	m_transform_dirty = false;
+	m_synced_at_rest = !moving;
 }
 
 /// <summary>
@@ -111,14 +135,21 @@ void SpriteComponent::render()
 /// <returns>Whether or not loading was successful.</returns>
 bool SpriteComponent::load_texture(const std::string& filepath)
 {
-	m_texture = std::make_shared<sf::Texture>();
-	
-	if (!m_texture->loadFromFile(filepath))
+	// Textures need a graphics context, which a headless run does not have,
+	// unless it draws in software, where the atlas is an image.
+	if (GameSystem::is_headless() && !Renderer::is_software())
 	{
 		return false;
 	}
-	
-	m_sprite->setTexture(*m_texture);
+
+	// Sprites share the atlas texture so they can be drawn in one batch.
+	if (!TextureAtlas::shared().load(filepath, m_region))
+	{
+		return false;
+	}
+
+	m_sprite->setTexture(TextureAtlas::shared().get_texture());
+	m_sprite->setTextureRect(m_region);
 	return true;
 }
 
@@ -128,13 +159,13 @@ bool SpriteComponent::load_texture(const std::string& filepath)
 /// <param name="size">Vector2f for size.</param>
 void SpriteComponent::set_size(const sf::Vector2f& size)
 {
-	if (m_texture)
+	if (m_sprite->getTexture())
 	{
-		sf::Vector2u textureSize = m_texture->getSize();
 		m_sprite->setScale(
-			size.x / textureSize.x,
-			size.y / textureSize.y
+			size.x / m_region.width,
+			size.y / m_region.height
 		);
+		m_transform_dirty = true;
 	}
 }
 
@@ -143,12 +174,11 @@ void SpriteComponent::set_size(const sf::Vector2f& size)
 /// </summary>
 void SpriteComponent::set_origin_center()
 {
-	if (m_texture)
+	if (m_sprite->getTexture())
 	{
-		sf::Vector2u textureSize = m_texture->getSize();
 		m_sprite->setOrigin(
-			textureSize.x / 2.0f,
-			textureSize.y / 2.0f
+			m_region.width / 2.0f,
+			m_region.height / 2.0f
 		);
 	}
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 
 class ShapeComponent : public Component {
 public:
+    static constexpr PhaseMask phases = 0;  // synced in render(), only when the transform changes
+
     ShapeComponent() = delete;
     explicit ShapeComponent(Entity *const p);
 
@@ -15,14 +17,25 @@ public:
     template <typename T, typename... Targs>
     void set_shape(Targs... params) {
         _shape = std::make_shared<T>(params...);
+        m_transform_dirty = true;
     }
 protected:
     std::shared_ptr<sf::Shape> _shape;
+
+    // The parent's transform version the shape was last synced to. Dirty
+    // forces a resync, e.g. after the shape is replaced.
+    std::uint32_t m_synced_version = 0;
+    bool m_transform_dirty = true;
+    bool m_synced_at_rest = false;  // synced to the parent's final, not interpolated, position
+
+    void sync_transform();
 };
 
 class SpriteComponent : public Component
 {
 public:
+    static constexpr PhaseMask phases = 0;  // synced in render(), only when the transform changes
+
     SpriteComponent() = delete;
     explicit SpriteComponent(Entity *p);
 
@@ -42,5 +55,12 @@ public:
 
 protected:
     std::shared_ptr<sf::Sprite> m_sprite;
-    std::shared_ptr<sf::Texture> m_texture;
+    sf::IntRect m_region;   // where the texture is in the shared atlas
+
+    // As in ShapeComponent.
+    std::uint32_t m_synced_version = 0;
+    bool m_transform_dirty = true;
+    bool m_synced_at_rest = false;
+
+    void sync_transform();
 };
\ No newline at end of file
@@ -1,21 +1,338 @@
 #include <SFML/Graphics.hpp>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
 #include "game_parameters.hpp"
 #include "physics.hpp"
 #include "scenes.hpp"
+#include "input.hpp"
+#include "random.hpp"
+#include "resource_cache.hpp"
+#include "profiler.hpp"
+#include "renderer.hpp"
+#include "software_rasterizer.hpp"
 
-int main() 
+// Command line options. --seed, --input, --record and --trace apply to any
+// run; --render-thread and --profile only to the windowed game; the rest
+// only to --headless runs, which skip the menu and go straight into a level.
+// A headless run has no window to draw on a separate thread, so asking for
+// --render-thread with it is an error.
+struct Options
 {
+	bool headless = false;
+	int level = 0;                              // 0 picks randomly
+	std::string world;                          // world file to stream instead of the levels
+	std::uint32_t seed = std::random_device{}();
+	std::uint64_t frames = 60 * 120;            // one minute at the fixed step
+	int enemies = 9;
+	std::string input;                          // script to play back
+	std::string record;                         // file to record input to
+	bool render_thread = false;                 // draw on a separate thread
+	bool software = false;                      // draw every frame on the CPU
+	std::string capture;                        // directory to save software frames to
+	std::string golden;                         // directory of frames to compare with
+	std::uint64_t capture_every = 60;           // frames between saves or comparisons
+	std::string trace;                          // file to write a Chrome trace to
+	bool profile = false;                       // show the profiler overlay from the start
+};
+
+// How far a channel may be from the golden frame's, for rounding differences between compilers.
+static constexpr unsigned int golden_tolerance = 2;
+
+static void print_usage(const char *program)
+{
+	std::cerr << "Usage: " << program << " [options]\n"
+	          << "  --headless        run with no window and print statistics\n"
+	          << "  --level N         level to start on (headless)\n"
+	          << "  --world FILE      stream a world file instead of the levels (headless)\n"
+	          << "  --seed S          random seed\n"
+	          << "  --frames N        most fixed updates to run (headless)\n"
+	          << "  --enemies N       enemies in the first level (headless)\n"
+	          << "  --input FILE      play input back from a script\n"
+	          << "  --record FILE     record input to a script\n"
+	          << "  --render-thread   draw on a separate thread (windowed only)\n"
+	          << "  --software        draw every frame on the CPU (headless)\n"
+	          << "  --capture DIR     save software frames as PNGs in DIR\n"
+	          << "  --golden DIR      compare software frames with the PNGs in DIR\n"
+	          << "  --capture-every N frames between saves or comparisons\n"
+	          << "  --trace FILE      write a Chrome trace of the run to FILE\n"
+	          << "  --profile         show the profiler overlay, F3 toggles it (windowed only)\n";
+}
+
+// Reads a whole base 10 value in [min, max].
+static bool parse_number(const char *value, long long min, long long max, long long &out)
+{
+	char *end = nullptr;
+	errno = 0;
+	const long long number = std::strtoll(value, &end, 10);
+	if (end == value || *end != '\0' || errno == ERANGE || number < min || number > max)
+	{
+		return false;
+	}
+	out = number;
+	return true;
+}
+
+static bool parse_options(int argc, char *argv[], Options &options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		if (arg == "--headless")
+		{
+			options.headless = true;
+			continue;
+		}
+		if (arg == "--render-thread")
+		{
+			options.render_thread = true;
+			continue;
+		}
+		if (arg == "--software")
+		{
+			options.software = true;
+			continue;
+		}
+		if (arg == "--profile")
+		{
+			options.profile = true;
+			continue;
+		}
+
+		if (i + 1 >= argc)
+		{
+			return false;
+		}
+		const char *value = argv[++i];
+		long long number = 0;
+
+		if (arg == "--level")
+		{
+			if (!parse_number(value, 0, static_cast<long long>(params::getLevels().size()), number)) return false;
+			options.level = static_cast<int>(number);
+		}
+		else if (arg == "--seed")
+		{
+			if (!parse_number(value, 0, UINT32_MAX, number)) return false;
+			options.seed = static_cast<std::uint32_t>(number);
+		}
+		else if (arg == "--frames")
+		{
+			if (!parse_number(value, 1, LLONG_MAX, number)) return false;
+			options.frames = static_cast<std::uint64_t>(number);
+		}
+		else if (arg == "--enemies")
+		{
+			if (!parse_number(value, 0, EntityHandle::max_index, number)) return false;
+			options.enemies = static_cast<int>(number);
+		}
+		else if (arg == "--capture-every")
+		{
+			if (!parse_number(value, 1, LLONG_MAX, number)) return false;
+			options.capture_every = static_cast<std::uint64_t>(number);
+		}
+		else if (arg == "--world") options.world = value;
+		else if (arg == "--input") options.input = value;
+		else if (arg == "--record") options.record = value;
+		else if (arg == "--capture") options.capture = value;
+		else if (arg == "--golden") options.golden = value;
+		else if (arg == "--trace") options.trace = value;
+		else return false;
+	}
+
+	// Capturing and comparing need frames, and frames need the software renderer.
+	if (!options.capture.empty() || !options.golden.empty())
+	{
+		options.software = true;
+	}
+	if (options.software)
+	{
+		options.headless = true;
+	}
+	if (options.headless && options.render_thread)
+	{
+		std::cerr << "--render-thread needs a window, so it can't be used with a headless run" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// File name of a captured frame, e.g. frame_000120.png.
+static std::string frame_file_name(std::uint64_t frame)
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "frame_%06llu.png", static_cast<unsigned long long>(frame));
+	return name;
+}
+
+// Writes the trace if one was asked for.
+static void write_trace(const Options &options)
+{
+	if (options.trace.empty())
+	{
+		return;
+	}
+
+	if (Profiler::write_trace(options.trace))
+	{
+		std::cout << "Trace written to " << options.trace << std::endl;
+	}
+	else
+	{
+		std::cerr << "Could not write the trace to " << options.trace << std::endl;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	Options options;
+	if (!parse_options(argc, argv, options))
+	{
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	Random::seed(options.seed);
+	std::cout << "Seed: " << options.seed << std::endl;
+
+	try
+	{
+		if (!options.input.empty())
+		{
+			Input::set_source(std::make_unique<ScriptedInput>(options.input));
+		}
+		else if (options.headless)
+		{
+			// Nothing is pressed without a script.
+			Input::set_source(std::make_unique<ScriptedInput>());
+		}
+
+		if (!options.record.empty())
+		{
+			std::unique_ptr<InputSource> source = std::make_unique<DeviceInput>();
+			if (!options.input.empty())
+			{
+				source = std::make_unique<ScriptedInput>(options.input);
+			}
+			Input::set_source(std::make_unique<RecordingInput>(std::move(source), options.record));
+		}
+	}
+	catch (const std::string &error)
+	{
+		std::cerr << error << std::endl;
+		return 1;
+	}
+
+	if (!options.trace.empty())
+	{
+		Profiler::start_trace();
+	}
+
 	Physics::initialise();
 
+	// Decodes the shared assets in the background while the scenes are set up.
+	ResourceCache::preload_font(EngineUtils::GetRelativePath("resources/fonts/vcr_mono.ttf"));
+	if (!options.headless)
+	{
+		ResourceCache::preload_image(EngineUtils::GetRelativePath("resources/sprites/player_sprite.png"));
+		ResourceCache::preload_image(EngineUtils::GetRelativePath("resources/sprites/enemy_sprite.png"));
+	}
+
+	if (options.headless)
+	{
+		std::shared_ptr<BasicLevelScene> level = std::make_shared<BasicLevelScene>();
+		level->set_enemy_count(options.enemies);
+		level->set_start_level(options.level);
+		level->set_world(options.world);
+		Scenes::basicLevelScene = level;
+
+		std::uint64_t mismatches = 0;
+		std::function<void(std::uint64_t)> on_frame;
+		if (options.software)
+		{
+			Renderer::init_software(params::window_width, params::window_height);
+			on_frame = [&options, &mismatches](std::uint64_t frame)
+			{
+				if (frame % options.capture_every != 0)
+				{
+					return;
+				}
+
+				const SoftwareRasterizer &target = *Renderer::get_software_target();
+				const std::string name = frame_file_name(frame);
+				if (!options.capture.empty())
+				{
+					sf::Image image;
+					target.copy_to_image(image);
+					if (!image.saveToFile(options.capture + "/" + name))
+					{
+						std::cerr << "Could not save " << name << std::endl;
+					}
+				}
+				if (!options.golden.empty())
+				{
+					sf::Image golden;
+					const std::size_t differing = golden.loadFromFile(options.golden + "/" + name)
+						? target.compare(golden, golden_tolerance)
+						: target.get_pixels().size();
+					if (differing > 0)
+					{
+						std::cerr << name << ": " << differing << " pixels differ from the golden frame" << std::endl;
+						++mismatches;
+					}
+				}
+			};
+		}
+
+		try
+		{
+			GameSystem::run_headless(Scenes::basicLevelScene, options.frames, Physics::time_step, true, on_frame);
+		}
+		catch (const std::string &error)
+		{
+			// e.g. a level, world or font file that can't be loaded
+			std::cerr << error << std::endl;
+			Renderer::shutdown();
+			Physics::shutdown();
+			return 1;
+		}
+		catch (const std::exception &error)
+		{
+			// e.g. a full texture atlas or too many component types
+			std::cerr << error.what() << std::endl;
+			Renderer::shutdown();
+			Physics::shutdown();
+			return 1;
+		}
+		Renderer::shutdown();
+		write_trace(options);
+
+		Physics::shutdown();
+		if (!options.golden.empty())
+		{
+			std::cout << "Golden frames differing: " << mismatches << std::endl;
+			return mismatches > 0 ? 1 : 0;
+		}
+		return 0;
+	}
+
 	Scenes::menuScene = std::make_shared<MenuScene>();
 	Scenes::menuScene->load();
 
 	Scenes::deathScene = std::make_shared<DeathScene>();
 	Scenes::deathScene->load();
 
+	GameSystem::enable_profiler_overlay(EngineUtils::GetRelativePath("resources/fonts/vcr_mono.ttf"), options.profile);
 	GameSystem::setActiveScene(Scenes::menuScene);
-	GameSystem::start(params::window_width, params::window_height, "Cube Zone", Physics::time_step, true);
+	GameSystem::start(params::window_width, params::window_height, "Cube Zone", Physics::time_step, true, options.render_thread);
+
+	write_trace(options);
 
 	Physics::shutdown();
 	return 0;
-}
\ No newline at end of file
+}
@@ -4,8 +4,8 @@
 #include <array>
 #include <iostream>
 
-// This component handles the creation and management of our platform using Box2D chains.
-PlatformComponent::PlatformComponent(Entity *p, const std::vector<sf::Vector2i> &tile_group,
+// This component handles the creation and management of our platforms using Box2D chains.
+PlatformComponent::PlatformComponent(Entity *p, const std::vector<std::vector<sf::Vector2i>> &outlines,
     float friction, float restitution) :
     Component(p), m_friction(friction), m_restitution(restitution)
 {
@@ -14,7 +14,27 @@ PlatformComponent::PlatformComponent(Entity *p, const std::vector<sf::Vector2i>
 
     // Create the body
     m_body_id = b2CreateBody(Physics::get_world_id(), &body_def);
-    m_create_chain_shape(tile_group);
+    m_chain_ids.reserve(outlines.size());
+    for (const std::vector<sf::Vector2i> &outline : outlines)
+    {
+        m_create_chain_shape(outline);
+    }
+}
+
+// As above, for a streamed chunk's chains, some of which stop at its seams.
+PlatformComponent::PlatformComponent(Entity *p, const std::vector<LevelSystem::Chain> &chains,
+    float friction, float restitution) :
+    Component(p), m_friction(friction), m_restitution(restitution)
+{
+    b2BodyDef body_def = b2DefaultBodyDef();
+    body_def.type = b2_staticBody;
+
+    m_body_id = b2CreateBody(Physics::get_world_id(), &body_def);
+    m_chain_ids.reserve(chains.size());
+    for (const LevelSystem::Chain &chain : chains)
+    {
+        m_create_chain_shape(chain.points, chain.loop);
+    }
 }
 
 // Left blank
@@ -26,91 +46,29 @@ void PlatformComponent::render() {}
 // Safely destroy our platform bodies.
 PlatformComponent::~PlatformComponent()
 {
-    b2DestroyChain(m_chain_id);
-    m_chain_id = b2_nullChainId;
+    for (b2ChainId &chain_id : m_chain_ids)
+    {
+        b2DestroyChain(chain_id);
+    }
+    m_chain_ids.clear();
     b2DestroyBody(m_body_id);
     m_body_id = b2_nullBodyId;
 }
 
-// Create a chain shape from a 2D vector of coordinates.
-void PlatformComponent::m_create_chain_shape(const std::vector<sf::Vector2i> &tile_group)
+// Create a chain from an outline of tile corners. Outlines run
+// anticlockwise around solid tiles, so each segment's right side, the one
+// Box2D collides with, faces out of the wall. An open chain's first and
+// last corners are ghosts, which Box2D only uses to smooth its ends.
+void PlatformComponent::m_create_chain_shape(const std::vector<sf::Vector2i> &outline, bool loop)
 {
     std::vector<b2Vec2> points;
-
-    for(int i = 0; i < tile_group.size(); ++i)
+    points.reserve(outline.size());
+    for (const sf::Vector2i &corner : outline)
     {
-        const sf::Vector2i &tile = tile_group[i];
-
-        std::vector<LevelSystem::Tile> neighbours =
-        {
-            LevelSystem::in_group({tile.x-1,tile.y-1},tile_group) ? LevelSystem::get_tile({tile.x-1,tile.y-1}) : LevelSystem::EMPTY,
-            LevelSystem::in_group({tile.x,tile.y-1},tile_group) ? LevelSystem::get_tile({tile.x,tile.y-1}) : LevelSystem::EMPTY,
-            LevelSystem::in_group({tile.x+1,tile.y-1},tile_group) ? LevelSystem::get_tile({tile.x+1,tile.y-1}) : LevelSystem::EMPTY,
-            LevelSystem::in_group({tile.x+1,tile.y},tile_group) ? LevelSystem::get_tile({tile.x+1,tile.y}) : LevelSystem::EMPTY,
-            LevelSystem::in_group({tile.x+1,tile.y+1},tile_group) ? LevelSystem::get_tile({tile.x+1,tile.y+1}) : LevelSystem::EMPTY,
-            LevelSystem::in_group({tile.x,tile.y+1},tile_group) ? LevelSystem::get_tile({tile.x,tile.y+1}) : LevelSystem::EMPTY,
-            LevelSystem::in_group({tile.x-1,tile.y+1},tile_group) ? LevelSystem::get_tile({tile.x-1,tile.y+1}) : LevelSystem::EMPTY,
-            LevelSystem::in_group({tile.x-1,tile.y},tile_group) ? LevelSystem::get_tile({tile.x-1,tile.y}) : LevelSystem::EMPTY
-        };
-
-        sf::Vector2f pos = LevelSystem::get_tile_pos(tile);
-
-        std::vector<sf::Vector2f> pts;
-
-        if(neighbours[0] == LevelSystem::EMPTY || neighbours[1] == LevelSystem::EMPTY || neighbours[7] == LevelSystem::EMPTY)
-            pts.push_back(pos);
-        if(neighbours[1] == LevelSystem::EMPTY || neighbours[2] == LevelSystem::EMPTY || neighbours[3] == LevelSystem::EMPTY)
-            pts.push_back({pos.x+params::tile_size,pos.y});
-        if(neighbours[3] == LevelSystem::EMPTY || neighbours[4] == LevelSystem::EMPTY || neighbours[5] == LevelSystem::EMPTY)
-            pts.push_back({pos.x+params::tile_size,pos.y+params::tile_size});
-        if(neighbours[5] == LevelSystem::EMPTY || neighbours[6] == LevelSystem::EMPTY || neighbours[7] == LevelSystem::EMPTY)
-            pts.push_back({pos.x,pos.y+params::tile_size});
-        
-        for(const sf::Vector2f &pt : pts)
-        {
-            b2Vec2 point = Physics::sv2_to_bv2(Physics::invert_height(pt, params::window_height));
-            bool already_in = false;
-            for(const b2Vec2 &p : points)
-            {
-                if(p.x == point.x && p.y == point.y)
-                {
-                    already_in = true;
-                    break;
-                }
-            }
-            if (!already_in)
-            {
-                points.push_back(point);
-            }
-        }
+        const sf::Vector2f pos = LevelSystem::get_tile_pos(corner);
+        points.push_back(Physics::sv2_to_bv2(Physics::invert_height(pos, params::window_height)));
     }
 
-    b2Vec2 centroid = {0, 0};
-    for(const b2Vec2 pt : points)
-    {
-        centroid.x += pt.x;
-        centroid.y += pt.y;
-    }
-
-    centroid.x /= static_cast<float>(points.size());
-    centroid.y /= static_cast<float>(points.size());
-
-    // order the list of points in counter clockwise
-    std::sort(points.begin(), points.end(), [&](b2Vec2 a, b2Vec2 b)
-    {
-        a = {a.x - centroid.x, a.y - centroid.y};
-        b = {b.x - centroid.x, b.y - centroid.y};
-
-        float angle1 = std::atan2(a.x, a.y);
-        float angle2 = std::atan2(b.x, b.y);
-
-        if(angle1 == angle2)
-            return std::sqrt(a.x * a.x + a.y * a.y) > std::sqrt(b.x * b.x + b.y * b.y);
-        else
-            return angle1 > angle2;
-    });
-    points.push_back(points.front());
-
     // Create the material of our surface
     b2SurfaceMaterial material = b2DefaultSurfaceMaterial();
     material.friction = m_friction;
@@ -118,24 +76,44 @@ void PlatformComponent::m_create_chain_shape(const std::vector<sf::Vector2i> &ti
 
     // Create the chain definition
     b2ChainDef chain_def = b2DefaultChainDef();
-    chain_def.count = points.size();
+    chain_def.count = static_cast<int>(points.size());
     chain_def.points = points.data();
-    chain_def.isLoop = true;
+    chain_def.isLoop = loop;
     chain_def.materials = &material;
     chain_def.materialCount = 1;
 
-    m_chain_id = b2CreateChain(m_body_id, &chain_def);
-
-    std::vector<b2ShapeId> shape_ids(points.size());
-    int nbr_seg = b2Chain_GetSegments(m_chain_id, shape_ids.data(), points.size());
+    m_chain_ids.push_back(b2CreateChain(m_body_id, &chain_def));
 }
 
 // Update the physics component
 void PhysicsComponent::update(const float &dt)
 {
-    // Apply gravity
+    apply_forces();
+    sync_transform();
+}
+
+// Apply forces before the physics step and read the body back after it
+void PhysicsComponent::update_phase(FramePhase phase, const float &dt)
+{
+    if (phase == PHASE_PRE_PHYSICS)
+    {
+        apply_forces();
+    }
+    else if (phase == PHASE_POST_PHYSICS)
+    {
+        sync_transform();
+    }
+}
+
+// Apply gravity to this body
+void PhysicsComponent::apply_forces()
+{
     b2Body_ApplyForce(m_body_id, {get_velocity().x, m_mass * params::g}, b2Body_GetPosition(m_body_id), false);
+}
 
+// Copy this body's position and rotation onto the entity
+void PhysicsComponent::sync_transform()
+{
     m_parent->set_position(Physics::invert_height(Physics::bv2_to_sv2(b2Body_GetPosition(m_body_id)), params::window_height));
     m_parent->set_rotation((180 / 3.1415f) * b2Rot_GetAngle(b2Body_GetRotation(m_body_id)));
 }
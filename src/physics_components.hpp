@@ -2,11 +2,18 @@
 
 #include "ecm.hpp"
 #include "physics.hpp"
+#include "level_system.hpp"
 
 class PlatformComponent : public Component
 {
 public:
-    PlatformComponent(Entity *p, const std::vector<sf::Vector2i> &tile_group,
+    static constexpr PhaseMask phases = 0;   // static bodies have nothing to update
+
+    // One static body with a loop chain per outline, as from LevelSystem::get_outlines.
+    PlatformComponent(Entity *p, const std::vector<std::vector<sf::Vector2i>> &outlines,
+        float friction = 40.0f, float restitution = 0.2f);
+    // The same, with loops and open chains, as from LevelSystem::trace_chains.
+    PlatformComponent(Entity *p, const std::vector<LevelSystem::Chain> &chains,
         float friction = 40.0f, float restitution = 0.2f);
     void update(const float &dt) override;
     void render() override;
@@ -15,15 +22,18 @@ public:
 
 protected:
     b2BodyId m_body_id;
-    b2ChainId m_chain_id;
+    std::vector<b2ChainId> m_chain_ids;
     float m_friction;
     float m_restitution;
-    void m_create_chain_shape(const std::vector<sf::Vector2i> &tile_group);
+    void m_create_chain_shape(const std::vector<sf::Vector2i> &outline, bool loop = true);
 };
 
 class PhysicsComponent : public Component
 {
 public:
+    // Forces go in before the step, transforms are read back after it.
+    static constexpr PhaseMask phases = phase_bits(PHASE_PRE_PHYSICS, PHASE_POST_PHYSICS);
+
     PhysicsComponent(Entity *p, bool dyn);
     const b2ShapeId &get_shape_id() const;
     int get_contacts(std::array<b2ContactData, 10>& contacts) const;
@@ -32,7 +42,10 @@ public:
     void set_friction(float r);
     void set_mass(float m);
     void update(const float &dt) override;
+    void update_phase(FramePhase phase, const float &dt) override;
     void render() override;
+    void apply_forces();
+    void sync_transform();
     void impulse(const sf::Vector2f &i);
     void dampen(const sf::Vector2f &s);
     void set_velocity(const sf::Vector2f &v);
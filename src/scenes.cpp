@@ -1,14 +1,22 @@
+#include <algorithm>
 #include <iostream>
-#include <random>
 #include "scenes.hpp"
 #include <renderer.hpp>
 #include <game_parameters.hpp>
 #include "graphic_components.hpp"
 #include "ai_components.hpp"
 #include <level_system.hpp>
+#include <level_streamer.hpp>
 #include "control_components.hpp"
 #include "shooting_component.hpp"
 #include "character_components.hpp"
+#include "systems.hpp"
+#include <thread_pool.hpp>
+#include <input.hpp>
+#include <random.hpp>
+#include <resource_cache.hpp>
+#include <profiler.hpp>
+#include <string>
 
 std::shared_ptr<Scene> Scenes::menuScene;
 std::shared_ptr<Scene> Scenes::tutorialScene;
@@ -32,11 +40,12 @@ void MenuScene::update(const float& dt) {
     // Static variable to track if key was pressed last frame (prevents holding key)
     static bool key_was_pressed = false;
 
-    bool key_is_pressed = sf::Keyboard::isKeyPressed(sf::Keyboard::Num0);
+    bool key_is_pressed = Input::is_key_pressed(sf::Keyboard::Num0);
 
     // Only trigger on key press (not hold)
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Num0) && !key_was_pressed)
+    if (Input::is_key_pressed(sf::Keyboard::Num0) && !key_was_pressed)
     {
+        Renderer::sync();
         unload();
         // Create a fresh scene (important when returning from death)
         Scenes::basicLevelScene = std::make_shared<BasicLevelScene>();
@@ -45,7 +54,8 @@ void MenuScene::update(const float& dt) {
         GameSystem::setActiveScene(Scenes::basicLevelScene);
         camera_reset_this_session = false; // Reset flag so camera resets next time we come back to menu
     }
-    else if(sf::Keyboard::isKeyPressed(sf::Keyboard::Num1) && !key_was_pressed){
+    else if(Input::is_key_pressed(sf::Keyboard::Num1) && !key_was_pressed){
+        Renderer::sync();
         unload();
         // Create a fresh scene (important when returning from death)
         Scenes::tutorialScene = std::make_shared<TutorialScene>();
@@ -65,7 +75,7 @@ void MenuScene::update(const float& dt) {
 /// Includes text.
 /// </summary>
 void MenuScene::render() {
-    Renderer::queue(&_text);
+    _ui.render();
     Scene::render();
 }
 
@@ -73,15 +83,9 @@ void MenuScene::render() {
 /// Loads the font and text into the menu scene.
 /// </summary>
 void MenuScene::load() {
-    _font.loadFromFile(EngineUtils::GetRelativePath("resources/fonts/vcr_mono.ttf"));
-    _text.setFont(_font);
-    _text.setCharacterSize(60);
-    _text.setString("Cube Zone\n\n\nPress 0 for Basic Level\nPress 1 for the Tutorial");
-
-    // Center the menu text
-    sf::FloatRect textBounds = _text.getLocalBounds();
-    _text.setOrigin(textBounds.width / 2.0f, textBounds.height / 2.0f);
-    _text.setPosition(params::window_width / 2.0f, params::window_height / 2.0f);
+    _ui.clear();
+    _ui.set_font(EngineUtils::GetRelativePath("resources/fonts/vcr_mono.ttf"), 60);
+    _ui.add_text("Cube Zone\n\n\nPress 0 for Basic Level\nPress 1 for the Tutorial", 60, sf::Color::White, UiLayer::ANCHOR_CENTRE);
 }
 
 /// <summary>
@@ -108,11 +112,12 @@ void TutorialScene::update(const float& dt) {
     // Static variable to track if key was pressed last frame (prevents holding key)
     static bool key_was_pressed = false;
 
-    bool key_is_pressed = sf::Keyboard::isKeyPressed(sf::Keyboard::Enter);
+    bool key_is_pressed = Input::is_key_pressed(sf::Keyboard::Enter);
 
     // Only trigger on key press (not hold)
     if (key_is_pressed && !key_was_pressed)
     {
+        Renderer::sync();
         unload();
 
         GameSystem::setActiveScene(Scenes::menuScene);
@@ -129,7 +134,7 @@ void TutorialScene::update(const float& dt) {
 /// Includes text.
 /// </summary>
 void TutorialScene::render() {
-    Renderer::queue(&_text);
+    _ui.render();
     Scene::render();
 }
 
@@ -137,15 +142,10 @@ void TutorialScene::render() {
 /// Loads the font and text into the Tutorial scene.
 /// </summary>
 void TutorialScene::load() {
-    _font.loadFromFile(EngineUtils::GetRelativePath("resources/fonts/vcr_mono.ttf"));
-    _text.setFont(_font);
-    _text.setCharacterSize(60);
-    _text.setString("Press 'W' to jump.\nPress 'A' to move left.\nPress 'D' to move right.\nPress the left mouse button or space to shoot.\nPress 'R' to reload.\n\nPress 'Enter' to return to the Menu from here.");
-
-    // Center the Tutorial text
-    sf::FloatRect textBounds = _text.getLocalBounds();
-    _text.setOrigin(textBounds.width / 2.0f, textBounds.height / 2.0f);
-    _text.setPosition(params::window_width / 2.0f, params::window_height / 2.0f);
+    _ui.clear();
+    _ui.set_font(EngineUtils::GetRelativePath("resources/fonts/vcr_mono.ttf"), 60);
+    _ui.add_text("Press 'W' to jump.\nPress 'A' to move left.\nPress 'D' to move right.\nPress the left mouse button or space to shoot.\nPress 'R' to reload.\n\nPress 'Enter' to return to the Menu from here.",
+                 60, sf::Color::White, UiLayer::ANCHOR_CENTRE);
 }
 
 /// <summary>
@@ -161,11 +161,12 @@ void TutorialScene::unload(){
 void DeathScene::update(const float& dt) {
     // Static variable to prevent key hold
     static bool key_was_pressed = false;
-    bool key_is_pressed = sf::Keyboard::isKeyPressed(sf::Keyboard::Num0);
+    bool key_is_pressed = Input::is_key_pressed(sf::Keyboard::Num0);
 
     // Only trigger on NEW key press
     if (key_is_pressed && !key_was_pressed)
     {
+        Renderer::sync();
         unload();
         // Return to menu
         GameSystem::setActiveScene(Scenes::menuScene);
@@ -179,20 +180,7 @@ void DeathScene::update(const float& dt) {
 /// Renders the DeathScene - full black screen with red text
 /// </summary>
 void DeathScene::render() {
-    // Get current view
-    sf::View currentView = Renderer::getWindow().getView();
-    sf::Vector2f viewCenter = currentView.getCenter();
-    sf::Vector2f viewSize = currentView.getSize();
-
-    sf::RectangleShape overlay(viewSize);
-    overlay.setPosition(viewCenter - viewSize / 2.0f);
-    overlay.setFillColor(sf::Color::Black);
-    Renderer::getWindow().draw(overlay);
-
-    // Draw death text centered
-    _death_text.setPosition(viewCenter);
-    Renderer::getWindow().draw(_death_text);
-
+    _ui.render();
     Scene::render();
 }
 
@@ -200,22 +188,14 @@ void DeathScene::render() {
 /// Loads the death screen font and text
 /// </summary>
 void DeathScene::load() {
-    if (!_death_font.loadFromFile(EngineUtils::GetRelativePath("resources/fonts/vcr_mono.ttf")))
+    // A full-screen black panel under the text; both are one draw.
+    _ui.clear();
+    if (!_ui.set_font(EngineUtils::GetRelativePath("resources/fonts/vcr_mono.ttf"), 60))
     {
-        throw("ERROR: Could not load death screen font!");
-    }
-    else
-    {
-        _death_text.setFont(_death_font);
-        _death_text.setCharacterSize(60);
-        _death_text.setFillColor(sf::Color::Red);
-        _death_text.setString("YOU DIED\n\nPress 0 to return to menu");
-
-        // Center the text
-        sf::FloatRect textBounds = _death_text.getLocalBounds();
-        _death_text.setOrigin(textBounds.width / 2.0f, textBounds.height / 2.0f);
-        _death_text.setPosition(params::window_width / 2.0f, params::window_height / 2.0f);
+        throw std::string("ERROR: Could not load death screen font!");
     }
+    _ui.add_panel(sf::Vector2f(0.0f, 0.0f), sf::Color::Black, UiLayer::ANCHOR_TOP_LEFT);
+    _ui.add_text("YOU DIED\n\nPress 0 to return to menu", 60, sf::Color::Red, UiLayer::ANCHOR_CENTRE);
 }
 
 /// <summary>
@@ -228,32 +208,37 @@ void DeathScene::unload(){
 // Basic Level Scene
 void BasicLevelScene::m_load_level(const std::string &level, int enemyCount)
 {
-    LevelSystem::load_level(level, params::tile_size);
-    this->set_enemy_count(enemyCount);
-    m_portal_spawned = false;
-    m_portal.reset();
-    m_alive_enemy_count = enemyCount;  // Initialise alive enemy counter
-    m_active_bullets.clear();  // Clear active bullets list
-
-    initialise_bullet_pool(100);  // Create pool of 100 bullets
-
-    if (!m_reload_font.loadFromFile(EngineUtils::GetRelativePath("resources/fonts/vcr_mono.ttf")))
+    PROFILE_ZONE("BasicLevelScene::m_load_level");
+    if (level == m_world)
     {
-        throw("ERROR: Could not load reload UI font!");
+        LevelSystem::load_world(level, params::tile_size, params::world_chunk_budget);
     }
     else
     {
-        m_reload_text.setFont(m_reload_font);
-        m_reload_text.setCharacterSize(40);
-        m_reload_text.setFillColor(sf::Color::Red);
-        m_reload_text.setString("RELOADING...");
+        LevelSystem::load_level(level, params::tile_size);
     }
+    this->set_enemy_count(enemyCount);
+    m_portal_spawned = false;
+    m_portal = EntityHandle();
+    m_projectiles.clear();
 
-    m_player = make_entity();
-    m_player->set_position(LevelSystem::get_start_pos());
+    // Enemy AI and bullets run as systems, in parallel where possible.
+    m_scheduler.clear(m_entities);
+    m_scheduler.add<EnemySteeringSystem>(m_entities);
+    m_scheduler.add<EnemyShootingSystem>(m_entities);
+    m_scheduler.add<ProjectileSystem>(m_entities, &m_projectiles);
+    m_scheduler.add<EnemyPhysicsSyncSystem>(m_entities);
+    m_scheduler.add<BulletSpawnSystem>(m_entities);
+
+    load_hud();
+
+    Entity &player = make_entity();
+    m_player = player.get_handle();
+    player.set_layer(LAYER_PLAYER);
+    player.set_position(LevelSystem::get_start_pos());
 
     // Create player with sprite
-    std::shared_ptr<SpriteComponent> playerSprite = m_player->add_component<SpriteComponent>();
+    std::shared_ptr<SpriteComponent> playerSprite = player.add_component<SpriteComponent>();
 
     // Try to load player sprite, fallback to colored rectangle if it fails
     if (playerSprite->load_texture(EngineUtils::GetRelativePath("resources/sprites/player_sprite.png")))
@@ -264,7 +249,7 @@ void BasicLevelScene::m_load_level(const std::string &level, int enemyCount)
     else
     {
         // Fallback to shape if texture loading fails
-        std::shared_ptr<ShapeComponent> shape = m_player->add_component<ShapeComponent>();
+        std::shared_ptr<ShapeComponent> shape = player.add_component<ShapeComponent>();
         shape->set_shape<sf::RectangleShape>(sf::Vector2f(params::player_size[0],params::player_size[1]));
         shape->get_shape().setFillColor(sf::Color::Yellow);
         shape->get_shape().setOrigin(sf::Vector2f(params::player_size[0]/2.f,params::player_size[1]/2.f));
@@ -272,29 +257,69 @@ void BasicLevelScene::m_load_level(const std::string &level, int enemyCount)
 
     // Add player physics component
     std::shared_ptr<PlayerControlComponent> component =
-    m_player->add_component<PlayerControlComponent>(sf::Vector2f(params::player_size[0],params::player_size[1]));
+    player.add_component<PlayerControlComponent>(sf::Vector2f(params::player_size[0],params::player_size[1]));
 
     component->create_box_shape({params::player_size[0], params::player_size[1]},
         params::player_weight, params::player_friction, params::player_restitution);
 
     // Add player health component
-    m_player->add_component<HealthComponent>(100.0f);
+    player.add_component<HealthComponent>(100.0f);
 
     // Add player shooting component
-    m_player->add_component<PlayerShootingComponent>(this);
+    player.add_component<PlayerShootingComponent>(this);
+
+    // Create walls. A streamed world's come and go with its chunks.
+    if (LevelStreamer *streamer = LevelSystem::get_streamer())
+    {
+        streamer->set_callbacks(
+            [this](const LevelStreamer::Chunk &chunk)
+            {
+                Entity &wall = make_entity();
+                wall.set_layer(LAYER_WORLD);
+                wall.add_component<PlatformComponent>(chunk.chains);
+                m_world_walls[chunk.index] = wall.get_handle();
+            },
+            [this](const LevelStreamer::Chunk &chunk)
+            {
+                auto found = m_world_walls.find(chunk.index);
+                if (found == m_world_walls.end())
+                {
+                    return;
+                }
+                if (Entity *wall = resolve(found->second))
+                {
+                    wall->set_to_delete();
+                }
+                m_world_walls.erase(found);
+            });
 
-    // Create walls
-    std::vector<std::vector<sf::Vector2i>> wall_groups = LevelSystem::get_groups(LevelSystem::WALL);
-    for (const std::vector<sf::Vector2i> &walls : wall_groups) {
-        m_walls.push_back(make_entity());
-        m_walls.back()->add_component<PlatformComponent>(walls);
+        // The chunks around the start must be in before anything can fall through them.
+        stream_world(LevelSystem::get_start_pos());
+        streamer->wait_for_requests();
+    }
+    else
+    {
+        Entity &wall = make_entity();
+        wall.set_layer(LAYER_WORLD);
+        wall.add_component<PlatformComponent>(LevelSystem::get_outlines(LevelSystem::WALL));
+        m_walls.push_back(wall.get_handle());
     }
 
     // Retrieve empty tiles
-    std::vector<sf::Vector2i> emptyTiles = LevelSystem::find_tiles(LevelSystem::Tile::EMPTY);
+    LevelSystem::TileSpan emptyTiles = LevelSystem::find_tiles(LevelSystem::Tile::EMPTY);
     // Picks input amount of positions to create an enemy at.
     std::vector<sf::Vector2i> enemyPositions = place_enemies_randomly(emptyTiles, enemyCount);
-    add_enemies(this->enemyCount, enemyPositions);
+    add_enemies(static_cast<int>(enemyPositions.size()), enemyPositions);
+    // Counts the enemies actually placed; enemyCount stays as asked for, so
+    // the next level still adds one to it.
+    m_alive_enemy_count = static_cast<int>(enemyPositions.size());
+    m_last_enemy_position = sf::Vector2f(0.0f, 0.0f);
+
+    // With none to kill, e.g. --enemies 0 or no empty tiles, the way on is open now.
+    if (m_alive_enemy_count == 0)
+    {
+        spawn_portal();
+    }
 
     // Build initial collision targets list
     rebuild_collision_targets();
@@ -302,21 +327,45 @@ void BasicLevelScene::m_load_level(const std::string &level, int enemyCount)
 
 void BasicLevelScene::rebuild_collision_targets()
 {
-    m_collision_targets.clear();
-    m_collision_targets.push_back(m_player);
+    m_enemy_targets.clear();
 
-    for (const auto& enemy : m_enemies)
+    for (EntityHandle handle : m_enemies)
     {
+        Entity *enemy = resolve(handle);
         if (enemy && enemy->is_alive() && !enemy->to_be_deleted())
         {
-            m_collision_targets.push_back(enemy);
+            m_enemy_targets.push_back(handle);
+        }
+    }
+}
+
+/// <summary>
+/// Puts the collision targets into their layer's grid at their current positions.
+/// </summary>
+void BasicLevelScene::rebuild_target_grids()
+{
+    m_player_grid.clear();
+    if (Entity *player = resolve(m_player))
+    {
+        m_player_grid.insert(m_player, player->get_position());
+    }
+    m_player_grid.build();
+
+    m_enemy_grid.clear();
+    for (EntityHandle handle : m_enemy_targets)
+    {
+        if (Entity *enemy = resolve(handle))
+        {
+            m_enemy_grid.insert(handle, enemy->get_position());
         }
     }
+    m_enemy_grid.build();
 }
 
 void BasicLevelScene::on_enemy_death(sf::Vector2f death_position)
 {
     m_alive_enemy_count--;
+    m_enemies_killed++;
     m_last_enemy_position = death_position;
 
     // Rebuild targets list since an enemy died
@@ -329,19 +378,86 @@ void BasicLevelScene::on_enemy_death(sf::Vector2f death_position)
     }
 }
 
-int BasicLevelScene::count_alive_enemies() const
+/// <summary>
+/// Damages the first target each projectile overlaps and removes the
+/// projectiles that hit something or ran out.
+/// </summary>
+void BasicLevelScene::check_projectile_hits()
 {
-    return m_alive_enemy_count;  // Now  return cached value
+    for (std::size_t i = 0; i < m_projectiles.size(); ++i)
+    {
+        if (m_projectiles.is_dead(i)) continue;
+
+        const sf::Vector2f position = m_projectiles.get_position(i);
+        const EntityHandle owner = m_projectiles.get_owner(i);
+        const LayerMask hits = m_projectiles.get_hit_mask(i);
+        Entity *hit = nullptr;
+
+        auto visit = [&](EntityHandle target, const sf::Vector2f &) {
+            // Don't collide with owner, removed or dead entities, or entities marked for deletion
+            Entity *entity = resolve(target);
+            if (target == owner || !entity || !entity->is_alive() || entity->to_be_deleted())
+            {
+                return true;
+            }
+
+            // Friendly fire check - only layers in the hit mask take damage
+            if (!(entity->get_layer() & hits))
+            {
+                return true;
+            }
+
+            hit = entity;
+            return false;
+        };
+
+        if (hits & LAYER_ENEMY)
+        {
+            m_enemy_grid.query_radius(position, projectile_hit_radius, visit);
+        }
+        if ((hits & LAYER_PLAYER) && !hit)
+        {
+            m_player_grid.query_radius(position, projectile_hit_radius, visit);
+        }
+
+        if (!hit) continue;
+
+        if (HealthComponent *health = hit->get_component<HealthComponent>())
+        {
+            const float health_before = health->get_current_health();
+            health->take_damage(m_projectiles.get_damage(i));
+
+            if (health_before > 0.0f && health->get_current_health() <= 0.0f && hit->get_layer() == LAYER_ENEMY)
+            {
+                on_enemy_death(position);
+            }
+        }
+
+        m_projectiles.kill(i);
+    }
+
+    m_projectiles.remove_dead();
 }
 
-int BasicLevelScene::count_bullets() const
+/// <summary>
+/// Gets the most enemies a level can have.
+/// Scales with the cores available to the enemy systems.
+/// </summary>
+/// <returns>The enemy cap.</returns>
+int BasicLevelScene::max_enemy_count() const
+{
+    const int cores = static_cast<int>(ThreadPool::shared().get_concurrency());
+    return std::max(params::max_enemies, params::max_enemies * cores / params::max_enemies_baseline_cores);
+}
+
+int BasicLevelScene::count_alive_enemies() const
 {
-    return m_active_bullets.size();  // Return size of active bullets list
+    return m_alive_enemy_count;  // Now  return cached value
 }
 
 void BasicLevelScene::spawn_portal()
 {
-    if (m_portal_spawned || m_portal)
+    if (m_portal_spawned || resolve(m_portal))
     {
         return; // Portal already spawned
     }
@@ -350,16 +466,18 @@ void BasicLevelScene::spawn_portal()
     sf::Vector2f portalPos = m_last_enemy_position;
 
     // Fallback to player position tile if no enemy position tracked (in the case of no kiled enemies)
-    if (portalPos.x == 0.0f && portalPos.y == 0.0f)
+    Entity *player = resolve(m_player);
+    if (portalPos.x == 0.0f && portalPos.y == 0.0f && player)
     {
-        portalPos = m_player->get_position();
+        portalPos = player->get_position();
     }
 
     // Create portal entity
-    m_portal = make_entity();
-    m_portal->set_position(portalPos);
+    Entity &portal = make_entity();
+    m_portal = portal.get_handle();
+    portal.set_position(portalPos);
 
-    std::shared_ptr<ShapeComponent> shape = m_portal->add_component<ShapeComponent>();
+    std::shared_ptr<ShapeComponent> shape = portal.add_component<ShapeComponent>();
     shape->set_shape<sf::CircleShape>(params::tile_size * 0.8f); // Bigger circle
     shape->get_shape().setFillColor(sf::Color(0, 255, 0, 220)); // Bright green, almost opaque
     shape->get_shape().setOutlineColor(sf::Color::Yellow); // Yellow outline
@@ -371,7 +489,9 @@ void BasicLevelScene::spawn_portal()
 
 void BasicLevelScene::update(const float& dt) {
     // Check if player is dead - switch to death scene
-    if (m_player && (!m_player->is_alive() || m_player->get_position().y > 2000.0f))
+    // The handle stops resolving once a killed player has been removed.
+    Entity *player = resolve(m_player);
+    if (!player || !player->is_alive() || player->get_position().y > fall_limit())
     {
         // Switch to the death scene (should already exist from main.cpp)
         if (Scenes::deathScene)
@@ -381,49 +501,36 @@ void BasicLevelScene::update(const float& dt) {
         return; // Stop updating this scene
     }
 
-    Scene::update(dt);
-    m_entities.update(dt);
-
-    // Return dead bullets to pool and remove from active list
-    m_active_bullets.erase(
-        std::remove_if(m_active_bullets.begin(), m_active_bullets.end(),
-            [this](std::shared_ptr<Entity>& bullet) {
-                if (!bullet->is_alive()) {
-                    return_bullet_to_pool(bullet);
-                    return true;  // Remove from active list
-                }
-                return false;  // Keep in active list
-            }),
-        m_active_bullets.end()
-    );
-
-    // Check bullet collisions - only iterate through active bullets
-    for (auto& bullet : m_active_bullets)
+    if (LevelSystem::get_streamer())
     {
-        if (!bullet || !bullet->is_alive()) continue;
+        stream_world(player->get_position());
+    }
 
-        auto bullet_components = bullet->get_compatible_components<BulletComponent>();
-        if (!bullet_components.empty() && bullet_components[0])
-        {
-            // Set callback to trigger on_enemy_death when a kill happens
-            bullet_components[0]->set_on_kill_callback([this](sf::Vector2f kill_position) {
-                on_enemy_death(kill_position);
-            });
+    Scene::update(dt);
 
-            bullet_components[0]->check_collision(m_collision_targets);
-        }
+    // The FPS readout changes every frame, so it is only relaid a few times a second.
+    m_fps_timer += dt;
+    if (m_fps_timer >= hud_fps_interval)
+    {
+        m_fps_timer = 0.0f;
+        m_hud.set_text(m_hud_fps, std::to_string(static_cast<int>(GameSystem::get_fps() + 0.5f)) + " FPS");
     }
 
+    // Check bullet collisions, each against the targets near it on the layers it hits
+    rebuild_target_grids();
+    check_projectile_hits();
 
     // Enemy falling off screen death
-    for (auto& enemy : m_enemies)
+    for (EntityHandle handle : m_enemies)
     {
+        Entity *enemy = resolve(handle);
         if (!enemy || !enemy->is_alive()) continue;
         // enemy->set_position(sf::Vector2f(-2000.0f, 2500.0f));
-        if (enemy->get_position().y > 2000.0f)
+        if (enemy->get_position().y > fall_limit())
         {
             enemy->set_alive(false);
             m_alive_enemy_count--;
+            m_enemies_killed++;
 
             if (m_alive_enemy_count == 0 && !m_portal_spawned)
             {
@@ -435,87 +542,189 @@ void BasicLevelScene::update(const float& dt) {
         }
     }
 
-    // Camera follows player position
-    GameSystem::moveCamera(m_player->get_position());
-
     // Check if player reached portal
-    if (m_portal_spawned && m_portal)
+    Entity *portal = resolve(m_portal);
+    if (m_portal_spawned && portal)
     {
         // Check distance to portal
-        sf::Vector2f toPortal = m_portal->get_position() - m_player->get_position();
+        sf::Vector2f toPortal = portal->get_position() - player->get_position();
         float distance = std::sqrt(toPortal.x * toPortal.x + toPortal.y * toPortal.y);
 
         if (distance < params::tile_size * 1.5f)  // Made activation area bigger
         {
             int enemyCount = this->enemyCount;
-            if (this->enemyCount + 1 <= 50)
+            if (this->enemyCount + 1 <= max_enemy_count())
             {
                 enemyCount = this->enemyCount + 1;
             }
+            m_levels_cleared++;
+            // Unloading frees textures and UI a frame still being drawn uses.
+            Renderer::sync();
             unload();
-            m_load_level(EngineUtils::GetRelativePath(pick_level_randomly()), enemyCount);
+            m_load_level(m_world.empty() ? EngineUtils::GetRelativePath(pick_level_randomly()) : m_world, enemyCount);
         }
     }
 }
 
 void BasicLevelScene::render() {
+    // Camera follows the player where the player is drawn
+    if (Entity *player = resolve(m_player))
+    {
+        GameSystem::moveCamera(player->get_interpolated_position(Renderer::get_interpolation()));
+    }
+
     // Normal game rendering
-    LevelSystem::render(Renderer::getWindow());
+    LevelSystem::get_visible_chunks(Renderer::get_view_bounds(), m_visible_chunks);
+    for (const sf::VertexArray *chunk : m_visible_chunks)
+    {
+        Renderer::queue(chunk, RENDER_LAYER_LEVEL);
+    }
+    Renderer::frame_cull_stats().chunks_drawn += LevelSystem::get_chunks_drawn();
+    Renderer::frame_cull_stats().chunks_culled += LevelSystem::get_chunks_culled();
     Scene::render();
-    m_entities.render();
 
-    // Render reload UI if player is reloading
-    if (m_player)
+    update_hud();
+    m_hud.render();
+}
+
+/// <summary>
+/// Builds the HUD: reload text, ammo counter, health bar and FPS.
+/// Cached, so moving to the next level does not read the font again.
+/// </summary>
+void BasicLevelScene::load_hud() {
+    m_hud.clear();
+    if (!m_hud.set_font(EngineUtils::GetRelativePath("resources/fonts/vcr_mono.ttf"), 24))
+    {
+        throw std::string("ERROR: Could not load reload UI font!");
+    }
+    m_hud_reload = m_hud.add_text("RELOADING...", 40, sf::Color::Red, UiLayer::ANCHOR_TOP, sf::Vector2f(0.0f, 50.0f));
+    m_hud_ammo = m_hud.add_text("", 24, sf::Color::White, UiLayer::ANCHOR_BOTTOM_RIGHT, sf::Vector2f(-20.0f, -20.0f));
+    m_hud.add_panel(hud_health_size, sf::Color(60, 0, 0), UiLayer::ANCHOR_BOTTOM_LEFT, sf::Vector2f(20.0f, -20.0f));
+    m_hud_health = m_hud.add_panel(hud_health_size, sf::Color::Red, UiLayer::ANCHOR_BOTTOM_LEFT, sf::Vector2f(20.0f, -20.0f));
+    m_hud_fps = m_hud.add_text("", 24, sf::Color::White, UiLayer::ANCHOR_TOP_RIGHT, sf::Vector2f(-20.0f, 20.0f));
+    m_hud.set_visible(m_hud_reload, false);
+    m_fps_timer = hud_fps_interval;
+}
+
+/// <summary>
+/// Copies the player's state into the HUD. Elements whose value is the
+/// same as last frame are left alone, so a steady HUD costs no layout.
+/// </summary>
+void BasicLevelScene::update_hud() {
+    Entity *player = resolve(m_player);
+    if (!player)
     {
-        auto shooting_components = m_player->get_compatible_components<PlayerShootingComponent>();
-        if (!shooting_components.empty() && shooting_components[0])
-        {
-            if (shooting_components[0]->is_reloading())
-            {
-                // Get current view for positioning
-                sf::View currentView = Renderer::getWindow().getView();
-                sf::Vector2f viewCenter = currentView.getCenter();
-                sf::Vector2f viewSize = currentView.getSize();
+        return;
+    }
 
-                // Position reload text at top center of screen
-                m_reload_text.setPosition(viewCenter.x, viewCenter.y - viewSize.y / 2.0f + 50.0f);
+    if (PlayerShootingComponent *shooting = player->get_component<PlayerShootingComponent>())
+    {
+        m_hud.set_visible(m_hud_reload, shooting->is_reloading());
+        m_hud.set_text(m_hud_ammo, std::to_string(shooting->get_current_ammo()) + " / " + std::to_string(shooting->get_clip_size()));
+    }
 
-                // Center horizontally
-                sf::FloatRect bounds = m_reload_text.getLocalBounds();
-                m_reload_text.setOrigin(bounds.width / 2.0f, 0.0f);
+    if (HealthComponent *health = player->get_component<HealthComponent>())
+    {
+        const float max_health = health->get_max_health();
+        const float fraction = max_health > 0.0f ? std::max(0.0f, health->get_current_health() / max_health) : 0.0f;
+        const float width = std::min(fraction, 1.0f) * hud_health_size.x;
 
-                Renderer::getWindow().draw(m_reload_text);
-            }
+        // A zero width would stretch the panel across the screen.
+        m_hud.set_visible(m_hud_health, width > 0.0f);
+        if (width > 0.0f)
+        {
+            m_hud.set_size(m_hud_health, sf::Vector2f(width, hud_health_size.y));
         }
     }
 }
 
 void BasicLevelScene::load() {
     this->currentLevel = 0;
+    if (!m_world.empty())
+    {
+        m_load_level(m_world, this->enemyCount);
+        return;
+    }
+    if (m_start_level > 0)
+    {
+        this->currentLevel = m_start_level;
+        m_load_level(EngineUtils::GetRelativePath(params::getLevels().at(m_start_level)), this->enemyCount);
+        return;
+    }
     m_load_level(EngineUtils::GetRelativePath(pick_level_randomly()), this->enemyCount);
 }
 
+/// <summary>
+/// Whether the run is over: the player has died or fallen out of the level.
+/// </summary>
+/// <returns>Whether the scene is finished.</returns>
+bool BasicLevelScene::is_finished() const {
+    const Entity *player = resolve(m_player);
+    return !player || !player->is_alive() || player->get_position().y > fall_limit();
+}
+
+/// <summary>
+/// How far down something can fall before it has left the level.
+/// </summary>
+/// <returns>The height in pixels.</returns>
+float BasicLevelScene::fall_limit() const {
+    return std::max(2000.0f, LevelSystem::get_height() * params::tile_size + 1000.0f);
+}
+
+/// <summary>
+/// Streams in the world's chunks around a point, a window's size across,
+/// and lets the ones left behind go.
+/// </summary>
+/// <param name="centre">Where to stream around, usually the player.</param>
+void BasicLevelScene::stream_world(const sf::Vector2f &centre) {
+    const sf::Vector2f size(params::window_width, params::window_height);
+    LevelSystem::get_streamer()->update(sf::FloatRect(centre - size / 2.0f, size));
+}
+
+/// <summary>
+/// Writes how far the run got.
+/// </summary>
+/// <param name="out">Stream to write to.</param>
+void BasicLevelScene::write_stats(std::ostream &out) const {
+    const Entity *player = resolve(m_player);
+    HealthComponent *health = player ? player->get_component<HealthComponent>() : nullptr;
+
+    out << "Levels cleared: " << m_levels_cleared << "\n";
+    out << "Current level: " << this->currentLevel << "\n";
+    out << "Enemies killed: " << m_enemies_killed << "\n";
+    out << "Enemies alive: " << m_alive_enemy_count << "\n";
+    out << "Player alive: " << (is_finished() ? "no" : "yes") << "\n";
+    out << "Player health: " << (health ? health->get_current_health() : 0.0f) << "\n";
+}
+
 void BasicLevelScene::unload() {
     Scene::unload();
-    m_player.reset();
+    LevelSystem::close_world();
+    m_player = EntityHandle();
     m_walls.clear();
+    m_world_walls.clear();
     m_enemies.clear();
-    m_portal.reset();
+    m_portal = EntityHandle();
     m_portal_spawned = false;
-    m_active_bullets.clear();
-    m_collision_targets.clear();
+    m_enemy_targets.clear();
+    m_player_grid.clear();
+    m_enemy_grid.clear();
     m_alive_enemy_count = 0;
 }
 
-std::vector<sf::Vector2i> BasicLevelScene::place_enemies_randomly(std::vector<sf::Vector2i> tiles, int enemyCount) {
+std::vector<sf::Vector2i> BasicLevelScene::place_enemies_randomly(LevelSystem::TileSpan tiles, int enemyCount) {
     std::vector<sf::Vector2i> enemyPositions;
-    std::random_device random_device;
-    std::default_random_engine engine(random_device());
+    // A level with no empty tiles gets no enemies.
+    if (tiles.empty())
+    {
+        return enemyPositions;
+    }
+
     std::uniform_int_distribution<> distribution(0, tiles.size() - 1);
     sf::Vector2i chosenPosition;
     for (size_t i = 0; i < enemyCount; i++)
     {
-        chosenPosition = tiles[distribution(engine)];
+        chosenPosition = tiles[distribution(Random::engine())];
         enemyPositions.push_back(sf::Vector2i(chosenPosition.x * params::tile_size, chosenPosition.y * params::tile_size));
     }
 
@@ -523,13 +732,11 @@ std::vector<sf::Vector2i> BasicLevelScene::place_enemies_randomly(std::vector<sf
 }
 
 std::string BasicLevelScene::pick_level_randomly() {
-    std::random_device random_device;
-    std::default_random_engine engine(random_device());
     std::uniform_int_distribution<> distribution(1, params::getLevels().size());
     int levelInt = 0;
     do
     {
-        levelInt = distribution(engine);
+        levelInt = distribution(Random::engine());
 
     } while (this->currentLevel == levelInt);
     this->currentLevel = levelInt;
@@ -540,11 +747,13 @@ std::string BasicLevelScene::pick_level_randomly() {
 void BasicLevelScene::add_enemies(int enemyCount, std::vector<sf::Vector2i> positions) {
     for (size_t i = 0; i < enemyCount; i++)
     {
-        m_enemies.push_back(make_entity());
-        m_enemies.back()->set_position(sf::Vector2f(positions.at(i).x, positions.at(i).y));
+        Entity &enemy = make_entity();
+        enemy.set_layer(LAYER_ENEMY);
+        m_enemies.push_back(enemy.get_handle());
+        enemy.set_position(sf::Vector2f(positions.at(i).x, positions.at(i).y));
 
         // Create enemy with sprite
-        std::shared_ptr<SpriteComponent> enemySprite = m_enemies.back()->add_component<SpriteComponent>();
+        std::shared_ptr<SpriteComponent> enemySprite = enemy.add_component<SpriteComponent>();
 
         // Try to load enemy sprite, fallback to colored rectangle if it fails
         if (enemySprite->load_texture(EngineUtils::GetRelativePath("resources/sprites/enemy_sprite.png")))
@@ -555,25 +764,25 @@ void BasicLevelScene::add_enemies(int enemyCount, std::vector<sf::Vector2i> posi
         else
         {
             // Fallback to shape if texture loading fails
-            std::shared_ptr<ShapeComponent> shape = m_enemies.back()->add_component<ShapeComponent>();
+            std::shared_ptr<ShapeComponent> shape = enemy.add_component<ShapeComponent>();
             shape->set_shape<sf::RectangleShape>(sf::Vector2f(params::enemy_size[0], params::enemy_size[1]));
             shape->get_shape().setFillColor(sf::Color::Blue);
             shape->get_shape().setOrigin(sf::Vector2f(params::enemy_size[0] / 2.f, params::enemy_size[1] / 2.f));
         }
 
-        std::shared_ptr<EnemyControlComponent> component = m_enemies.back()->add_component<EnemyControlComponent>(sf::Vector2f(params::enemy_size[0], params::enemy_size[1]));
+        std::shared_ptr<EnemyControlComponent> component = enemy.add_component<EnemyControlComponent>(sf::Vector2f(params::enemy_size[0], params::enemy_size[1]));
         component->create_box_shape({ params::enemy_size[0] - 3, params::enemy_size[1] - 3 },
             params::enemy_weight, params::enemy_friction, params::enemy_restitution);
         component->set_target(m_player);
 
         // Add enemy health component
-        m_enemies.back()->add_component<HealthComponent>(30.0f);
+        enemy.add_component<HealthComponent>(30.0f);
 
         // Add enemy shooting component with balanced parameters
         // Parameters: (entity, scene, target, clip_size, reload_time, fire_rate, bullet_speed, bullet_damage)
-        auto enemyShooter = m_enemies.back()->add_component<EnemyShootingComponent>(
+        auto enemyShooter = enemy.add_component<EnemyShootingComponent>(
             this,
-            m_player.get(),
+            m_player,
             10,     // clip_size - 10 shots before reload
             2.0f,   // reload_time - 2 seconds to reload
             2.0f,   // fire_rate - 2.0 shots/second (shoot every 0.5 seconds!)
@@ -585,73 +794,3 @@ void BasicLevelScene::add_enemies(int enemyCount, std::vector<sf::Vector2i> posi
         enemyShooter->set_random_delay_range(0.0f, 1.0f);  // Very short delays: 0-1 seconds!
     }
 }
-
-// Bullet pool implementation
-void BasicLevelScene::initialise_bullet_pool(int pool_size) {
-    // Clear any existing pool
-    m_bullet_pool.clear();
-    while (!m_available_bullets.empty()) {
-        m_available_bullets.pop();
-    }
-
-    // Create pool of inactive bullets off-screen
-    for (int i = 0; i < pool_size; i++) {
-        auto bullet = make_entity();
-        bullet->set_position(sf::Vector2f(-10000.0f, -10000.0f)); // Way off-screen
-        bullet->set_alive(false); // Mark as inactive
-
-        // Add visual component (will be configured when bullet is used)
-        auto shape = bullet->add_component<ShapeComponent>();
-        shape->set_shape<sf::CircleShape>(3.0f); // Default size
-        shape->get_shape().setFillColor(sf::Color::White); // Default color
-        shape->get_shape().setOrigin(3.0f, 3.0f);
-
-        // Store in pool
-        m_bullet_pool.push_back(bullet);
-        m_available_bullets.push(bullet);
-    }
-}
-
-std::shared_ptr<Entity> BasicLevelScene::get_bullet_from_pool() {
-    if (m_available_bullets.empty()) {
-        // Pool exhausted - create a new bullet (fallback)
-        auto bullet = make_entity();
-        auto shape = bullet->add_component<ShapeComponent>();
-        shape->set_shape<sf::CircleShape>(3.0f);
-        shape->get_shape().setFillColor(sf::Color::White);
-        shape->get_shape().setOrigin(3.0f, 3.0f);
-        m_bullet_pool.push_back(bullet); // Add to pool for tracking
-
-        // Add to active bullets list
-        m_active_bullets.push_back(bullet);
-        return bullet;
-    }
-
-    // Get bullet from pool
-    auto bullet = m_available_bullets.front();
-    m_available_bullets.pop();
-
-    // Activate bullet
-    bullet->set_alive(true);
-    bullet->set_visible(true);
-
-    // Add to active bullets list
-    m_active_bullets.push_back(bullet);
-
-    return bullet;
-}
-
-void BasicLevelScene::return_bullet_to_pool(std::shared_ptr<Entity> bullet) {
-    if (!bullet) return;
-
-    // Deactivate bullet
-    bullet->set_alive(false);
-    bullet->set_position(sf::Vector2f(-10000.0f, -10000.0f));
-
-    // Remove any bullet components (they'll be re-added when reused)
-    // This is important to reset state
-    bullet->remove_components_by_type<BulletComponent>();
-
-    // Return to available pool
-    m_available_bullets.push(bullet);
-}
\ No newline at end of file
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "game_system.hpp"
+#include "level_system.hpp"
 #include "physics.hpp"
-#include <queue>
+#include "spatial_hash.hpp"
+#include "ui_layer.hpp"
+#include <unordered_map>
 
 struct Scenes
 {
@@ -20,8 +23,7 @@ class MenuScene : public Scene {
         void load() override;
         void unload() override;
     private:
-        sf::Text _text;
-        sf::Font _font;
+        UiLayer _ui;
 };
 
 class TutorialScene : public Scene {
@@ -32,8 +34,7 @@ class TutorialScene : public Scene {
         void load() override;
         void unload() override;
     private:
-        sf::Text _text;
-        sf::Font _font;
+        UiLayer _ui;
 };
 
 class DeathScene : public Scene {
@@ -44,8 +45,7 @@ class DeathScene : public Scene {
         void load() override;
         void unload() override;
     private:
-        sf::Text _death_text;
-        sf::Font _death_font;
+        UiLayer _ui;
 };
 
 class BasicLevelScene : public Scene
@@ -57,53 +57,80 @@ class BasicLevelScene : public Scene
         void load() override;
         void unload() override;
 
-        // Bullet pool methods - PUBLIC so ShootingComponent can access
-        void initialise_bullet_pool(int pool_size = 50);
-        std::shared_ptr<Entity> get_bullet_from_pool();
-        void return_bullet_to_pool(std::shared_ptr<Entity> bullet);
-
-        // Enemy death callback (changed to public so BulletComponent can call it)
+        // Enemy death callback
         void on_enemy_death(sf::Vector2f death_position);
 
+        // Plays this level first instead of a random one. 0 picks randomly.
+        void set_start_level(int level) { m_start_level = level; }
+        // Streams this world file instead of playing the levels.
+        void set_world(const std::string &file_path) { m_world = file_path; }
+
+        bool is_finished() const override;
+        void write_stats(std::ostream &out) const override;
+
     private:
-        std::shared_ptr<Entity> m_player;
-        std::vector<std::shared_ptr<Entity>> m_walls;
-        std::vector<std::shared_ptr<Entity>> m_enemies;
-        std::shared_ptr<Entity> m_portal;
+        EntityHandle m_player;
+        std::vector<EntityHandle> m_walls;
+        std::vector<EntityHandle> m_enemies;
+        EntityHandle m_portal;
         bool m_portal_spawned;
 
-        // Bullet pool - pre-created bullets for reuse
-        std::vector<std::shared_ptr<Entity>> m_bullet_pool;
-        std::queue<std::shared_ptr<Entity>> m_available_bullets;
+        // Cached living enemies for bullets to hit (rebuilt when enemies die)
+        std::vector<EntityHandle> m_enemy_targets;
 
-        // Active bullets tracking for efficient iteration
-        std::vector<std::shared_ptr<Entity>> m_active_bullets;
-
-        // Cached collision targets (rebuilt when enemies die)
-        std::vector<std::shared_ptr<Entity>> m_collision_targets;
+        // Collision targets by layer and position, rebuilt each frame for the
+        // bullet pass, so player bullets only see enemies and enemy bullets the player
+        SpatialHash m_player_grid;
+        SpatialHash m_enemy_grid;
 
         // Cached alive enemy count (updated on death instead of counting every frame)
         int m_alive_enemy_count = 0;
 
-        // Reload UI
-        sf::Text m_reload_text;
-        sf::Font m_reload_font;
+        // Tile chunks in view this frame
+        std::vector<const sf::VertexArray *> m_visible_chunks;
 
-        // Bullet count limiting (prevent too many bullets)
-        int m_max_bullets = 100;
+        // HUD, laid out once in load_hud() and updated through setters
+        UiLayer m_hud;
+        UiLayer::Element m_hud_reload = 0;
+        UiLayer::Element m_hud_ammo = 0;
+        UiLayer::Element m_hud_health = 0;
+        UiLayer::Element m_hud_fps = 0;
+        float m_fps_timer = 0.0f;
+        static constexpr float hud_fps_interval = 0.5f;   // seconds between FPS readouts
+        static inline const sf::Vector2f hud_health_size{200.0f, 16.0f};
 
         // Track last enemy position for portal spawn
         sf::Vector2f m_last_enemy_position;
 
+        int m_start_level = 0;
+
+        // A streamed world's path, and its wall entities by chunk
+        std::string m_world;
+        std::unordered_map<int, EntityHandle> m_world_walls;
+
+        // End-of-run statistics
+        int m_enemies_killed = 0;
+        int m_levels_cleared = 0;
+
         void m_load_level(const std::string& level, int enemyCount);
-        std::vector<sf::Vector2i> place_enemies_randomly(std::vector<sf::Vector2i> tiles, int enemyCount);
+        void stream_world(const sf::Vector2f &centre);
+        float fall_limit() const;
+        std::vector<sf::Vector2i> place_enemies_randomly(LevelSystem::TileSpan tiles, int enemyCount);
         void add_enemies(int enemyCount, std::vector<sf::Vector2i> position);
         std::string pick_level_randomly();
         int currentLevel;
         void spawn_portal();
         int count_alive_enemies() const;
-        int count_bullets() const;
+        int max_enemy_count() const;
 
         // Rebuild collision targets when enemies die
         void rebuild_collision_targets();
+        void rebuild_target_grids();
+        void check_projectile_hits();
+
+        void load_hud();
+        void update_hud();
+
+        // How close a projectile's centre must come to a target's to hit it
+        static constexpr float projectile_hit_radius = 20.0f;
 };
\ No newline at end of file
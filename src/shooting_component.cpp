@@ -1,132 +1,12 @@
 #include "shooting_component.hpp"
-#include "graphic_components.hpp"
-#include "renderer.hpp"
 #include "game_parameters.hpp"
 #include "game_system.hpp"
 #include "level_system.hpp"
-#include "character_components.hpp"
-#include "scenes.hpp"
+#include "input.hpp"
+#include "random.hpp"
 #include <cmath>
-#include <random>
 #include <iostream>
 
-BulletComponent::BulletComponent(Entity* p, const sf::Vector2f& direction, float speed, float damage, float lifetime, Entity* owner)
-    : Component(p), m_direction(direction), m_speed(speed), m_damage(damage),
-      m_lifetime_remaining(lifetime), m_max_lifetime(lifetime), m_owner(owner)
-{
-    // Normalize direction
-    float length = std::sqrt(m_direction.x * m_direction.x + m_direction.y * m_direction.y);
-    if (length > 0.0f)
-    {
-        m_direction = m_direction / length;
-    }
-
-    m_velocity = m_direction * m_speed;
-}
-
-void BulletComponent::update(const float& dt)
-{
-    //Clamp dt values (emergency fix)
-    float safe_dt = (dt > 0.1f) ? 0.016f : dt;
-
-    m_lifetime_remaining -= safe_dt;
-    if (m_lifetime_remaining <= 0.0f)
-    {
-        m_parent->set_alive(false);  // Mark as dead (will be returned to pool)
-        return;
-    }
-
-    // Calculate new position
-    sf::Vector2f old_pos = m_parent->get_position();
-    sf::Vector2f new_pos = old_pos + m_velocity * safe_dt;
-
-    // Check for walls before moving
-    sf::Vector2f direction = new_pos - old_pos;
-    float distance = std::sqrt(direction.x * direction.x + direction.y * direction.y);
-
-    if (distance > 0.1f)
-    {
-        // Normalize direction
-        direction = direction / distance;
-
-        // Check multiple points along the path
-        int steps = (int)(distance / 5.0f) + 1;  // Check every 5 pixels
-        for (int i = 0; i <= steps; ++i)
-        {
-            float t = (float)i / (float)steps;
-            sf::Vector2f check_pos = old_pos + direction * (distance * t);
-
-            if (LevelSystem::get_tile_at(check_pos) == LevelSystem::WALL)
-            {
-                // Hit a wall - destroy bullet
-                m_parent->set_alive(false);
-                return;
-            }
-        }
-    }
-
-    // No wall hit - move the bullet
-    m_parent->set_position(new_pos);
-}
-
-void BulletComponent::render()
-{
-    // Rendering is handled by ShapeComponent attached to the bullet entity
-}
-
-void BulletComponent::check_collision(const std::vector<std::shared_ptr<Entity>>& entities)
-{
-    sf::Vector2f bullet_pos = m_parent->get_position();
-
-    for (const auto& entity : entities)
-    {
-        // Don't collide with owner, dead entities, or entities marked for deletion
-        if (entity.get() == m_owner || !entity->is_alive() || entity->to_be_deleted())
-        {
-            continue;
-        }
-
-        // Friendly fire check - Don't let enemies damage other enemies
-        if (m_owner)
-        {
-            auto owner_enemy_shooting = m_owner->get_compatible_components<EnemyShootingComponent>();
-            bool owner_is_enemy = !owner_enemy_shooting.empty();
-
-            auto target_enemy_shooting = entity->get_compatible_components<EnemyShootingComponent>();
-            bool target_is_enemy = !target_enemy_shooting.empty();
-
-            if (owner_is_enemy && target_is_enemy)
-            {
-                continue;
-            }
-        }
-
-        sf::Vector2f entity_pos = entity->get_position();
-        sf::Vector2f diff = bullet_pos - entity_pos;
-        float distance = std::sqrt(diff.x * diff.x + diff.y * diff.y);
-
-        if (distance < 20.0f) // Entity hit radius
-        {
-            auto health_components = entity->get_compatible_components<HealthComponent>();
-            if (!health_components.empty() && health_components[0])
-            {
-                float health_before = health_components[0]->get_current_health();
-                health_components[0]->take_damage(m_damage);
-                float health_after = health_components[0]->get_current_health();
-
-                if (health_before > 0.0f && health_after <= 0.0f && m_on_kill_callback)
-                {
-                    m_on_kill_callback(bullet_pos);
-                }
-            }
-
-            // Destroy the bullet
-            m_parent->set_alive(false);  // Mark as dead (will be returned to pool)
-            return;
-        }
-    }
-}
-
 // Shooting component
 
 ShootingComponent::ShootingComponent(Entity* p, Scene* scene, int clip_size, float reload_time,
@@ -135,20 +15,17 @@ ShootingComponent::ShootingComponent(Entity* p, Scene* scene, int clip_size, flo
       m_reload_time(reload_time), m_reload_timer(0.0f),
       m_fire_rate(fire_rate), m_fire_cooldown(0.0f),
       m_bullet_speed(bullet_speed), m_bullet_damage(bullet_damage),
-      m_bullet_lifetime(3.0f), m_reloading(false), m_allowed_to_shoot(true),
+      m_bullet_lifetime(3.0f), m_hit_mask(LAYER_PLAYER | LAYER_ENEMY), m_reloading(false), m_allowed_to_shoot(true),
       m_bullet_color(sf::Color::White), m_bullet_size(5.0f)
 {
 }
 
 void ShootingComponent::update(const float& dt)
 {
-    // Clamp dt to prevent burst fire from huge dt values
-    float safe_dt = (dt > 0.1f) ? 0.016f : dt;
-
     // Update fire cooldown
     if (m_fire_cooldown > 0.0f)
     {
-        m_fire_cooldown -= safe_dt;
+        m_fire_cooldown -= dt;
         if (m_fire_cooldown < 0.0f)
         {
             m_fire_cooldown = 0.0f;
@@ -158,7 +35,7 @@ void ShootingComponent::update(const float& dt)
     // Update reload timer
     if (m_reloading)
     {
-        m_reload_timer += safe_dt;
+        m_reload_timer += dt;
 
         if (m_reload_timer >= m_reload_time)
         {
@@ -184,8 +61,8 @@ bool ShootingComponent::shoot(const sf::Vector2f& direction)
         return false;
     }
 
-    // Spawn bullet
-    spawn_bullet(direction);
+    // Queue the bullet - it is spawned by spawn_pending_bullets()
+    m_pending_shots.push_back(direction);
 
     // Consume ammo
     m_current_ammo--;
@@ -222,6 +99,15 @@ void ShootingComponent::reload()
     m_allowed_to_shoot = false;
 }
 
+void ShootingComponent::spawn_pending_bullets()
+{
+    for (const sf::Vector2f& direction : m_pending_shots)
+    {
+        spawn_bullet(direction);
+    }
+    m_pending_shots.clear();
+}
+
 float ShootingComponent::get_reload_progress() const
 {
     if (!m_reloading)
@@ -239,54 +125,24 @@ void ShootingComponent::spawn_bullet(const sf::Vector2f& direction)
         return;
     }
 
-    // Try to get bullet from pool (if scene is BasicLevelScene)
-    BasicLevelScene* levelScene = dynamic_cast<BasicLevelScene*>(m_scene);
-    std::shared_ptr<Entity> bullet;
-
-    if (levelScene)
-    {
-        // Get bullet from pool
-        bullet = levelScene->get_bullet_from_pool();
-    }
-    else
-    {
-        bullet = m_scene->make_entity();
-    }
-
-    // Position bullet at shooter's location
-    bullet->set_position(m_parent->get_position());
-    bullet->set_alive(true);
-
-    auto shape_components = bullet->get_compatible_components<ShapeComponent>();
-    if (!shape_components.empty() && shape_components[0])
-    {
-        auto& shape = shape_components[0]->get_shape();
-        if (auto* circle = dynamic_cast<sf::CircleShape*>(&shape))
-        {
-            circle->setRadius(m_bullet_size);
-            circle->setOrigin(m_bullet_size, m_bullet_size);
-        }
-        shape.setFillColor(m_bullet_color);
-    }
-    else
+    // Normalize direction
+    sf::Vector2f velocity = direction;
+    float length = std::sqrt(velocity.x * velocity.x + velocity.y * velocity.y);
+    if (length > 0.0f)
     {
-        auto shape = bullet->add_component<ShapeComponent>();
-        shape->set_shape<sf::CircleShape>(m_bullet_size);
-        shape->get_shape().setFillColor(m_bullet_color);
-        shape->get_shape().setOrigin(m_bullet_size, m_bullet_size);
+        velocity = velocity / length;
     }
 
-    // Remove old BulletComponents before adding new one
-    bullet->remove_components_by_type<BulletComponent>();
-
-    // Add fresh bullet component
-    bullet->add_component<BulletComponent>(
-        direction,
-        m_bullet_speed,
-        m_bullet_damage,
-        m_bullet_lifetime,
-        m_parent
-    );
+    ProjectileBuffer::Spawn bullet;
+    bullet.position = m_parent->get_position();
+    bullet.velocity = velocity * m_bullet_speed;
+    bullet.lifetime = m_bullet_lifetime;
+    bullet.damage = m_bullet_damage;
+    bullet.radius = m_bullet_size;
+    bullet.color = m_bullet_color;
+    bullet.hit_mask = m_hit_mask;
+    bullet.owner = m_parent->get_handle();
+    m_scene->get_projectiles().spawn(bullet);
 }
 
 
@@ -296,31 +152,30 @@ PlayerShootingComponent::PlayerShootingComponent(Entity* p, Scene* scene, int cl
 {
     set_bullet_color(sf::Color::Cyan);
     set_bullet_size(3.0f);
+    set_hit_mask(LAYER_ENEMY);
 }
 
 void PlayerShootingComponent::update(const float& dt)
 {
     ShootingComponent::update(dt);
 
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::R))
+    if (Input::is_key_pressed(params::getControls().at("Reload")))
     {
         reload();
     }
 
-    if (sf::Mouse::isButtonPressed(params::getMouseControls().at("Shoot")) || sf::Keyboard::isKeyPressed(params::getControls().at("BackupShoot")))
+    if (Input::is_button_pressed(params::getMouseControls().at("Shoot")) || Input::is_key_pressed(params::getControls().at("BackupShoot")))
     {
         sf::Vector2f direction = get_shooting_direction();
         shoot(direction);
     }
+
+    spawn_pending_bullets();
 }
 
 sf::Vector2f PlayerShootingComponent::get_shooting_direction() const
 {
-    sf::Vector2i mouse_pos = sf::Mouse::getPosition(Renderer::getWindow());
-
-    sf::Vector2f mouse_world_pos = Renderer::getWindow().mapPixelToCoords(mouse_pos, Renderer::getView());
-
-    sf::Vector2f direction = mouse_world_pos - m_parent->get_position();
+    sf::Vector2f direction = Input::get_pointer_position() - m_parent->get_position();
 
     float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
     if (length > 0.0f)
@@ -332,7 +187,7 @@ sf::Vector2f PlayerShootingComponent::get_shooting_direction() const
 }
 
 
-EnemyShootingComponent::EnemyShootingComponent(Entity* p, Scene* scene, Entity* target, int clip_size,
+EnemyShootingComponent::EnemyShootingComponent(Entity* p, Scene* scene, EntityHandle target, int clip_size,
                                                float reload_time, float fire_rate,
                                                float bullet_speed, float bullet_damage)
     : ShootingComponent(p, scene, clip_size, reload_time, fire_rate, bullet_speed, bullet_damage),
@@ -342,32 +197,34 @@ EnemyShootingComponent::EnemyShootingComponent(Entity* p, Scene* scene, Entity*
 {
     set_bullet_color(sf::Color(255, 100, 0));
     set_bullet_size(2.5f);
+    set_hit_mask(LAYER_PLAYER);
 
     // Override bullet damage
     m_bullet_damage = bullet_damage;
 
-    // Generate unique random delay per enemy
-    // Use entity pointer as seed to make each enemy different
-    std::random_device rd;
-    std::mt19937 gen(rd() + reinterpret_cast<uintptr_t>(p));
-    std::uniform_real_distribution<float> dis(m_random_delay_min, m_random_delay_max);
-    m_random_delay_timer = dis(gen);
+    // Each enemy draws from its own generator, seeded from the game's seed,
+    // so enemies can tick in parallel and a seeded run repeats exactly.
+    m_rng.seed(Random::next_seed());
+    generate_random_delay();
 }
 
 void EnemyShootingComponent::update(const float& dt)
+{
+    tick(dt);
+    spawn_pending_bullets();
+}
+
+void EnemyShootingComponent::tick(const float& dt)
 {
     if (this->m_parent->is_alive())
     {
-        // Clamp dt to prevent burst fire
-        float safe_dt = (dt > 0.1f) ? 0.016f : dt;
-
         // Update base shooting logic
-        ShootingComponent::update(safe_dt);
+        ShootingComponent::update(dt);
 
-        // Update random delay timer with clamped dt
+        // Update random delay timer
         if (m_random_delay_timer > 0.0f)
         {
-            m_random_delay_timer -= safe_dt;
+            m_random_delay_timer -= dt;
         }
 
         // Check if we should shoot at target
@@ -386,13 +243,14 @@ void EnemyShootingComponent::update(const float& dt)
 
 sf::Vector2f EnemyShootingComponent::get_shooting_direction() const
 {
-    if (!m_target)
+    Entity* target = m_parent->resolve(m_target);
+    if (!target)
     {
         return sf::Vector2f(0.0f, 0.0f);
     }
 
     // Calculate direction from enemy to target
-    sf::Vector2f direction = m_target->get_position() - m_parent->get_position();
+    sf::Vector2f direction = target->get_position() - m_parent->get_position();
 
     // Normalize
     float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
@@ -406,20 +264,21 @@ sf::Vector2f EnemyShootingComponent::get_shooting_direction() const
 
 sf::Vector2f EnemyShootingComponent::get_predictive_direction() const
 {
-    if (!m_target)
+    Entity* target = m_parent->resolve(m_target);
+    if (!target)
     {
         return sf::Vector2f(0.0f, 0.0f);
     }
 
     // Try to get target's physics component for velocity
-    auto target_physics = m_target->get_compatible_components<PhysicsComponent>();
+    PhysicsComponent *target_physics = target->get_component<PhysicsComponent>();
 
-    sf::Vector2f target_pos = m_target->get_position();
+    sf::Vector2f target_pos = target->get_position();
 
     // If target has physics, predict where they'll be
-    if (!target_physics.empty() && target_physics[0])
+    if (target_physics)
     {
-        sf::Vector2f target_velocity = target_physics[0]->get_velocity();
+        sf::Vector2f target_velocity = target_physics->get_velocity();
 
         // Calculate time for bullet to reach target
         sf::Vector2f to_target = target_pos - m_parent->get_position();
@@ -444,7 +303,8 @@ sf::Vector2f EnemyShootingComponent::get_predictive_direction() const
 bool EnemyShootingComponent::can_shoot_target()
 {
     // Don't shoot if target is dead or doesn't exist
-    if (!m_target || !m_target->is_alive() || !can_shoot())
+    Entity* target = m_parent->resolve(m_target);
+    if (!target || !target->is_alive() || !can_shoot())
     {
         return false;
     }
@@ -456,7 +316,7 @@ bool EnemyShootingComponent::can_shoot_target()
     }
 
     // Check if target is in range
-    sf::Vector2f to_target = m_target->get_position() - m_parent->get_position();
+    sf::Vector2f to_target = target->get_position() - m_parent->get_position();
     float distance = std::sqrt(to_target.x * to_target.x + to_target.y * to_target.y);
 
     if (distance > m_shooting_range)
@@ -470,12 +330,10 @@ bool EnemyShootingComponent::can_shoot_target()
         return false;
     }
 
-    // Add random chance - use unique generator per enemy
-    // Each enemy gets their own generator seeded with their pointer address
-    std::mt19937 gen(reinterpret_cast<uintptr_t>(m_parent) + static_cast<unsigned>(m_random_delay_timer * 1000.0f));
+    // Add random chance
     std::uniform_real_distribution<float> dis(0.0f, 1.0f);
 
-    if (dis(gen) > m_shoot_chance)
+    if (dis(m_rng) > m_shoot_chance)
     {
         return false;
     }
@@ -485,13 +343,14 @@ bool EnemyShootingComponent::can_shoot_target()
 
 bool EnemyShootingComponent::has_line_of_sight() const
 {
-    if (!m_target)
+    Entity* target = m_parent->resolve(m_target);
+    if (!target)
     {
         return false;
     }
 
     sf::Vector2f start = m_parent->get_position();
-    sf::Vector2f end = m_target->get_position();
+    sf::Vector2f end = target->get_position();
 
     // Calculate direction and distance
     sf::Vector2f direction = end - start;
@@ -528,10 +387,7 @@ bool EnemyShootingComponent::has_line_of_sight() const
 
 void EnemyShootingComponent::generate_random_delay()
 {
-    // Use unique generator per enemy - seeded with entity pointer
-    std::random_device rd;
-    std::mt19937 gen(rd() + reinterpret_cast<uintptr_t>(m_parent));
     std::uniform_real_distribution<float> dis(m_random_delay_min, m_random_delay_max);
 
-    m_random_delay_timer = dis(gen);
+    m_random_delay_timer = dis(m_rng);
 }
\ No newline at end of file
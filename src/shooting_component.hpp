@@ -12,38 +12,11 @@
 #include <memory>
 #include <vector>
 #include <functional>
+#include <random>
 
 // Forward declarations
-class BulletComponent;
 class Scene;
 
-/// Represents a single bullet entity with physics and graphics
-class BulletComponent : public Component
-{
-public:
-    BulletComponent(Entity* p, const sf::Vector2f& direction, float speed, float damage, float lifetime, Entity* owner = nullptr);
-    void update(const float& dt) override;
-    void render() override;
-
-    void check_collision(const std::vector<std::shared_ptr<Entity>>& entities);
-
-    // Callback for when this bullet kills an enemy
-    void set_on_kill_callback(std::function<void(sf::Vector2f)> callback) { m_on_kill_callback = callback; }
-
-    float get_damage() const { return m_damage; }
-    bool is_expired() const { return m_lifetime_remaining <= 0.0f; }
-
-private:
-    sf::Vector2f m_direction;
-    sf::Vector2f m_velocity;
-    float m_speed;
-    float m_damage;
-    float m_lifetime_remaining;
-    float m_max_lifetime;
-    Entity* m_owner;  // Who shot this bullet (don't collide with them)
-    std::function<void(sf::Vector2f)> m_on_kill_callback;  // Called when bullet kills something
-};
-
 /// Base shooting component - handles shooting logic, ammo, and reloading
 class ShootingComponent : public Component
 {
@@ -53,8 +26,12 @@ public:
     void update(const float& dt) override;
     void render() override {}
 
+    // Queues a shot if allowed. Queued shots are spawned by spawn_pending_bullets().
     bool shoot(const sf::Vector2f& direction);
 
+    // Spawns queued shots into the scene's projectiles, so main thread only.
+    void spawn_pending_bullets();
+
     bool can_shoot() const;
 
     void reload();
@@ -69,6 +46,9 @@ public:
     void set_bullet_color(const sf::Color& color) { m_bullet_color = color; }
     void set_bullet_size(float size) { m_bullet_size = size; }
 
+    // Layers this component's bullets damage
+    void set_hit_mask(LayerMask mask) { m_hit_mask = mask; }
+
 protected:
     // Scene reference for spawning bullets
     Scene* m_scene;
@@ -84,6 +64,9 @@ protected:
     float m_bullet_damage;
     float m_bullet_lifetime;
 
+    // Layers the bullets damage
+    LayerMask m_hit_mask;
+
     // Bullet appearance
     sf::Color m_bullet_color;
     float m_bullet_size;
@@ -92,7 +75,10 @@ protected:
     bool m_reloading;
     bool m_allowed_to_shoot;
 
-    // Helper to create and spawn a bullet
+    // Shots fired since the last spawn_pending_bullets()
+    std::vector<sf::Vector2f> m_pending_shots;
+
+    // Helper to spawn a bullet
     void spawn_bullet(const sf::Vector2f& direction);
 };
 
@@ -100,6 +86,9 @@ protected:
 class PlayerShootingComponent : public ShootingComponent
 {
 public:
+    using base_component = ShootingComponent;
+    static constexpr PhaseMask phases = phase_bit(PHASE_INPUT);   // reads the mouse and keyboard
+
     PlayerShootingComponent(Entity* p, Scene* scene, int clip_size = 10, float reload_time = 1.5f,
                            float fire_rate = 5.0f, float bullet_speed = 400.0f, float bullet_damage = 10.0f);
 
@@ -114,11 +103,17 @@ private:
 class EnemyShootingComponent : public ShootingComponent
 {
 public:
-    EnemyShootingComponent(Entity* p, Scene* scene, Entity* target, int clip_size = 8, float reload_time = 2.0f,
+    using base_component = ShootingComponent;
+
+    EnemyShootingComponent(Entity* p, Scene* scene, EntityHandle target, int clip_size = 8, float reload_time = 2.0f,
                           float fire_rate = 2.0f, float bullet_speed = 300.0f, float bullet_damage = 5.0f);
 
     void update(const float& dt) override;
 
+    // Timers, aiming and the decision to shoot. Only touches this component
+    // and reads positions, so it is safe to run in parallel across enemies.
+    void tick(const float& dt);
+
     // Set shooting range - enemy won't shoot if target is beyond this distance
     void set_shooting_range(float range) { m_shooting_range = range; }
 
@@ -133,7 +128,7 @@ public:
     }
 
 private:
-    Entity* m_target;
+    EntityHandle m_target;
     float m_shooting_range;
     bool m_predictive;
 
@@ -142,6 +137,7 @@ private:
     float m_random_delay_min;       // Minimum delay between shot attempts
     float m_random_delay_max;       // Maximum delay between shot attempts
     float m_random_delay_timer;     // Current delay countdown
+    std::mt19937 m_rng;             // This enemy's own generator
 
     // Calculate shooting direction towards target
     sf::Vector2f get_shooting_direction() const;
@@ -0,0 +1,154 @@
+#include "systems.hpp"
+#include "level_system.hpp"
+#include <cmath>
+
+/// <summary>
+/// Declares the EnemySteeringSystem's access.
+/// Resolves and reads the target's position and writes enemy bodies.
+/// </summary>
+EnemySteeringSystem::EnemySteeringSystem()
+{
+    drives<EnemyControlComponent>();
+    reads_resource(RESOURCE_TRANSFORM | RESOURCE_ENTITIES);
+    writes_resource(RESOURCE_PHYSICS);
+}
+
+/// <summary>
+/// Picks every alive enemy's direction in parallel, then moves their
+/// bodies and applies their forces one at a time, as Box2D is not thread safe.
+/// </summary>
+/// <param name="entities">The scene's entities.</param>
+/// <param name="dt">Delta Time - linked to frame rate.</param>
+void EnemySteeringSystem::run(EntityManager &entities, const float &dt)
+{
+    entities.query(m_enemies);
+    parallel_each(m_enemies, [](EnemyControlComponent &enemy) {
+        enemy.choose_direction();
+    });
+
+    for (EnemyControlComponent *enemy : m_enemies)
+    {
+        enemy->apply_steering();
+        enemy->apply_forces();
+    }
+}
+
+/// <summary>
+/// Declares the EnemyShootingSystem's access.
+/// Resolves the target and reads its position and velocity, and the level grid.
+/// </summary>
+EnemyShootingSystem::EnemyShootingSystem()
+{
+    drives<EnemyShootingComponent>();
+    reads_resource(RESOURCE_TRANSFORM | RESOURCE_PHYSICS | RESOURCE_LEVEL | RESOURCE_ENTITIES);
+}
+
+/// <summary>
+/// Ticks every alive enemy's shooting in parallel.
+/// </summary>
+/// <param name="entities">The scene's entities.</param>
+/// <param name="dt">Delta Time - linked to frame rate.</param>
+void EnemyShootingSystem::run(EntityManager &entities, const float &dt)
+{
+    entities.query(m_shooters);
+    parallel_each(m_shooters, [&dt](EnemyShootingComponent &shooter) {
+        shooter.tick(dt);
+    });
+}
+
+/// <summary>
+/// Declares the ProjectileSystem's access.
+/// </summary>
+/// <param name="projectiles">The scene's projectiles.</param>
+ProjectileSystem::ProjectileSystem(ProjectileBuffer *projectiles) : m_projectiles(projectiles)
+{
+    reads_resource(RESOURCE_LEVEL);
+    writes_resource(RESOURCE_PROJECTILES);
+}
+
+/// <summary>
+/// Moves every projectile, then checks the path it took for walls, in parallel.
+/// </summary>
+/// <param name="entities">The scene's entities.</param>
+/// <param name="dt">Delta Time - linked to frame rate.</param>
+void ProjectileSystem::run(EntityManager &entities, const float &dt)
+{
+    ProjectileBuffer &projectiles = *m_projectiles;
+    ThreadPool::shared().parallel_for(projectiles.size(), 256,
+        [&projectiles, &dt](std::size_t begin, std::size_t end) {
+            projectiles.integrate(begin, end, dt);
+
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                if (projectiles.is_dead(i))
+                {
+                    continue;
+                }
+
+                // Check every 5 pixels along the path so fast shots cannot skip a wall
+                const sf::Vector2f from = projectiles.get_previous_position(i);
+                const sf::Vector2f path = projectiles.get_position(i) - from;
+                const float distance = std::sqrt(path.x * path.x + path.y * path.y);
+                const int steps = static_cast<int>(distance / 5.0f) + 1;
+                for (int step = 0; step <= steps; ++step)
+                {
+                    const sf::Vector2f check_pos = from + path * (static_cast<float>(step) / steps);
+                    if (LevelSystem::get_tile_at(check_pos) == LevelSystem::WALL)
+                    {
+                        projectiles.kill(i);
+                        break;
+                    }
+                }
+            }
+        });
+}
+
+/// <summary>
+/// Declares the EnemyPhysicsSyncSystem's access.
+/// </summary>
+EnemyPhysicsSyncSystem::EnemyPhysicsSyncSystem()
+{
+    runs_in(PHASE_POST_PHYSICS);
+    writes<EnemyControlComponent>();
+    reads_resource(RESOURCE_PHYSICS);
+    writes_resource(RESOURCE_TRANSFORM);
+}
+
+/// <summary>
+/// Syncs every alive enemy's entity with its body.
+/// </summary>
+/// <param name="entities">The scene's entities.</param>
+/// <param name="dt">Delta Time - linked to frame rate.</param>
+void EnemyPhysicsSyncSystem::run(EntityManager &entities, const float &dt)
+{
+    entities.query(m_enemies);
+    for (EnemyControlComponent *enemy : m_enemies)
+    {
+        enemy->sync_transform();
+    }
+}
+
+/// <summary>
+/// Declares the BulletSpawnSystem's access.
+/// Reads the shooters' positions and appends to the projectiles.
+/// </summary>
+BulletSpawnSystem::BulletSpawnSystem()
+{
+    writes<EnemyShootingComponent>();
+    reads_resource(RESOURCE_TRANSFORM);
+    writes_resource(RESOURCE_PROJECTILES);
+}
+
+/// <summary>
+/// Spawns every queued enemy shot.
+/// </summary>
+/// <param name="entities">The scene's entities.</param>
+/// <param name="dt">Delta Time - linked to frame rate.</param>
+void BulletSpawnSystem::run(EntityManager &entities, const float &dt)
+{
+    entities.query(m_shooters);
+    for (EnemyShootingComponent *shooter : m_shooters)
+    {
+        shooter->spawn_pending_bullets();
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "system.hpp"
+#include "control_components.hpp"
+#include "shooting_component.hpp"
+#include <vector>
+
+// Game systems run by the Scene's Scheduler. Each one takes over a
+// component type from Entity::update and runs it over every entity at once.
+
+// Steers every enemy. Directions are picked in parallel; the Box2D calls
+// that move the bodies are then made on the running thread alone.
+class EnemySteeringSystem : public System
+{
+public:
+    EnemySteeringSystem();
+    void run(EntityManager &entities, const float &dt) override;
+private:
+    std::vector<EnemyControlComponent *> m_enemies;
+};
+
+// Ticks the enemies' shooting timers and aims. Shots are queued on the
+// component and spawned later by BulletSpawnSystem.
+class EnemyShootingSystem : public System
+{
+public:
+    EnemyShootingSystem();
+    void run(EntityManager &entities, const float &dt) override;
+private:
+    std::vector<EnemyShootingComponent *> m_shooters;
+};
+
+// Moves the scene's projectiles and kills the ones that hit a wall.
+// Each projectile is only written by the chunk it is in, so the buffer is
+// integrated in parallel.
+class ProjectileSystem : public System
+{
+public:
+    explicit ProjectileSystem(ProjectileBuffer *projectiles);
+    void run(EntityManager &entities, const float &dt) override;
+private:
+    ProjectileBuffer *m_projectiles;
+};
+
+// Copies the enemies' body positions back onto their entities after the
+// physics step.
+class EnemyPhysicsSyncSystem : public System
+{
+public:
+    EnemyPhysicsSyncSystem();
+    void run(EntityManager &entities, const float &dt) override;
+private:
+    std::vector<EnemyControlComponent *> m_enemies;
+};
+
+// Spawns the shots queued by EnemyShootingSystem into the scene's
+// projectiles.
+class BulletSpawnSystem : public System
+{
+public:
+    BulletSpawnSystem();
+    void run(EntityManager &entities, const float &dt) override;
+private:
+    std::vector<EnemyShootingComponent *> m_shooters;
+};
@@ -0,0 +1,499 @@
+#include "level_streamer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+
+void LevelStreamer::write(const std::string &file_path, int width, int height, sf::Vector2i start,
+                          const std::function<LevelSystem::Tile(int x, int y)> &tile_at, int chunk_size)
+{
+    if (width <= 0 || height <= 0 || chunk_size <= 0)
+    {
+        throw std::string("World has no tiles: " + file_path);
+    }
+
+    std::ofstream file(file_path, std::ios::binary);
+    if (!file.good())
+    {
+        throw std::string("Couldn't write world file: " + file_path);
+    }
+
+    Header header;
+    std::memcpy(header.magic, file_magic, sizeof(header.magic));
+    header.version = version;
+    header.width = width;
+    header.height = height;
+    header.chunk_size = chunk_size;
+    header.start_x = start.x;
+    header.start_y = start.y;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    const int chunks_x = (width + chunk_size - 1) / chunk_size;
+    const int chunks_y = (height + chunk_size - 1) / chunk_size;
+    std::vector<std::uint64_t> offsets(chunks_x * chunks_y + 1, 0);
+    file.write(reinterpret_cast<const char *>(offsets.data()), offsets.size() * sizeof(std::uint64_t));
+
+    std::vector<std::uint8_t> runs;
+    for (int chunk_y = 0; chunk_y < chunks_y; ++chunk_y)
+    {
+        for (int chunk_x = 0; chunk_x < chunks_x; ++chunk_x)
+        {
+            offsets[chunk_y * chunks_x + chunk_x] = static_cast<std::uint64_t>(file.tellp());
+
+            runs.clear();
+            const int end_x = std::min((chunk_x + 1) * chunk_size, width);
+            const int end_y = std::min((chunk_y + 1) * chunk_size, height);
+            for (int y = chunk_y * chunk_size; y < end_y; ++y)
+            {
+                for (int x = chunk_x * chunk_size; x < end_x; ++x)
+                {
+                    const std::uint8_t tile = static_cast<std::uint8_t>(tile_at(x, y));
+                    if (!runs.empty() && runs.back() == tile && runs[runs.size() - 2] < 255)
+                    {
+                        ++runs[runs.size() - 2];
+                    }
+                    else
+                    {
+                        runs.push_back(1);
+                        runs.push_back(tile);
+                    }
+                }
+            }
+            file.write(reinterpret_cast<const char *>(runs.data()), runs.size());
+        }
+    }
+
+    offsets.back() = static_cast<std::uint64_t>(file.tellp());
+    file.seekp(sizeof(header));
+    file.write(reinterpret_cast<const char *>(offsets.data()), offsets.size() * sizeof(std::uint64_t));
+    if (!file.good())
+    {
+        throw std::string("Couldn't write world file: " + file_path);
+    }
+}
+
+LevelStreamer::LevelStreamer(const std::string &file_path, float tile_size, std::size_t chunk_budget) :
+    m_tile_size(tile_size), m_chunk_budget(std::max<std::size_t>(chunk_budget, 1))
+{
+    m_file.open(file_path, std::ios::binary);
+    if (!m_file.good())
+    {
+        throw std::string("Couldn't open world file: " + file_path);
+    }
+
+    m_file.read(reinterpret_cast<char *>(&m_header), sizeof(m_header));
+    if (!m_file.good() || std::memcmp(m_header.magic, file_magic, sizeof(file_magic)) != 0 || m_header.version != version)
+    {
+        throw std::string("Not a world file: " + file_path);
+    }
+    if (m_header.width <= 0 || m_header.height <= 0 || m_header.chunk_size <= 0)
+    {
+        throw std::string("World has no tiles: " + file_path);
+    }
+
+    m_chunks_x = (m_header.width + m_header.chunk_size - 1) / m_header.chunk_size;
+    m_chunks_y = (m_header.height + m_header.chunk_size - 1) / m_header.chunk_size;
+    const std::size_t chunk_count = static_cast<std::size_t>(m_chunks_x) * m_chunks_y;
+
+    m_offsets.resize(chunk_count + 1);
+    m_file.read(reinterpret_cast<char *>(m_offsets.data()), m_offsets.size() * sizeof(std::uint64_t));
+    m_file.seekg(0, std::ios::end);
+    const std::uint64_t file_size = static_cast<std::uint64_t>(m_file.tellg());
+    for (std::size_t i = 0; i < chunk_count; ++i)
+    {
+        if (m_offsets[i] > m_offsets[i + 1] || m_offsets[i + 1] > file_size)
+        {
+            throw std::string("Mismatch in world chunk offsets: " + file_path);
+        }
+    }
+
+    m_slots.resize(chunk_count);
+    m_requested.assign(chunk_count, false);
+    m_last_wanted.assign(chunk_count, 0);
+    m_loader = std::thread(&LevelStreamer::loader_loop, this);
+}
+
+LevelStreamer::~LevelStreamer()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    m_loader.join();
+}
+
+void LevelStreamer::set_callbacks(ChunkCallback on_loaded, ChunkCallback on_unloaded)
+{
+    m_on_loaded = std::move(on_loaded);
+    m_on_unloaded = std::move(on_unloaded);
+}
+
+void LevelStreamer::update(const sf::FloatRect &bounds)
+{
+    ++m_update;
+
+    // The chunks under bounds and a ring of chunks around them, nearest first.
+    const float chunk_pixels = m_tile_size * m_header.chunk_size;
+    const int min_x = std::max(0, static_cast<int>(std::floor(bounds.left / chunk_pixels)) - 1);
+    const int min_y = std::max(0, static_cast<int>(std::floor(bounds.top / chunk_pixels)) - 1);
+    const int max_x = std::min(m_chunks_x - 1, static_cast<int>(std::floor((bounds.left + bounds.width) / chunk_pixels)) + 1);
+    const int max_y = std::min(m_chunks_y - 1, static_cast<int>(std::floor((bounds.top + bounds.height) / chunk_pixels)) + 1);
+
+    m_wanted.clear();
+    for (int y = min_y; y <= max_y; ++y)
+    {
+        for (int x = min_x; x <= max_x; ++x)
+        {
+            m_wanted.push_back(y * m_chunks_x + x);
+        }
+    }
+
+    const sf::Vector2f centre(bounds.left + bounds.width / 2.0f, bounds.top + bounds.height / 2.0f);
+    auto distance = [&](int index)
+    {
+        const float dx = ((index % m_chunks_x) + 0.5f) * chunk_pixels - centre.x;
+        const float dy = ((index / m_chunks_x) + 0.5f) * chunk_pixels - centre.y;
+        return dx * dx + dy * dy;
+    };
+    std::sort(m_wanted.begin(), m_wanted.end(), [&](int a, int b) { return distance(a) < distance(b); });
+    if (m_wanted.size() > m_chunk_budget)
+    {
+        m_wanted.resize(m_chunk_budget);
+    }
+
+    std::vector<int> requests;
+    for (int index : m_wanted)
+    {
+        m_last_wanted[index] = m_update;
+        if (!m_slots[index] && !m_requested[index])
+        {
+            m_requested[index] = true;
+            ++m_pending;
+            requests.push_back(index);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Requests the camera has moved away from before the loader got to them.
+        for (auto it = m_requests.begin(); it != m_requests.end();)
+        {
+            if (m_last_wanted[*it] != m_update)
+            {
+                m_requested[*it] = false;
+                --m_pending;
+                it = m_requests.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        m_requests.insert(m_requests.end(), requests.begin(), requests.end());
+    }
+    m_wake.notify_one();
+
+    add_loaded();
+    // Make room for the chunks still on their way.
+    evict(m_chunk_budget > m_pending ? m_chunk_budget - m_pending : 0);
+}
+
+void LevelStreamer::wait_for_requests()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_finished.wait(lock, [this] { return m_loaded.size() >= m_pending; });
+    }
+    add_loaded();
+}
+
+void LevelStreamer::add_loaded()
+{
+    std::vector<std::unique_ptr<Chunk>> loaded;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        loaded.swap(m_loaded);
+    }
+
+    for (std::unique_ptr<Chunk> &chunk : loaded)
+    {
+        const int index = chunk->index;
+        m_requested[index] = false;
+        --m_pending;
+
+        if (m_resident.size() >= m_chunk_budget)
+        {
+            evict(m_chunk_budget - 1);
+        }
+        if (m_resident.size() >= m_chunk_budget)
+        {
+            continue;   // every resident chunk is still wanted
+        }
+
+        m_resident.push_back(index);
+        m_slots[index] = std::move(chunk);
+        if (m_on_loaded)
+        {
+            m_on_loaded(*m_slots[index]);
+        }
+    }
+}
+
+void LevelStreamer::evict(std::size_t keep)
+{
+    while (m_resident.size() > keep)
+    {
+        // The chunk wanted longest ago, as long as it is not wanted now.
+        auto oldest = std::min_element(m_resident.begin(), m_resident.end(), [this](int a, int b)
+        {
+            return m_last_wanted[a] < m_last_wanted[b];
+        });
+        if (m_last_wanted[*oldest] == m_update)
+        {
+            return;
+        }
+
+        const int index = *oldest;
+        *oldest = m_resident.back();
+        m_resident.pop_back();
+        if (m_on_unloaded)
+        {
+            m_on_unloaded(*m_slots[index]);
+        }
+        m_slots[index].reset();
+    }
+}
+
+void LevelStreamer::loader_loop()
+{
+    while (true)
+    {
+        int index;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stopping || !m_requests.empty(); });
+            if (m_stopping)
+            {
+                return;
+            }
+            index = m_requests.front();
+            m_requests.pop_front();
+        }
+
+        std::unique_ptr<Chunk> chunk = read_chunk(index);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_loaded.push_back(std::move(chunk));
+        }
+        m_finished.notify_all();
+    }
+}
+
+std::unique_ptr<LevelStreamer::Chunk> LevelStreamer::read_chunk(int index)
+{
+    std::unique_ptr<Chunk> chunk = std::make_unique<Chunk>();
+    chunk->index = index;
+    const sf::IntRect area = get_chunk_area(index);
+    chunk->origin = sf::Vector2i(area.left, area.top);
+    chunk->size = sf::Vector2i(area.width, area.height);
+    if (!read_tiles(index, chunk->tiles))
+    {
+        // Better an empty chunk than a half-read one.
+        std::cerr << "Mismatch in world chunk " << index << ", loading it empty" << std::endl;
+    }
+
+    // Traced with a ring of its neighbours' tiles around it, so an outline
+    // that carries on into a neighbour is cut at the seam, with the ghost
+    // corners the neighbour's chain will have, instead of closed along it.
+    const int grid_width = chunk->size.x + 2;
+    const int grid_height = chunk->size.y + 2;
+    std::vector<LevelSystem::Tile> grid(static_cast<std::size_t>(grid_width) * grid_height, LevelSystem::EMPTY);
+    for (int y = 0; y < chunk->size.y; ++y)
+    {
+        std::copy_n(chunk->tiles.begin() + y * chunk->size.x, chunk->size.x, grid.begin() + (y + 1) * grid_width + 1);
+    }
+
+    std::map<int, std::vector<LevelSystem::Tile>> neighbours;
+    for (int y = 0; y < grid_height; ++y)
+    {
+        for (int x = 0; x < grid_width; ++x)
+        {
+            const bool ring = x == 0 || y == 0 || x == grid_width - 1 || y == grid_height - 1;
+            const sf::Vector2i pos = chunk->origin + sf::Vector2i(x - 1, y - 1);
+            if (!ring || pos.x < 0 || pos.y < 0 || pos.x >= m_header.width || pos.y >= m_header.height)
+            {
+                continue;
+            }
+
+            const int neighbour = (pos.y / m_header.chunk_size) * m_chunks_x + pos.x / m_header.chunk_size;
+            auto found = neighbours.find(neighbour);
+            if (found == neighbours.end())
+            {
+                found = neighbours.emplace(neighbour, std::vector<LevelSystem::Tile>()).first;
+                read_tiles(neighbour, found->second);
+            }
+
+            const sf::IntRect neighbour_area = get_chunk_area(neighbour);
+            grid[y * grid_width + x] = found->second[(pos.y - neighbour_area.top) * neighbour_area.width + pos.x - neighbour_area.left];
+        }
+    }
+
+    chunk->chains = LevelSystem::trace_chains(grid.data(), grid_width, grid_height, LevelSystem::WALL,
+                                              sf::IntRect(1, 1, chunk->size.x, chunk->size.y));
+    for (LevelSystem::Chain &chain : chunk->chains)
+    {
+        for (sf::Vector2i &corner : chain.points)
+        {
+            corner += chunk->origin - sf::Vector2i(1, 1);
+        }
+    }
+    return chunk;
+}
+
+sf::IntRect LevelStreamer::get_chunk_area(int index) const
+{
+    const sf::Vector2i origin = sf::Vector2i(index % m_chunks_x, index / m_chunks_x) * m_header.chunk_size;
+    return sf::IntRect(origin.x, origin.y, std::min(m_header.chunk_size, m_header.width - origin.x),
+                       std::min(m_header.chunk_size, m_header.height - origin.y));
+}
+
+bool LevelStreamer::read_tiles(int index, std::vector<LevelSystem::Tile> &tiles)
+{
+    const sf::IntRect area = get_chunk_area(index);
+    const std::size_t tile_count = static_cast<std::size_t>(area.width) * area.height;
+    tiles.clear();
+    tiles.reserve(tile_count);
+
+    std::vector<std::uint8_t> runs(m_offsets[index + 1] - m_offsets[index]);
+    m_file.clear();
+    m_file.seekg(m_offsets[index]);
+    m_file.read(reinterpret_cast<char *>(runs.data()), runs.size());
+
+    bool valid = m_file.good() && runs.size() % 2 == 0;
+    for (std::size_t i = 0; valid && i < runs.size(); i += 2)
+    {
+        const std::uint8_t tile = runs[i + 1];
+        valid = tile <= LevelSystem::WAYPOINT && tiles.size() + runs[i] <= tile_count;
+        if (valid)
+        {
+            tiles.insert(tiles.end(), runs[i], static_cast<LevelSystem::Tile>(tile));
+        }
+    }
+    if (!valid || tiles.size() != tile_count)
+    {
+        tiles.assign(tile_count, LevelSystem::EMPTY);
+        return false;
+    }
+    return true;
+}
+
+LevelStreamer::Chunk *LevelStreamer::chunk_at(sf::Vector2i pos) const
+{
+    if ((pos.x >= m_header.width || pos.y >= m_header.height) || (pos.x < 0 || pos.y < 0))
+    {
+        return nullptr;
+    }
+    return m_slots[(pos.y / m_header.chunk_size) * m_chunks_x + pos.x / m_header.chunk_size].get();
+}
+
+LevelSystem::Tile LevelStreamer::get_tile(sf::Vector2i pos) const
+{
+    const Chunk *chunk = chunk_at(pos);
+    if (!chunk)
+    {
+        return LevelSystem::EMPTY;
+    }
+
+    const sf::Vector2i local = pos - chunk->origin;
+    return chunk->tiles[local.y * chunk->size.x + local.x];
+}
+
+void LevelStreamer::set_tile(sf::Vector2i pos, LevelSystem::Tile t)
+{
+    Chunk *chunk = chunk_at(pos);
+    if (!chunk)
+    {
+        throw std::out_of_range("Tile position is outside the loaded chunks.");
+    }
+
+    const sf::Vector2i local = pos - chunk->origin;
+    LevelSystem::Tile &tile = chunk->tiles[local.y * chunk->size.x + local.x];
+    if (tile != t)
+    {
+        tile = t;
+        chunk->dirty = true;
+    }
+}
+
+void LevelStreamer::find_tiles(LevelSystem::Tile t, std::vector<sf::Vector2i> &out) const
+{
+    for (int index : m_resident)
+    {
+        const Chunk &chunk = *m_slots[index];
+        for (std::size_t i = 0; i < chunk.tiles.size(); ++i)
+        {
+            if (chunk.tiles[i] == t)
+            {
+                out.push_back(chunk.origin + sf::Vector2i(static_cast<int>(i) % chunk.size.x, static_cast<int>(i) / chunk.size.x));
+            }
+        }
+    }
+}
+
+void LevelStreamer::get_visible_chunks(const sf::FloatRect &bounds, std::vector<const sf::VertexArray *> &out)
+{
+    for (int index : m_resident)
+    {
+        Chunk &chunk = *m_slots[index];
+        const sf::FloatRect area(sf::Vector2f(chunk.origin) * m_tile_size, sf::Vector2f(chunk.size) * m_tile_size);
+        if (!area.intersects(bounds))
+        {
+            continue;
+        }
+
+        if (chunk.dirty)
+        {
+            build_vertices(chunk);
+        }
+        if (chunk.vertices.getVertexCount() > 0)
+        {
+            out.push_back(&chunk.vertices);
+        }
+    }
+}
+
+void LevelStreamer::set_all_dirty()
+{
+    for (int index : m_resident)
+    {
+        m_slots[index]->dirty = true;
+    }
+}
+
+void LevelStreamer::build_vertices(Chunk &chunk) const
+{
+    chunk.vertices.clear();
+    chunk.dirty = false;
+
+    for (int y = 0; y < chunk.size.y; ++y)
+    {
+        for (int x = 0; x < chunk.size.x; ++x)
+        {
+            const sf::Color color = LevelSystem::get_color(chunk.tiles[y * chunk.size.x + x]);
+            if (color.a == 0)
+            {
+                continue;   // EMPTY and other transparent tiles add nothing
+            }
+
+            const sf::Vector2f pos = sf::Vector2f(chunk.origin + sf::Vector2i(x, y)) * m_tile_size;
+            chunk.vertices.append(sf::Vertex(pos, color));
+            chunk.vertices.append(sf::Vertex({pos.x + m_tile_size, pos.y}, color));
+            chunk.vertices.append(sf::Vertex({pos.x + m_tile_size, pos.y + m_tile_size}, color));
+            chunk.vertices.append(sf::Vertex({pos.x, pos.y + m_tile_size}, color));
+        }
+    }
+}
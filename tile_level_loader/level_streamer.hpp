@@ -0,0 +1,139 @@
+#pragma once
+
+#include "level_system.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// LevelStreamer
+// Pages the chunks of a world file in and out around the camera, so a
+// world can be far larger than what fits in memory at once. A loader
+// thread reads and decodes the chunks asked for and traces their wall
+// outlines, reading the tiles just across their edges too so outlines
+// that run on into a neighbour are cut at the seam; the main thread adds
+// finished chunks in update() and evicts the least recently wanted ones
+// once more than the chunk budget are resident. Tiles outside the
+// resident chunks read as EMPTY.
+//
+// A world file is a Header, then chunks_x * chunks_y + 1 byte offsets
+// (uint64) from the start of the file, chunk i's data running from offset
+// i to offset i + 1. Chunks go row by row; each is its tiles, row by row,
+// as run-length pairs of (count, tile) bytes. Everything is in the byte
+// order of the machine that wrote it.
+class LevelStreamer
+{
+public:
+    struct Header
+    {
+        char magic[4];
+        std::uint32_t version;
+        std::int32_t width;         // in tiles
+        std::int32_t height;
+        std::int32_t chunk_size;    // tiles per side of a chunk
+        std::int32_t start_x;       // start tile
+        std::int32_t start_y;
+    };
+
+    // A resident chunk. Chunks at the right and bottom edges of the world
+    // may be narrower or shorter than chunk_size.
+    struct Chunk
+    {
+        int index;                      // chunk_y * chunks_x + chunk_x
+        sf::Vector2i origin;            // its top left tile
+        sf::Vector2i size;              // in tiles
+        std::vector<LevelSystem::Tile> tiles;
+        // Its walls' outlines in world tile corners, from LevelSystem::trace_chains.
+        // One that crosses into a neighbour is an open chain up to the seam, so
+        // neighbours' chains meet end to end with no edge between them.
+        std::vector<LevelSystem::Chain> chains;
+        sf::VertexArray vertices{sf::Quads};
+        bool dirty = true;              // vertices need rebuilding
+    };
+
+    using ChunkCallback = std::function<void(const Chunk &)>;
+
+    static constexpr char file_magic[4] = {'C', 'Z', 'W', 'D'};
+    static constexpr std::uint32_t version = 1;
+    static constexpr int default_chunk_size = 64;
+
+    // Writes a world, asking tile_at for each tile a chunk at a time, so
+    // the whole world never has to be in memory.
+    static void write(const std::string &file_path, int width, int height, sf::Vector2i start,
+                      const std::function<LevelSystem::Tile(int x, int y)> &tile_at,
+                      int chunk_size = default_chunk_size);
+
+    // Opens a world. Nothing is loaded until the first update().
+    LevelStreamer(const std::string &file_path, float tile_size, std::size_t chunk_budget);
+    ~LevelStreamer();
+
+    LevelStreamer(const LevelStreamer &) = delete;
+    LevelStreamer &operator=(const LevelStreamer &) = delete;
+
+    // Called on the main thread as chunks are added and before they are evicted.
+    void set_callbacks(ChunkCallback on_loaded, ChunkCallback on_unloaded);
+
+    // Asks for the chunks within a chunk of bounds, nearest first, adds
+    // the chunks the loader has finished and evicts over the budget.
+    void update(const sf::FloatRect &bounds);
+    // Blocks until every chunk asked for has been added.
+    void wait_for_requests();
+
+    LevelSystem::Tile get_tile(sf::Vector2i pos) const;
+    // Changes a resident tile. The change is lost if its chunk is evicted.
+    void set_tile(sf::Vector2i pos, LevelSystem::Tile t);
+    void find_tiles(LevelSystem::Tile t, std::vector<sf::Vector2i> &out) const;
+    // Collects the resident chunks that overlap bounds, building any that changed.
+    void get_visible_chunks(const sf::FloatRect &bounds, std::vector<const sf::VertexArray *> &out);
+    // Marks every resident chunk's vertices for rebuilding, e.g. after a colour changes.
+    void set_all_dirty();
+
+    const Header &get_header() const { return m_header; }
+    std::size_t get_chunk_budget() const { return m_chunk_budget; }
+    std::size_t get_resident_count() const { return m_resident.size(); }
+    std::size_t get_pending_count() const { return m_pending; }
+
+private:
+    Header m_header;
+    float m_tile_size;
+    std::size_t m_chunk_budget;
+    int m_chunks_x;
+    int m_chunks_y;
+    std::vector<std::uint64_t> m_offsets;
+
+    // Main thread only. Slots are indexed by chunk and empty unless resident.
+    std::vector<std::unique_ptr<Chunk>> m_slots;
+    std::vector<int> m_resident;
+    std::vector<bool> m_requested;              // asked for and not yet added or dropped
+    std::vector<std::uint64_t> m_last_wanted;   // update() each chunk was last in range on
+    std::size_t m_pending = 0;
+    std::uint64_t m_update = 0;
+    std::vector<int> m_wanted;
+    ChunkCallback m_on_loaded;
+    ChunkCallback m_on_unloaded;
+
+    // Shared with the loader thread.
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_finished;
+    std::deque<int> m_requests;
+    std::vector<std::unique_ptr<Chunk>> m_loaded;
+    bool m_stopping = false;
+
+    std::ifstream m_file;               // loader thread only, once started
+    std::thread m_loader;
+
+    void loader_loop();
+    std::unique_ptr<Chunk> read_chunk(int index);
+    // Decodes a chunk's tiles, or fills it with EMPTY and returns false if it is corrupt.
+    bool read_tiles(int index, std::vector<LevelSystem::Tile> &tiles);
+    sf::IntRect get_chunk_area(int index) const;
+    void add_loaded();
+    void evict(std::size_t keep);
+    void build_vertices(Chunk &chunk) const;
+    Chunk *chunk_at(sf::Vector2i pos) const;
+};
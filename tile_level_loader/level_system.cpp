@@ -1,23 +1,45 @@
 #include "level_system.hpp"
+#include "level_streamer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <stdexcept>
 
-std::unique_ptr<LevelSystem::Tile[]> LevelSystem::m_tiles;
+LevelSystem::Tile *LevelSystem::m_tiles = nullptr;
+std::vector<LevelSystem::Tile> LevelSystem::m_tile_storage;
+MappedFile LevelSystem::m_mapped;
 int LevelSystem::m_width;
 int LevelSystem::m_height;
 sf::Vector2f LevelSystem::m_offset(0.0f, 0.0f);
 sf::Vector2f LevelSystem::m_start_position;
+std::unique_ptr<LevelStreamer> LevelSystem::m_streamer;
 
 float LevelSystem::m_tile_size(0.0f);
-std::vector<std::unique_ptr<sf::RectangleShape>> LevelSystem::m_sprites;
+std::vector<LevelSystem::Chunk> LevelSystem::m_chunks;
+int LevelSystem::m_chunks_x = 0;
+int LevelSystem::m_chunks_y = 0;
+int LevelSystem::m_chunks_drawn = 0;
+int LevelSystem::m_chunks_culled = 0;
+const std::int32_t *LevelSystem::m_group_ids = nullptr;
+std::vector<std::int32_t> LevelSystem::m_group_id_storage;
+LevelSystem::TileLists LevelSystem::m_groups;
+bool LevelSystem::m_groups_dirty = true;
+LevelSystem::TileLists LevelSystem::m_types;
+bool LevelSystem::m_types_dirty = true;
+std::vector<sf::Vector2i> LevelSystem::m_streamed_tiles;
+
+static_assert(sizeof(sf::Vector2i) == 2 * sizeof(std::int32_t), "compiled levels store tile positions as two int32s");
 
 std::map<LevelSystem::Tile, sf::Color> LevelSystem::m_colors{
     {WALL, sf::Color::White},
     {END, sf::Color::Red}
 };
 
-int LevelSystem::get_height() { return m_height; }
-int LevelSystem::get_width() { return m_width; }
+int LevelSystem::get_height() { return m_streamer ? m_streamer->get_header().height : m_height; }
+int LevelSystem::get_width() { return m_streamer ? m_streamer->get_header().width : m_width; }
 
 sf::Color LevelSystem::get_color(LevelSystem::Tile t)
 {
@@ -33,16 +55,43 @@ sf::Color LevelSystem::get_color(LevelSystem::Tile t)
 void LevelSystem::set_color(LevelSystem::Tile t, sf::Color c)
 {
     m_colors[t] = c;
+
+    // Any chunk could hold this tile type.
+    for (Chunk &chunk : m_chunks)
+    {
+        chunk.dirty = true;
+    }
+    if (m_streamer)
+    {
+        m_streamer->set_all_dirty();
+    }
 }
 
 void LevelSystem::load_level(const std::string &path, float tile_size)
 {
-    m_tile_size = tile_size;
-    int w = 0, h = 0;
+    const std::string compiled = get_compiled_path(path);
+    if (compiled == path || std::ifstream(compiled).good())
+    {
+        load_compiled_level(compiled, tile_size);
+        return;
+    }
+    load_text_level(path, tile_size);
+}
+
+std::string LevelSystem::get_compiled_path(const std::string &path)
+{
+    const std::size_t dot = path.find_last_of('.');
+    const std::size_t slash = path.find_last_of("/\\");
+    const std::size_t stem = (dot == std::string::npos || (slash != std::string::npos && dot < slash)) ? path.size() : dot;
+    return path.substr(0, stem) + ".lvl";
+}
+
+void LevelSystem::load_text_level(const std::string &path, float tile_size)
+{
     std::string buffer;
 
     // Load file to buffer
-    std::ifstream file(path);
+    std::ifstream file(path, std::ios::binary);
     if(file.good())
     {
         file.seekg(0, std::ios::end);
@@ -56,73 +105,305 @@ void LevelSystem::load_level(const std::string &path, float tile_size)
         throw std::string("Couldn't open level file: " + path);
     }
 
-    int x = 0;
-
-    std::vector<Tile> temp_tiles;
-    for (int i = 0; i < buffer.size(); ++i)
+    // Parsed into locals, so a bad file leaves the last level as it was.
+    // Each tile's position goes into its type's list as it is read.
+    std::vector<Tile> tiles;
+    tiles.reserve(buffer.size());
+    std::vector<sf::Vector2i> by_type[tile_type_count];
+    int w = 0, h = 0, x = 0;
+    sf::Vector2i start(0, 0);
+    for (const char c : buffer)
     {
-        const char c = buffer[i];
-
+        Tile tile;
         switch(c)
         {
             case 'w':
-                temp_tiles.push_back(WALL);
+                tile = WALL;
                 break;
             case 's':
-                temp_tiles.push_back(START);
-                m_start_position = get_tile_pos({x, h});
+                tile = START;
+                start = {x, h};
                 break;
             case 'e':
-                temp_tiles.push_back(END);
+                tile = END;
                 break;
             case ' ':
-                temp_tiles.push_back(EMPTY);
+                tile = EMPTY;
                 break;
             case '+':
-                temp_tiles.push_back(WAYPOINT);
+                tile = WAYPOINT;
                 break;
             case 'n':
-                temp_tiles.push_back(ENEMY);
+                tile = ENEMY;
                 break;
+            case '\r':
+                continue;
             case '\n':
-                if (w == 0) { w = i; } // if width isnt set yet
+                if (h == 0) { w = x; } // the first row sets the width
+                if (x != w)
+                {
+                    throw std::string("Mismatch in level size: " + path);
+                }
                 x = 0;
                 h++;
-                break;
+                continue;
             default:
-                return;
+                throw std::string("Unknown tile '" + std::string(1, c) + "' in level file: " + path);
         }
+        tiles.push_back(tile);
+        by_type[tile].push_back({x, h});
         x++;
     }
+    if (x > 0) // a last row with no newline
+    {
+        if (h == 0) { w = x; }
+        if (x != w)
+        {
+            throw std::string("Mismatch in level size: " + path);
+        }
+        h++;
+    }
 
-    if (temp_tiles.size() != (w * h))
+    if (tiles.size() != static_cast<std::size_t>(w * h) || tiles.empty())
     {
         throw std::string("Mismatch in level size: " + path);
     }
 
-    m_tiles = std::make_unique<Tile[]>(w * h);
-    m_width = w;
-    m_height = h;
+    m_mapped.close();
+    m_tile_storage = std::move(tiles);
+    m_tiles = m_tile_storage.data();
+    m_groups_dirty = true;
+
+    std::vector<std::int32_t> &starts = m_types.owned_starts;
+    std::vector<sf::Vector2i> &type_tiles = m_types.owned_tiles;
+    starts.assign(1, 0);
+    type_tiles.clear();
+    type_tiles.reserve(m_tile_storage.size());
+    for (const std::vector<sf::Vector2i> &list : by_type)
+    {
+        type_tiles.insert(type_tiles.end(), list.begin(), list.end());
+        starts.push_back(static_cast<std::int32_t>(type_tiles.size()));
+    }
+    m_types.use_owned();
+    m_types_dirty = false;
+    set_level(w, h, start, tile_size);
+}
+
+void LevelSystem::load_compiled_level(const std::string &path, float tile_size)
+{
+    MappedFile file(path);
+    const std::uint8_t *data = file.data();
+    CompiledHeader header;
+    if (file.size() < sizeof(header))
+    {
+        throw std::string("Not a compiled level: " + path);
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    const std::uint64_t count = static_cast<std::uint64_t>(header.width) * static_cast<std::uint64_t>(header.height);
+    auto fits = [&](std::uint32_t offset, std::uint64_t bytes)
+    {
+        return offset % 8 == 0 && offset + bytes <= header.size;
+    };
+    if (std::memcmp(header.magic, compiled_magic, sizeof(compiled_magic)) != 0 || header.version != compiled_version ||
+        header.width <= 0 || header.height <= 0 || header.group_count < 0 || header.size != file.size() ||
+        !fits(header.tiles, count * sizeof(Tile)) ||
+        !fits(header.type_starts, (tile_type_count + 1) * sizeof(std::int32_t)) ||
+        !fits(header.type_tiles, count * sizeof(sf::Vector2i)) ||
+        !fits(header.group_ids, count * sizeof(std::int32_t)) ||
+        !fits(header.group_starts, (static_cast<std::uint64_t>(header.group_count) + 1) * sizeof(std::int32_t)) ||
+        !fits(header.group_tiles, count * sizeof(sf::Vector2i)))
+    {
+        throw std::string("Not a compiled level: " + path);
+    }
+
+    // Lookups index with the tiles, list starts and group ids, so those must
+    // hold together: known tiles, starts that split the grid's tiles between
+    // the lists, and ids of groups there are.
+    auto starts_valid = [&](std::uint32_t offset, std::int32_t keys)
+    {
+        const std::int32_t *starts = reinterpret_cast<const std::int32_t *>(data + offset);
+        if (starts[0] != 0 || static_cast<std::uint64_t>(starts[keys]) != count)
+        {
+            return false;
+        }
+        for (std::int32_t k = 0; k < keys; ++k)
+        {
+            if (starts[k] > starts[k + 1])
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+    bool valid = starts_valid(header.type_starts, tile_type_count) && starts_valid(header.group_starts, header.group_count);
+    const std::uint8_t *tiles = data + header.tiles;
+    const std::int32_t *group_ids = reinterpret_cast<const std::int32_t *>(data + header.group_ids);
+    for (std::uint64_t i = 0; valid && i < count; ++i)
+    {
+        valid = tiles[i] < tile_type_count && group_ids[i] >= 0 && group_ids[i] < header.group_count;
+    }
+    if (!valid)
+    {
+        throw std::string("Not a compiled level: " + path);
+    }
+
+    // Everything below points into the mapping, which is copy on write, so set_tile still works.
+    m_mapped = std::move(file);
+    std::uint8_t *mapped = m_mapped.data();
+    m_tile_storage.clear();
+    m_tiles = reinterpret_cast<Tile *>(mapped + header.tiles);
+    m_types.use(reinterpret_cast<const std::int32_t *>(mapped + header.type_starts),
+                reinterpret_cast<const sf::Vector2i *>(mapped + header.type_tiles), tile_type_count);
+    m_groups.use(reinterpret_cast<const std::int32_t *>(mapped + header.group_starts),
+                 reinterpret_cast<const sf::Vector2i *>(mapped + header.group_tiles), header.group_count);
+    m_group_ids = reinterpret_cast<const std::int32_t *>(mapped + header.group_ids);
+    m_group_id_storage.clear();
+    m_groups_dirty = false;
+    m_types_dirty = false;
+    set_level(header.width, header.height, {header.start_x, header.start_y}, tile_size);
+}
+
+void LevelSystem::write_compiled_level(const std::string &path)
+{
+    if (!m_tiles)
+    {
+        throw std::string("No level loaded to compile into: " + path);
+    }
+    if (m_groups_dirty)
+    {
+        build_groups();
+    }
+    if (m_types_dirty)
+    {
+        build_types();
+    }
+
+    const std::size_t count = static_cast<std::size_t>(m_width) * m_height;
+    std::vector<std::uint8_t> bytes(sizeof(CompiledHeader), 0);
+    auto append = [&](const void *data, std::size_t size)
+    {
+        bytes.resize((bytes.size() + 7) / 8 * 8, 0);
+        const std::uint32_t offset = static_cast<std::uint32_t>(bytes.size());
+        bytes.insert(bytes.end(), static_cast<const std::uint8_t *>(data), static_cast<const std::uint8_t *>(data) + size);
+        return offset;
+    };
+
+    CompiledHeader header;
+    std::memcpy(header.magic, compiled_magic, sizeof(header.magic));
+    header.version = compiled_version;
+    header.width = m_width;
+    header.height = m_height;
+    const sf::Vector2i start(m_start_position / m_tile_size);
+    header.start_x = start.x;
+    header.start_y = start.y;
+    header.group_count = m_groups.count;
+    header.tiles = append(m_tiles, count * sizeof(Tile));
+    header.type_starts = append(m_types.starts, (tile_type_count + 1) * sizeof(std::int32_t));
+    header.type_tiles = append(m_types.tiles, count * sizeof(sf::Vector2i));
+    header.group_ids = append(m_group_ids, count * sizeof(std::int32_t));
+    header.group_starts = append(m_groups.starts, (m_groups.count + 1) * sizeof(std::int32_t));
+    header.group_tiles = append(m_groups.tiles, count * sizeof(sf::Vector2i));
+    header.size = static_cast<std::uint32_t>(bytes.size());
+    std::memcpy(bytes.data(), &header, sizeof(header));
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+    if (!file.good())
+    {
+        throw std::string("Couldn't write compiled level: " + path);
+    }
+}
+
+void LevelSystem::set_level(int width, int height, sf::Vector2i start, float tile_size)
+{
+    close_world();
+    m_tile_size = tile_size;
+    m_width = width;
+    m_height = height;
+    m_start_position = get_tile_pos(start);
+    build_chunks();
+}
+
+void LevelSystem::TileLists::use_owned()
+{
+    starts = owned_starts.data();
+    tiles = owned_tiles.data();
+    count = owned_starts.empty() ? 0 : static_cast<int>(owned_starts.size()) - 1;
+}
+
+void LevelSystem::TileLists::use(const std::int32_t *mapped_starts, const sf::Vector2i *mapped_tiles, int mapped_count)
+{
+    owned_starts.clear();
+    owned_tiles.clear();
+    starts = mapped_starts;
+    tiles = mapped_tiles;
+    count = mapped_count;
+}
+
+void LevelSystem::load_world(const std::string &file_path, float tile_size, std::size_t chunk_budget)
+{
+    close_world();
+    m_streamer = std::make_unique<LevelStreamer>(file_path, tile_size, chunk_budget);
+
+    // The whole-level grid is left empty while a world streams.
+    m_tile_size = tile_size;
+    m_tiles = nullptr;
+    m_tile_storage.clear();
+    m_mapped.close();
+    m_width = 0;
+    m_height = 0;
+    m_chunks.clear();
+    m_chunks_x = 0;
+    m_chunks_y = 0;
+    m_groups_dirty = true;
+    m_types_dirty = true;
+
+    const LevelStreamer::Header &header = m_streamer->get_header();
+    m_start_position = get_tile_pos({header.start_x, header.start_y});
+}
+
+void LevelSystem::close_world()
+{
+    m_streamer.reset();
+}
+
+LevelStreamer *LevelSystem::get_streamer() { return m_streamer.get(); }
+
+void LevelSystem::build_chunks()
+{
+    m_chunks_x = (m_width + chunk_size - 1) / chunk_size;
+    m_chunks_y = (m_height + chunk_size - 1) / chunk_size;
 
-    std::copy(temp_tiles.begin(), temp_tiles.end(), &m_tiles[0]);
-    build_sprites();
+    // Vertices are built on first draw, so a level that is never drawn never builds any.
+    m_chunks.clear();
+    m_chunks.resize(m_chunks_x * m_chunks_y);
 }
 
-void LevelSystem::build_sprites()
+void LevelSystem::build_chunk(int chunk_x, int chunk_y)
 {
-    m_sprites.clear();
+    Chunk &chunk = m_chunks[chunk_y * m_chunks_x + chunk_x];
+    chunk.vertices.clear();
+    chunk.dirty = false;
 
-    for (int y = 0; y < LevelSystem::get_height(); ++y)
+    const int end_x = std::min((chunk_x + 1) * chunk_size, m_width);
+    const int end_y = std::min((chunk_y + 1) * chunk_size, m_height);
+
+    for (int y = chunk_y * chunk_size; y < end_y; ++y)
     {
-        for (int x = 0; x < LevelSystem::get_width(); ++x)
+        for (int x = chunk_x * chunk_size; x < end_x; ++x)
         {
-            std::unique_ptr<sf::RectangleShape> sprite = std::make_unique<sf::RectangleShape>();
-            
-            sprite->setPosition(get_tile_pos({x, y}));
-            sprite->setSize(sf::Vector2f(m_tile_size, m_tile_size));
-            sprite->setFillColor(get_color(get_tile({x, y})));
-            
-            m_sprites.push_back(std::move(sprite));
+            const sf::Color color = get_color(get_tile({x, y}));
+            if (color.a == 0)
+            {
+                continue;   // EMPTY and other transparent tiles add nothing
+            }
+
+            const sf::Vector2f pos = get_tile_pos({x, y});
+            chunk.vertices.append(sf::Vertex(pos, color));
+            chunk.vertices.append(sf::Vertex({pos.x + m_tile_size, pos.y}, color));
+            chunk.vertices.append(sf::Vertex({pos.x + m_tile_size, pos.y + m_tile_size}, color));
+            chunk.vertices.append(sf::Vertex({pos.x, pos.y + m_tile_size}, color));
         }
     }
 }
@@ -134,6 +415,10 @@ sf::Vector2f LevelSystem::get_tile_pos(sf::Vector2i pos)
 
 LevelSystem::Tile LevelSystem::get_tile(sf::Vector2i pos)
 {
+    if (m_streamer)
+    {
+        return m_streamer->get_tile(pos);
+    }
     if ((pos.x >= m_width || pos.y >= m_height) || (pos.x < 0 || pos.y < 0))
     {
         return EMPTY;
@@ -143,6 +428,28 @@ LevelSystem::Tile LevelSystem::get_tile(sf::Vector2i pos)
     return tile;
 }
 
+void LevelSystem::set_tile(sf::Vector2i pos, Tile t)
+{
+    if (m_streamer)
+    {
+        m_streamer->set_tile(pos, t);
+        return;
+    }
+    if ((pos.x >= m_width || pos.y >= m_height) || (pos.x < 0 || pos.y < 0))
+    {
+        throw std::out_of_range("Tile position is outside the level.");
+    }
+
+    Tile &tile = m_tiles[(pos.y * m_width) + pos.x];
+    if (tile != t)
+    {
+        tile = t;
+        m_chunks[(pos.y / chunk_size) * m_chunks_x + pos.x / chunk_size].dirty = true;
+        m_groups_dirty = true;
+        m_types_dirty = true;
+    }
+}
+
 LevelSystem::Tile LevelSystem::get_tile_at(sf::Vector2f v)
 {
     auto a = v - m_offset;
@@ -156,142 +463,414 @@ LevelSystem::Tile LevelSystem::get_tile_at(sf::Vector2f v)
 
 void LevelSystem::render(sf::RenderWindow &window)
 {
-    for (int i = 0; i < m_width * m_height; ++i)
+    const sf::View &view = window.getView();
+    const sf::FloatRect bounds(view.getCenter() - view.getSize() / 2.0f, view.getSize());
+
+    std::vector<const sf::VertexArray *> chunks;
+    get_visible_chunks(bounds, chunks);
+    for (const sf::VertexArray *chunk : chunks)
+    {
+        window.draw(*chunk);
+    }
+}
+
+void LevelSystem::get_visible_chunks(const sf::FloatRect &bounds, std::vector<const sf::VertexArray *> &out)
+{
+    out.clear();
+    m_chunks_drawn = 0;
+    m_chunks_culled = 0;
+    if (m_streamer)
+    {
+        m_streamer->get_visible_chunks(bounds, out);
+        m_chunks_drawn = static_cast<int>(out.size());
+        m_chunks_culled = static_cast<int>(m_streamer->get_resident_count()) - m_chunks_drawn;
+        return;
+    }
+    if (m_chunks.empty())
+    {
+        return;
+    }
+
+    // Chunk range under the bounds.
+    const sf::Vector2f top_left = sf::Vector2f(bounds.left, bounds.top) - m_offset;
+    const sf::Vector2f bottom_right = top_left + sf::Vector2f(bounds.width, bounds.height);
+    const float chunk_pixels = m_tile_size * chunk_size;
+
+    const int min_x = std::max(0, static_cast<int>(std::floor(top_left.x / chunk_pixels)));
+    const int min_y = std::max(0, static_cast<int>(std::floor(top_left.y / chunk_pixels)));
+    const int max_x = std::min(m_chunks_x - 1, static_cast<int>(std::floor(bottom_right.x / chunk_pixels)));
+    const int max_y = std::min(m_chunks_y - 1, static_cast<int>(std::floor(bottom_right.y / chunk_pixels)));
+
+    for (int y = min_y; y <= max_y; ++y)
     {
-        window.draw(*m_sprites[i]);
+        for (int x = min_x; x <= max_x; ++x)
+        {
+            Chunk &chunk = m_chunks[y * m_chunks_x + x];
+            if (chunk.dirty)
+            {
+                build_chunk(x, y);
+            }
+            if (chunk.vertices.getVertexCount() > 0)
+            {
+                out.push_back(&chunk.vertices);
+                ++m_chunks_drawn;
+            }
+        }
     }
+
+    m_chunks_culled = static_cast<int>(m_chunks.size()) - m_chunks_drawn;
 }
 
+int LevelSystem::get_chunks_drawn() { return m_chunks_drawn; }
+int LevelSystem::get_chunks_culled() { return m_chunks_culled; }
+
 sf::Vector2f LevelSystem::get_start_pos() { return m_start_position; }
 
-std::vector<sf::Vector2i> LevelSystem::find_tiles(LevelSystem::Tile type)
+LevelSystem::TileSpan LevelSystem::find_tiles(LevelSystem::Tile type)
 {
-    auto v = std::vector<sf::Vector2i>();
-    for (int i = 0; i < m_width * m_height; ++i)
+    if (m_streamer)
+    {
+        m_streamed_tiles.clear();
+        m_streamer->find_tiles(type, m_streamed_tiles);
+        return {m_streamed_tiles.data(), m_streamed_tiles.data() + m_streamed_tiles.size()};
+    }
+
+    if (m_types_dirty)
+    {
+        build_types();
+    }
+    if (m_types.count == 0)
     {
-        if (m_tiles[i] == type)
+        return {};
+    }
+    return {m_types.tiles + m_types.starts[type], m_types.tiles + m_types.starts[type + 1]};
+}
+
+LevelSystem::TileSpan LevelSystem::get_tiles_list(Tile type)
+{
+    return find_tiles(type);
+}
+
+std::vector<LevelSystem::TileSpan> LevelSystem::get_groups(Tile type)
+{
+    if (m_groups_dirty)
+    {
+        build_groups();
+    }
+
+    std::vector<TileSpan> groups;
+    for (int g = 0; g < m_groups.count; ++g)
+    {
+        const sf::Vector2i *first = m_groups.tiles + m_groups.starts[g];
+        if (get_tile(*first) == type)
         {
-            v.push_back({i % m_width, i / m_width});
+            groups.push_back({first, m_groups.tiles + m_groups.starts[g + 1]});
         }
     }
+    return groups;
+}
 
-    return v;
+int LevelSystem::get_group_id(sf::Vector2i pos)
+{
+    if ((pos.x >= m_width || pos.y >= m_height) || (pos.x < 0 || pos.y < 0))
+    {
+        return -1;
+    }
+    if (m_groups_dirty)
+    {
+        build_groups();
+    }
+    return m_group_ids[pos.y * m_width + pos.x];
+}
+
+int LevelSystem::get_group_count()
+{
+    if (m_groups_dirty)
+    {
+        build_groups();
+    }
+    return m_groups.count;
 }
 
-std::vector<sf::Vector2i> LevelSystem::get_tiles_list(Tile type)
+void LevelSystem::build_groups()
 {
-    std::vector<sf::Vector2i> list;
+    const int count = m_width * m_height;
+    std::vector<std::int32_t> &ids = m_group_id_storage;
+    ids.assign(count, -1);
+    m_groups_dirty = false;
+
+    // First pass: give each tile the label of a same type tile left of or
+    // above it, joining the two labels when both match, or a new label.
+    std::vector<int> parents;
+    auto find = [&](int label)
+    {
+        while (parents[label] != label)
+        {
+            parents[label] = parents[parents[label]];
+            label = parents[label];
+        }
+        return label;
+    };
 
     for (int y = 0; y < m_height; ++y)
     {
         for (int x = 0; x < m_width; ++x)
         {
-            Tile t = get_tile({x, y});
-            if (t != type)
+            const int i = y * m_width + x;
+            const bool left = x > 0 && m_tiles[i - 1] == m_tiles[i];
+            const bool up = y > 0 && m_tiles[i - m_width] == m_tiles[i];
+
+            if (left && up)
             {
-                continue;
+                const int a = find(ids[i - 1]);
+                const int b = find(ids[i - m_width]);
+                parents[std::max(a, b)] = std::min(a, b);
+                ids[i] = std::min(a, b);
+            }
+            else if (left)
+            {
+                ids[i] = ids[i - 1];
+            }
+            else if (up)
+            {
+                ids[i] = ids[i - m_width];
+            }
+            else
+            {
+                ids[i] = static_cast<int>(parents.size());
+                parents.push_back(ids[i]);
             }
-            list.push_back({x, y});
         }
     }
-    return list;
+
+    // Second pass: number the joined labels in the order they are first met.
+    std::vector<int> numbers(parents.size(), -1);
+    int groups = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        int &number = numbers[find(ids[i])];
+        if (number < 0)
+        {
+            number = groups++;
+        }
+        ids[i] = number;
+    }
+
+    // Lay each group's tiles out together, keeping row order within a group.
+    std::vector<std::int32_t> &starts = m_groups.owned_starts;
+    starts.assign(groups + 1, 0);
+    for (int i = 0; i < count; ++i)
+    {
+        ++starts[ids[i] + 1];
+    }
+    for (int g = 0; g < groups; ++g)
+    {
+        starts[g + 1] += starts[g];
+    }
+
+    m_groups.owned_tiles.resize(count);
+    std::vector<std::int32_t> next(starts.begin(), starts.end() - 1);
+    for (int i = 0; i < count; ++i)
+    {
+        m_groups.owned_tiles[next[ids[i]]++] = {i % m_width, i / m_width};
+    }
+
+    m_groups.use_owned();
+    m_group_ids = ids.data();
 }
 
-std::vector<std::vector<sf::Vector2i>> LevelSystem::get_groups(Tile type)
+void LevelSystem::build_types()
 {
-    std::vector<std::vector<sf::Vector2i>> groups;
-    std::vector<sf::Vector2i> tile_list = find_tiles(type);
+    const int count = m_width * m_height;
+    m_types_dirty = false;
 
-    while (!tile_list.empty())
+    // Counted, then laid out by type, each type's tiles in row order.
+    std::vector<std::int32_t> &starts = m_types.owned_starts;
+    starts.assign(tile_type_count + 1, 0);
+    for (int i = 0; i < count; ++i)
     {
-        std::vector<sf::Vector2i> group;
+        ++starts[m_tiles[i] + 1];
+    }
+    for (int t = 0; t < tile_type_count; ++t)
+    {
+        starts[t + 1] += starts[t];
+    }
 
-        if (tile_list.size() == 1)
+    m_types.owned_tiles.resize(count);
+    std::vector<std::int32_t> next(starts.begin(), starts.end() - 1);
+    for (int i = 0; i < count; ++i)
+    {
+        m_types.owned_tiles[next[m_tiles[i]]++] = {i % m_width, i / m_width};
+    }
+
+    m_types.use_owned();
+}
+
+std::vector<std::vector<sf::Vector2i>> LevelSystem::get_outlines(Tile type)
+{
+    if (!m_tiles)
+    {
+        return {};
+    }
+    return trace_outlines(m_tiles, m_width, m_height, type);
+}
+
+std::vector<std::vector<sf::Vector2i>> LevelSystem::trace_outlines(const Tile *tiles, int width, int height, Tile type)
+{
+    return walk_outlines(tiles, width, height, type, false);
+}
+
+std::vector<LevelSystem::Chain> LevelSystem::trace_chains(const Tile *tiles, int width, int height, Tile type, const sf::IntRect &owned)
+{
+    std::vector<Chain> chains;
+    std::vector<bool> owned_edges;
+    for (const std::vector<sf::Vector2i> &outline : walk_outlines(tiles, width, height, type, true))
+    {
+        // Edge i runs from corner i to the next, with its tile on its left.
+        const int count = static_cast<int>(outline.size());
+        owned_edges.assign(count, false);
+        bool any_owned = false;
+        bool all_owned = true;
+        for (int i = 0; i < count; ++i)
         {
-            group.push_back(tile_list[0]);
+            const sf::Vector2i from = outline[i];
+            const sf::Vector2i step = outline[(i + 1) % count] - from;
+            const sf::Vector2i tile = step.x > 0 ? sf::Vector2i(from.x, from.y - 1)
+                                    : step.x < 0 ? sf::Vector2i(from.x - 1, from.y)
+                                    : step.y > 0 ? from
+                                                 : sf::Vector2i(from.x - 1, from.y - 1);
+            owned_edges[i] = owned.contains(tile);
+            any_owned = any_owned || owned_edges[i];
+            all_owned = all_owned && owned_edges[i];
         }
-        else
+
+        // Whether the outline turns at corner i; only those corners are kept.
+        auto turns = [&](int i)
         {
-            m_get_group(type, tile_list.front(), tile_list, group, true);
-        }
+            const sf::Vector2i corner = outline[i];
+            return corner - outline[(i + count - 1) % count] != outline[(i + 1) % count] - corner;
+        };
 
-        groups.push_back(group);
+        if (!any_owned)
+        {
+            continue;
+        }
+        if (all_owned)
+        {
+            Chain chain{{}, true};
+            for (int i = 0; i < count; ++i)
+            {
+                if (turns(i))
+                {
+                    chain.points.push_back(outline[i]);
+                }
+            }
+            chains.push_back(std::move(chain));
+            continue;
+        }
 
-        for (sf::Vector2i pos : group)
+        // Each run of owned edges becomes a chain, between the corners either side of it.
+        for (int i = 0; i < count; ++i)
         {
-            int i = 0;
-            for (; i < tile_list.size(); ++i)
+            if (!owned_edges[i] || owned_edges[(i + count - 1) % count])
             {
-                if (tile_list[i] == pos) { break; }
+                continue;
             }
-            if (i < tile_list.size()) {
-                tile_list.erase(tile_list.begin() + i);
+
+            Chain chain{{outline[(i + count - 1) % count], outline[i]}, false};
+            int end = i;
+            while (owned_edges[end])
+            {
+                end = (end + 1) % count;
+                if (owned_edges[end] && turns(end))
+                {
+                    chain.points.push_back(outline[end]);
+                }
             }
+            chain.points.push_back(outline[end]);
+            chain.points.push_back(outline[(end + 1) % count]);
+            chains.push_back(std::move(chain));
         }
     }
-    return groups;
+    return chains;
 }
 
-void LevelSystem::m_get_group(Tile type, const sf::Vector2i &pos, const std::vector<sf::Vector2i> &tile_list, std::vector<sf::Vector2i> &group, bool vert)
+std::vector<std::vector<sf::Vector2i>> LevelSystem::walk_outlines(const Tile *tiles, int width, int height, Tile type, bool every_corner)
 {
-    if (in_group(pos, group)) { return; }
+    // Directions on screen, anticlockwise from right.
+    enum { RIGHT, UP, LEFT, DOWN };
+    static const sf::Vector2i steps[4] = {{1, 0}, {0, -1}, {-1, 0}, {0, 1}};
 
-    group.push_back(pos);
-
-    std::vector<Tile> neighbours = 
+    const int corners_x = width + 1;
+    const int corners_y = height + 1;
+    auto is_type = [&](int x, int y)
     {
-        in_group({pos.x-1,pos.y-1},tile_list) ? get_tile({pos.x-1,pos.y-1}) : EMPTY,
-        in_group({pos.x,pos.y-1},tile_list) ? get_tile({pos.x,pos.y-1}) : EMPTY,
-        in_group({pos.x+1,pos.y-1},tile_list) ? get_tile({pos.x+1,pos.y-1}) : EMPTY,
-        in_group({pos.x+1,pos.y},tile_list) ? get_tile({pos.x+1,pos.y}) : EMPTY,
-        in_group({pos.x+1,pos.y+1},tile_list) ? get_tile({pos.x+1,pos.y+1}) : EMPTY,
-        in_group({pos.x,pos.y+1},tile_list) ? get_tile({pos.x,pos.y+1}) : EMPTY,
-        in_group({pos.x-1,pos.y+1},tile_list) ? get_tile({pos.x-1,pos.y+1}) : EMPTY,
-        in_group({pos.x-1,pos.y},tile_list) ? get_tile({pos.x-1,pos.y}) : EMPTY
+        return x >= 0 && y >= 0 && x < width && y < height && tiles[y * width + x] == type;
     };
 
-    if (neighbours[3] == type)
+    // Each edge between a type tile and any other tile, as a bit for the
+    // direction it leaves its start corner in, walked with the tile on its left.
+    std::vector<std::uint8_t> edges(corners_x * corners_y, 0);
+    for (int y = 0; y < height; ++y)
     {
-        // look right
-        m_get_group(type, {pos.x + 1, pos.y}, tile_list, group,
-            neighbours[3] == neighbours[4] &&
-            neighbours[7] == neighbours[6] && 
-            neighbours[3] == neighbours[2] && 
-            neighbours[7] == neighbours[0]
-        );
+        for (int x = 0; x < width; ++x)
+        {
+            if (!is_type(x, y)) { continue; }
+            if (!is_type(x, y - 1)) { edges[y * corners_x + x + 1] |= 1 << LEFT; }
+            if (!is_type(x - 1, y)) { edges[y * corners_x + x] |= 1 << DOWN; }
+            if (!is_type(x, y + 1)) { edges[(y + 1) * corners_x + x] |= 1 << RIGHT; }
+            if (!is_type(x + 1, y)) { edges[(y + 1) * corners_x + x + 1] |= 1 << UP; }
+        }
     }
 
-    if (neighbours[7] == type)
+    // The edge leaving a corner after arriving in a direction. Only corners
+    // where two tiles touch diagonally have two, and turning left there
+    // keeps each tile's corner to its own outline.
+    auto next_direction = [&](int corner, int arrived)
     {
-        // look left
-        m_get_group(type, {pos.x - 1, pos.y}, tile_list, group,
-            neighbours[3] == neighbours[4] &&
-            neighbours[7] == neighbours[6] && 
-            neighbours[3] == neighbours[2] && 
-            neighbours[7] == neighbours[0]
-        );
-    }
-    if (!vert) { return; }
+        const std::uint8_t leaving = edges[corner];
+        for (int turn : {1, 0, 3})
+        {
+            const int direction = (arrived + turn) % 4;
+            if (leaving & (1 << direction)) { return direction; }
+        }
+        return arrived;
+    };
 
-    if(neighbours[3] == neighbours[4] && neighbours[7] == neighbours[6] && neighbours[5] == type)
+    std::vector<std::vector<sf::Vector2i>> outlines;
+    std::vector<std::uint8_t> walked(edges.size(), 0);
+    for (int start = 0; start < static_cast<int>(edges.size()); ++start)
     {
-        //look down
-        m_get_group(type,{pos.x,pos.y+1},tile_list,group,true);
-    }
+        for (int first = 0; first < 4; ++first)
+        {
+            if (!(edges[start] & ~walked[start] & (1 << first))) { continue; }
 
-    if(neighbours[3] == neighbours[2] && neighbours[7] == neighbours[0] && neighbours[1] == type)
-    {
-        //look up
-        m_get_group(type,{pos.x,pos.y-1},tile_list,group,true);
-    }
-}
+            std::vector<sf::Vector2i> outline;
+            const sf::Vector2i start_pos(start % corners_x, start / corners_x);
+            walked[start] |= 1 << first;
+            sf::Vector2i pos = start_pos + steps[first];
+            int direction = first;
 
-bool LevelSystem::in_group(const sf::Vector2i &pos, const std::vector<sf::Vector2i> &group)
-{
-    for (const sf::Vector2i &p : group)
-    {
-        if (p == pos) { return true; }
-        return false;
+            while (true)
+            {
+                const int corner = pos.y * corners_x + pos.x;
+                const int next = next_direction(corner, direction);
+                if (every_corner || next != direction)
+                {
+                    outline.push_back(pos);
+                }
+                if (corner == start && next == first)
+                {
+                    break;
+                }
+
+                walked[corner] |= 1 << next;
+                pos += steps[next];
+                direction = next;
+            }
+
+            outlines.push_back(std::move(outline));
+        }
     }
-    return false;
-}
\ No newline at end of file
+    return outlines;
+}
@@ -1,19 +1,28 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 #include <map>
 #include <set>
+#include "mapped_file.hpp"
+
+class LevelStreamer;
 
 // LevelSystem
 // Handles the creation of levels by taking in a level .txt file
 // and generating an SFML chain representative of such level.
+//
+// Levels can also be compiled ahead of time into a binary file holding
+// the tile bytes, the tiles of each type, the tile groups and the start,
+// which is mapped into memory and used in place with nothing to parse.
 class LevelSystem
 {
 public:
-    enum Tile
+    // One byte a tile, so compiled levels can be used in place.
+    enum Tile : std::uint8_t
     {
         EMPTY,
         START,
@@ -22,31 +31,183 @@ public:
         ENEMY,
         WAYPOINT
     };
+    static constexpr int tile_type_count = WAYPOINT + 1;
+
+    // Tiles per side of a render chunk.
+    static constexpr int chunk_size = 16;
+
+    // A run of tile positions owned by the level system, valid until the
+    // tiles change or another level loads.
+    struct TileSpan
+    {
+        const sf::Vector2i *first = nullptr;
+        const sf::Vector2i *last = nullptr;
+
+        const sf::Vector2i *begin() const { return first; }
+        const sf::Vector2i *end() const { return last; }
+        std::size_t size() const { return static_cast<std::size_t>(last - first); }
+        bool empty() const { return first == last; }
+        const sf::Vector2i &operator[](std::size_t i) const { return first[i]; }
+    };
 
+    // Corners of an outline, or of the part of one a chunk owns. A loop
+    // closes on itself. An open chain's first and last corners are ghosts,
+    // the outline's corners either side of the part, which are not collided
+    // with but keep things sliding across its ends from catching on them.
+    struct Chain
+    {
+        std::vector<sf::Vector2i> points;
+        bool loop;
+    };
+
+    // Loads a level, mapping the compiled copy beside a text level, with
+    // the same name and a .lvl extension, where there is one.
     static void load_level(const std::string &file_path, float tile_size);
+    // Parses a text level. Throws a std::string, leaving the last level
+    // loaded, if it can't be read, has an unknown tile or rows of
+    // different lengths.
+    static void load_text_level(const std::string &file_path, float tile_size);
+    // Maps a compiled level. Throws a std::string, leaving the last level
+    // loaded, if it can't be mapped, isn't a compiled level or its tiles,
+    // list starts or group ids are out of range.
+    static void load_compiled_level(const std::string &file_path, float tile_size);
+    // Compiles the level loaded into a file for load_compiled_level.
+    static void write_compiled_level(const std::string &file_path);
+    // The path a text level's compiled copy has.
+    static std::string get_compiled_path(const std::string &file_path);
+    // Streams a world file around the camera instead, keeping at most
+    // chunk_budget of its chunks in memory. Tile, size, start and chunk
+    // queries answer from the world until the next load; outlines and
+    // groups are only found for whole levels.
+    static void load_world(const std::string &file_path, float tile_size, std::size_t chunk_budget);
+    static void close_world();
+    // The world being streamed, or nullptr for a whole level.
+    static LevelStreamer *get_streamer();
+    // Draws the chunks the window's view overlaps.
     static void render(sf::RenderWindow &win);
+    // Collects the chunks that overlap bounds, building any that changed.
+    static void get_visible_chunks(const sf::FloatRect &bounds, std::vector<const sf::VertexArray *> &out);
+    // Chunks drawn and skipped by the last render or get_visible_chunks.
+    static int get_chunks_drawn();
+    static int get_chunks_culled();
     static sf::Color get_color(Tile t);
     static void set_color(Tile t, sf::Color c);
     static Tile get_tile(sf::Vector2i pos);
+    static void set_tile(sf::Vector2i pos, Tile t);
     static sf::Vector2f get_tile_pos(sf::Vector2i pos);
     static Tile get_tile_at(sf::Vector2f pos);
     static int get_height();
     static int get_width();
     static sf::Vector2f get_start_pos();
-    static std::vector<sf::Vector2i> find_tiles(Tile t);
-    static std::vector<sf::Vector2i> get_tiles_list(Tile type);
-    static std::vector<std::vector<sf::Vector2i>> get_groups(Tile type);
-    static bool in_group(const sf::Vector2i &pos, const std::vector<sf::Vector2i> &group);
+    // The tiles of type t in row order, from lists made as the level loads.
+    // While a world streams, the resident tiles, found when asked.
+    static TileSpan find_tiles(Tile t);
+    static TileSpan get_tiles_list(Tile type);
+    // Tiles of type joined edge to edge, one list per group, each in row order.
+    static std::vector<TileSpan> get_groups(Tile type);
+    // Which group the tile at pos is in, counting groups of every type in
+    // the order their first tiles come row by row; -1 outside the level.
+    static int get_group_id(sf::Vector2i pos);
+    static int get_group_count();
+    // Outlines of the regions of type tiles, as closed loops of tile corners
+    // (corner x, y is the top left of tile x, y), found in one pass over the
+    // grid. Each loop keeps its tiles on its left as seen on screen, so outer
+    // edges run anticlockwise and the edges of holes clockwise. Only corners
+    // where the outline turns are kept, and the first corner is not repeated.
+    static std::vector<std::vector<sf::Vector2i>> get_outlines(Tile type);
+    // get_outlines for any grid of width x height tiles, row by row.
+    static std::vector<std::vector<sf::Vector2i>> trace_outlines(const Tile *tiles, int width, int height, Tile type);
+    // trace_outlines, keeping only the edges of the tiles in owned. An
+    // outline wholly in owned is a loop; one that crosses its border is cut
+    // there into open chains, so the grid can hold a ring of neighbouring
+    // tiles around owned and neighbours' chains meet without a seam.
+    static std::vector<Chain> trace_chains(const Tile *tiles, int width, int height, Tile type, const sf::IntRect &owned);
 
 protected:
-    static std::unique_ptr<Tile[]> m_tiles;
+    // Outlines as trace_outlines finds them, or with every corner along
+    // them when every_corner is set.
+    static std::vector<std::vector<sf::Vector2i>> walk_outlines(const Tile *tiles, int width, int height, Tile type, bool every_corner);
+
+    // Lists of tile positions by key, CSR style: key k's tiles are
+    // tiles[starts[k]] up to tiles[starts[k + 1]]. They point either into
+    // the owned vectors or into a mapped compiled level.
+    struct TileLists
+    {
+        const std::int32_t *starts = nullptr;
+        const sf::Vector2i *tiles = nullptr;
+        int count = 0;
+        std::vector<std::int32_t> owned_starts;
+        std::vector<sf::Vector2i> owned_tiles;
+
+        void use_owned();
+        void use(const std::int32_t *mapped_starts, const sf::Vector2i *mapped_tiles, int mapped_count);
+    };
+
+    // The compiled level layout. Offsets are from the start of the file,
+    // each section 8 byte aligned, everything in the writer's byte order.
+    struct CompiledHeader
+    {
+        char magic[4];
+        std::uint32_t version;
+        std::int32_t width;
+        std::int32_t height;
+        std::int32_t start_x;
+        std::int32_t start_y;
+        std::int32_t group_count;
+        std::uint32_t tiles;            // width * height Tiles
+        std::uint32_t type_starts;      // tile_type_count + 1 int32s
+        std::uint32_t type_tiles;       // width * height Vector2is, grouped by type
+        std::uint32_t group_ids;        // width * height int32s
+        std::uint32_t group_starts;     // group_count + 1 int32s
+        std::uint32_t group_tiles;      // width * height Vector2is, grouped by group
+        std::uint32_t size;             // of the whole file
+    };
+    static constexpr char compiled_magic[4] = {'C', 'Z', 'L', 'V'};
+    static constexpr std::uint32_t compiled_version = 1;
+
+    // m_tile_storage for a text level, or the mapped compiled level.
+    static Tile *m_tiles;
+    static std::vector<Tile> m_tile_storage;
+    static MappedFile m_mapped;
     static int m_width;
     static int m_height;
     static sf::Vector2f m_offset;
     static float m_tile_size;
     static std::map<Tile, sf::Color> m_colors;
     static sf::Vector2f m_start_position;
-    static std::vector<std::unique_ptr<sf::RectangleShape>> m_sprites;
-    static void build_sprites();
-    static void m_get_group(Tile type, const sf::Vector2i &pos, const std::vector<sf::Vector2i> &tile_list, std::vector<sf::Vector2i> &group, bool vert);
+    static std::unique_ptr<LevelStreamer> m_streamer;
+
+    // The tile layer is drawn in chunks of chunk_size x chunk_size tiles.
+    // Each chunk is one quad batch of its visible tiles, rebuilt only after
+    // one of its tiles, or a tile colour, changes.
+    struct Chunk
+    {
+        sf::VertexArray vertices{sf::Quads};
+        bool dirty = true;
+    };
+    static std::vector<Chunk> m_chunks;
+    static int m_chunks_x;
+    static int m_chunks_y;
+    static int m_chunks_drawn;
+    static int m_chunks_culled;
+    static void build_chunks();
+    static void build_chunk(int chunk_x, int chunk_y);
+
+    // Connected groups of same type tiles, labelled in one pass over the
+    // grid and rebuilt on first use after the tiles change.
+    static const std::int32_t *m_group_ids;
+    static std::vector<std::int32_t> m_group_id_storage;
+    static TileLists m_groups;
+    static bool m_groups_dirty;
+    static void build_groups();
+
+    // Each tile type's tiles in row order, made while a text level parses
+    // and rebuilt on first use after the tiles change.
+    static TileLists m_types;
+    static bool m_types_dirty;
+    static void build_types();
+    // What find_tiles found last in a streaming world.
+    static std::vector<sf::Vector2i> m_streamed_tiles;
+
+    static void set_level(int width, int height, sf::Vector2i start, float tile_size);
 };
\ No newline at end of file
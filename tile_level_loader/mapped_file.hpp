@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// MappedFile
+// A whole file mapped into memory, so its bytes are read in by the OS on
+// first touch instead of copied through a stream. The mapping is private:
+// writes go to copies of the pages written and never reach the file.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    // Throws a std::string if the file can't be opened or mapped.
+    explicit MappedFile(const std::string &file_path);
+    ~MappedFile();
+
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    std::uint8_t *data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+    bool is_open() const { return m_data != nullptr; }
+
+    // Unmaps the file, if one is mapped.
+    void close();
+
+private:
+    std::uint8_t *m_data = nullptr;
+    std::size_t m_size = 0;
+#ifdef _WIN32
+    void *m_file = nullptr;
+    void *m_mapping = nullptr;
+#endif
+};
@@ -0,0 +1,39 @@
+// Level compiler.
+// Compiles a text level into the binary file LevelSystem::load_level maps
+// in place of it. The build runs this over resources/levels.
+//
+// Usage: level_compiler LEVEL.txt [LEVEL.lvl]
+
+#include "level_system.hpp"
+#include <iostream>
+#include <string>
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " LEVEL.txt [LEVEL.lvl]\n";
+        return 2;
+    }
+
+    const std::string input = argv[1];
+    const std::string output = argc == 3 ? argv[2] : LevelSystem::get_compiled_path(input);
+    if (output == input)
+    {
+        std::cerr << "Would overwrite the level with its compiled copy: " << input << "\n";
+        return 2;
+    }
+
+    try
+    {
+        // Tile size only scales positions in pixels, which aren't stored.
+        LevelSystem::load_text_level(input, 1.0f);
+        LevelSystem::write_compiled_level(output);
+    }
+    catch (const std::string &error)
+    {
+        std::cerr << error << "\n";
+        return 1;
+    }
+    return 0;
+}